@@ -0,0 +1,518 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Generates a sample of random strings for the profiles, one per line, with
+ * lengths drawn from a distribution. The output depends only on the
+ * arguments and the seed, except that the zipf, lognormal and bimodal
+ * distributions and token mode use pow, exp, log and cos, whose results can
+ * differ in the last bit between C libraries; their samples are reproduced
+ * only with the same libm. In token mode, a vocabulary of random strings is
+ * generated first, and the sample draws its strings from the vocabulary with
+ * Zipf distributed frequencies, for deduplication and interning benchmarks.
+ * Short lengths can give the vocabulary duplicates. */
+
+/* The characters the strings are made of */
+#define CHARS       "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ" \
+                    "0123456789"
+#define CHAR_COUNT  62
+
+/* The default seed, and the default skew of the token frequencies */
+#define DEFAULT_SEED    1
+#define DEFAULT_SKEW    1.0
+
+/* The longest string length, and the largest vocabulary */
+#define MAX_LENGTH      (1L << 24)
+#define MAX_VOCABULARY  (1L << 24)
+
+/* The longest line of a histogram file */
+#define HISTOGRAM_LINE  256
+
+/* The length distributions */
+enum distribution {
+    IDENTICAL,      /* length */
+    UNIFORM,        /* lower, upper (inclusive) */
+    BINOMIAL,       /* trials, probability */
+    ZIPF,           /* maximum length, exponent */
+    LOGNORMAL,      /* mu, sigma of the logarithm of the length */
+    BIMODAL,        /* mean, deviation of each mode, weight of the first */
+    EMPIRICAL       /* a histogram file of length/weight pairs */
+};
+
+/* A distribution with its parameters. Discrete distributions given by a
+ * table (zipf and empirical) keep a cumulative distribution over the
+ * lengths first to first + count - 1. */
+struct length_distribution {
+    enum distribution type;
+    double params[5];
+    double *cdf;
+    int first;
+    int count;
+};
+
+/* The state of the generator (splitmix64) */
+static unsigned long long state = DEFAULT_SEED;
+
+/* Returns the next 64 random bits */
+static unsigned long long next_bits(void);
+
+/* Returns a random double, uniform in [0, 1) */
+static double next_uniform(void);
+
+/* Returns a random double with the standard normal distribution */
+static double next_normal(void);
+
+/* Returns a random integer, uniform in [0, count) */
+static unsigned long next_below(unsigned long count);
+
+/* Builds a cumulative distribution from count weights, in place. Returns
+ * zero if the weights don't sum to a positive value. */
+static int make_cdf(double *weights, int count);
+
+/* Returns the index drawn from a cumulative distribution of count values */
+static int sample_cdf(double const *cdf, int count);
+
+/* Parses the distribution named by argv[0] and its parameters. Returns zero
+ * if the distribution or its parameters are invalid. */
+static int parse_distribution(
+        struct length_distribution *distribution,
+        int argc,
+        char **argv);
+
+/* Reads a histogram file into a table distribution. Returns zero on
+ * failure. */
+static int read_histogram(
+        struct length_distribution *distribution,
+        char const *filename);
+
+/* Draws a length from a distribution */
+static long sample_length(struct length_distribution const *distribution);
+
+/* Writes a random string of the given length to buf */
+static void random_string(char *buf, long length);
+
+/* Writes count strings with lengths drawn from the distribution to file */
+static int write_strings(
+        FILE *file,
+        struct length_distribution const *distribution,
+        long count);
+
+/* Writes count strings drawn from a vocabulary of the given number of
+ * random strings, with lengths drawn from the distribution, to file. The
+ * kth string of the vocabulary is drawn with weight 1/k^skew. */
+static int write_tokens(
+        FILE *file,
+        struct length_distribution const *distribution,
+        long count,
+        long vocabulary,
+        double skew);
+
+/* Generates a vocabulary of random strings, each followed by a newline, with
+ * lengths drawn from the distribution. Writes the offset of each string, and
+ * the total size, to offsets. Returns the strings, or NULL on failure. */
+static char *make_vocabulary(
+        struct length_distribution const *distribution,
+        long vocabulary,
+        size_t *offsets);
+
+/* Prints the usage to stderr. Takes as an argument the executable name. */
+static void print_usage(char const *name);
+
+int main(int argc, char **argv)
+{
+    struct length_distribution distribution;
+    unsigned long long seed = DEFAULT_SEED;
+    long count = 0, vocabulary = 0;
+    double skew = DEFAULT_SKEW;
+    int option = 0, ok = 0;
+
+    while ((option = getopt(argc, argv, "s:t:z:")) != -1) {
+        switch (option) {
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 't':
+            vocabulary = atol(optarg);
+            break;
+        case 'z':
+            skew = atof(optarg);
+            break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - optind < 2
+            || (count = atol(argv[optind])) <= 0
+            || vocabulary < 0
+            || vocabulary > MAX_VOCABULARY
+            || !parse_distribution(&distribution, argc - optind - 1,
+                argv + optind + 1)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    state = seed;
+    ok = vocabulary > 0
+        ? write_tokens(stdout, &distribution, count, vocabulary, skew)
+        : write_strings(stdout, &distribution, count);
+
+    free(distribution.cdf);
+    return !(ok && fflush(stdout) == 0);
+}
+
+unsigned long long next_bits(void)
+{
+    unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+double next_uniform(void)
+{
+    return (double)(next_bits() >> 11) / 9007199254740992.;
+}
+
+/* The Box-Muller transform, using one of the pair of values it gives */
+double next_normal(void)
+{
+    double const pi = 3.14159265358979323846;
+    double const u = 1. - next_uniform();
+
+    return sqrt(-2. * log(u)) * cos(2. * pi * next_uniform());
+}
+
+unsigned long next_below(unsigned long count)
+{
+    return (unsigned long)(next_uniform() * (double)count);
+}
+
+int make_cdf(double *weights, int count)
+{
+    double sum = 0.;
+    int i = 0;
+
+    for (i = 0; i < count; ++i) {
+        if (weights[i] < 0.) {
+            return 0;
+        }
+
+        sum += weights[i];
+        weights[i] = sum;
+    }
+
+    if (sum <= 0.) {
+        return 0;
+    }
+
+    for (i = 0; i < count; ++i) {
+        weights[i] /= sum;
+    }
+
+    return 1;
+}
+
+int sample_cdf(double const *cdf, int count)
+{
+    double const u = next_uniform();
+    int low = 0, high = count - 1, middle = 0;
+
+    /* Find the first value whose cumulative probability exceeds u */
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (cdf[middle] > u) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    return low;
+}
+
+int parse_distribution(
+        struct length_distribution *distribution,
+        int argc,
+        char **argv)
+{
+    static char const *const names[] = {
+        "identical", "uniform", "binomial", "zipf", "lognormal", "bimodal",
+        "empirical"
+    };
+    static int const param_counts[] = {1, 2, 2, 2, 2, 5, 1};
+    double *p = distribution->params;
+    int i = 0, type = 0;
+
+    memset(distribution, 0, sizeof(*distribution));
+    distribution->cdf = NULL;
+
+    for (type = 0; type <= EMPIRICAL; ++type) {
+        if (strcmp(argv[0], names[type]) == 0) {
+            break;
+        }
+    }
+
+    if (type > EMPIRICAL || argc != param_counts[type] + 1) {
+        return 0;
+    }
+
+    distribution->type = (enum distribution)type;
+    if (distribution->type == EMPIRICAL) {
+        return read_histogram(distribution, argv[1]);
+    }
+
+    for (i = 0; i < param_counts[type]; ++i) {
+        p[i] = atof(argv[i + 1]);
+    }
+
+    switch (distribution->type) {
+    case IDENTICAL:
+        return p[0] >= 0. && p[0] <= MAX_LENGTH;
+    case UNIFORM:
+        return p[0] >= 0. && p[1] >= p[0] && p[1] <= MAX_LENGTH;
+    case BINOMIAL:
+        return p[0] >= 0. && p[0] <= MAX_LENGTH && p[1] >= 0. && p[1] <= 1.;
+    case ZIPF:
+        if (p[0] < 1. || p[0] > MAX_LENGTH) {
+            return 0;
+        }
+
+        /* Lengths 1 to n, with weights 1/length^s */
+        distribution->first = 1;
+        distribution->count = (int)p[0];
+        distribution->cdf = malloc((size_t)distribution->count
+                * sizeof(*distribution->cdf));
+        if (!distribution->cdf) {
+            return 0;
+        }
+
+        for (i = 0; i < distribution->count; ++i) {
+            distribution->cdf[i] = pow(i + 1., -p[1]);
+        }
+
+        return make_cdf(distribution->cdf, distribution->count);
+    case LOGNORMAL:
+        return p[1] >= 0.;
+    case BIMODAL:
+        return p[1] >= 0. && p[3] >= 0. && p[4] >= 0. && p[4] <= 1.;
+    default:
+        return 0;
+    }
+}
+
+/* Each line of the file is a length and its weight, separated by
+ * whitespace. Blank lines, and lines starting with #, are ignored. Lengths
+ * missing from the file have weight 0. */
+int read_histogram(
+        struct length_distribution *distribution,
+        char const *filename)
+{
+    FILE *file = NULL;
+    char line[HISTOGRAM_LINE];
+    double weight = 0., *cdf = NULL;
+    long length = 0;
+    int size = 0, ok = 1;
+
+    file = fopen(filename, "r");
+    if (!file) {
+        perror(filename);
+        return 0;
+    }
+
+    while (ok && fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || sscanf(line, "%ld %lf", &length, &weight) != 2) {
+            continue;
+        }
+
+        ok = length >= 0 && length <= MAX_LENGTH && weight >= 0.;
+
+        /* The table covers lengths 0 to the longest in the file */
+        if (ok && length >= size) {
+            cdf = realloc(distribution->cdf,
+                    (size_t)(length + 1) * sizeof(*cdf));
+            ok = cdf != NULL;
+            if (ok) {
+                memset(cdf + size, 0,
+                        (size_t)(length + 1 - size) * sizeof(*cdf));
+                distribution->cdf = cdf;
+                size = (int)length + 1;
+            }
+        }
+
+        if (ok) {
+            distribution->cdf[length] += weight;
+        }
+    }
+
+    fclose(file);
+    distribution->first = 0;
+    distribution->count = size;
+    return ok && size > 0 && make_cdf(distribution->cdf, size);
+}
+
+long sample_length(struct length_distribution const *distribution)
+{
+    double const *p = distribution->params;
+    double length = 0.;
+    long i = 0, successes = 0;
+
+    switch (distribution->type) {
+    case IDENTICAL:
+        return (long)p[0];
+    case UNIFORM:
+        return (long)p[0]
+            + (long)next_below((unsigned long)(p[1] - p[0]) + 1);
+    case BINOMIAL:
+        for (i = 0; i < (long)p[0]; ++i) {
+            successes += next_uniform() < p[1];
+        }
+        return successes;
+    case ZIPF:
+    case EMPIRICAL:
+        return distribution->first
+            + sample_cdf(distribution->cdf, distribution->count);
+    case LOGNORMAL:
+        length = exp(p[0] + p[1] * next_normal());
+        break;
+    case BIMODAL:
+        length = next_uniform() < p[4]
+            ? p[0] + p[1] * next_normal()
+            : p[2] + p[3] * next_normal();
+        break;
+    }
+
+    /* Continuous lengths are rounded, and clamped to [0, MAX_LENGTH] */
+    length = floor(length + 0.5);
+    return length < 0. ? 0
+        : length > (double)MAX_LENGTH ? MAX_LENGTH
+        : (long)length;
+}
+
+void random_string(char *buf, long length)
+{
+    long i = 0;
+
+    for (i = 0; i < length; ++i) {
+        buf[i] = CHARS[next_below(CHAR_COUNT)];
+    }
+}
+
+int write_strings(
+        FILE *file,
+        struct length_distribution const *distribution,
+        long count)
+{
+    char *buf = NULL;
+    size_t length = 0;
+    long i = 0;
+    int ok = 0;
+
+    /* Room for the longest string and its newline */
+    buf = malloc((size_t)MAX_LENGTH + 1);
+    ok = buf != NULL;
+
+    for (i = 0; i < count && ok; ++i) {
+        length = (size_t)sample_length(distribution);
+        random_string(buf, (long)length);
+        buf[length] = '\n';
+        ok = fwrite(buf, 1, length + 1, file) == length + 1;
+    }
+
+    free(buf);
+    return ok;
+}
+
+int write_tokens(
+        FILE *file,
+        struct length_distribution const *distribution,
+        long count,
+        long vocabulary,
+        double skew)
+{
+    size_t *offsets = NULL;
+    double *frequencies = NULL;
+    char *tokens = NULL;
+    size_t length = 0;
+    long i = 0, token = 0;
+    int ok = 0;
+
+    offsets = malloc((size_t)(vocabulary + 1) * sizeof(*offsets));
+    frequencies = malloc((size_t)vocabulary * sizeof(*frequencies));
+    if (offsets && frequencies) {
+        tokens = make_vocabulary(distribution, vocabulary, offsets);
+    }
+
+    for (i = 0; i < vocabulary && tokens; ++i) {
+        frequencies[i] = pow((double)i + 1., -skew);
+    }
+
+    ok = tokens && make_cdf(frequencies, (int)vocabulary);
+    for (i = 0; i < count && ok; ++i) {
+        token = sample_cdf(frequencies, (int)vocabulary);
+        length = offsets[token + 1] - offsets[token];
+        ok = fwrite(tokens + offsets[token], 1, length, file) == length;
+    }
+
+    free(offsets);
+    free(frequencies);
+    free(tokens);
+    return ok;
+}
+
+char *make_vocabulary(
+        struct length_distribution const *distribution,
+        long vocabulary,
+        size_t *offsets)
+{
+    char *tokens = NULL, *larger = NULL;
+    size_t size = 0, capacity = 0, length = 0;
+    long i = 0;
+
+    for (i = 0; i < vocabulary; ++i) {
+        length = (size_t)sample_length(distribution) + 1;
+        if (size + length > capacity) {
+            capacity = 2 * (size + length);
+            larger = realloc(tokens, capacity);
+            if (!larger) {
+                free(tokens);
+                return NULL;
+            }
+
+            tokens = larger;
+        }
+
+        offsets[i] = size;
+        random_string(tokens + size, (long)length - 1);
+        tokens[size + length - 1] = '\n';
+        size += length;
+    }
+
+    offsets[vocabulary] = size;
+    return tokens;
+}
+
+void print_usage(char const *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-s seed] [-t vocabulary [-z skew]] <count> "
+            "<distribution> <parameters>\n"
+            "Distributions:\n"
+            "    identical <length>\n"
+            "    uniform <lower> <upper>\n"
+            "    binomial <trials> <probability>\n"
+            "    zipf <max_length> <exponent>\n"
+            "    lognormal <mu> <sigma>\n"
+            "    bimodal <mean1> <deviation1> <mean2> <deviation2> "
+            "<weight1>\n"
+            "    empirical <histogram_file>\n"
+            "With -t, the strings are drawn from a vocabulary of random\n"
+            "strings, the kth with weight 1/k^skew (default %.1f).\n",
+            name, DEFAULT_SKEW);
+}
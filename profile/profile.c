@@ -1,8 +1,18 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "profile.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+
+/* The format selected by profile_set_format */
+static enum profile_format format = PROFILE_CSV;
+
+/* The number of rows written so far */
+static int rows = 0;
 
 /* Returns the size of the given **OPEN** file object. */
 static size_t get_file_size(FILE *file);
@@ -10,6 +20,17 @@ static size_t get_file_size(FILE *file);
 /* Counts the number of lines (strings) in the given NUL terminated string */
 static int count_lines(char const *string);
 
+/* Indexes the non-empty lines of a sample */
+static int index_lines(struct profile_sample *sample);
+
+/* Returns the index of the histogram bucket holding the given latency, in
+ * picoseconds */
+static int bucket_index(unsigned long long picoseconds);
+
+/* Returns the largest latency, in picoseconds, held by the bucket with the
+ * given index */
+static unsigned long long bucket_limit(int index);
+
 struct profile_sample *profile_sample_read(
         struct profile_sample *sample,
         char const *filename)
@@ -18,45 +39,247 @@ struct profile_sample *profile_sample_read(
 
     assert(filename);
     file = fopen(filename, "rb");
-    assert(file);
+    if (!file) {
+        return NULL;
+    }
 
     sample->size = get_file_size(file) + 1;
     assert(sample->size > 0);
     sample->buf = calloc(1, sample->size);
     assert(sample->buf);
 
-    fread(sample->buf, 1, sample->size - 1, file);
-    sample->buf[sample->size] = '\0';
+    if (fread(sample->buf, 1, sample->size - 1, file) != sample->size - 1) {
+        fclose(file);
+        return NULL;
+    }
+
+    sample->buf[sample->size - 1] = '\0';
     sample->count = count_lines(sample->buf);
     fclose(file);
 
-    return sample;
+    return index_lines(sample) ? sample : NULL;
 }
 
 int rand_range(int low, int high)
 {
-    int r = 0;
-
     return low + (rand() % (int)(high - low + 1));
 }
 
+double profile_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+double profile_timer_overhead(void)
+{
+    static double overhead = -1.;
+    double start = 0., elapsed = 0.;
+    int i = 0;
+
+    if (overhead < 0.) {
+        overhead = 1.;
+        for (i = 0; i < 1000; ++i) {
+            start = profile_now();
+            elapsed = profile_now() - start;
+            if (elapsed < overhead) {
+                overhead = elapsed;
+            }
+        }
+    }
+
+    return overhead;
+}
+
+double profile_elapsed(double start)
+{
+    double elapsed = profile_now() - start - profile_timer_overhead();
+
+    return elapsed > 0. ? elapsed : 0.;
+}
+
+double profile_region_begin(void)
+{
+    profile_counters_start();
+    return profile_now();
+}
+
+double profile_region_end(double start, long long operations)
+{
+    double elapsed = profile_elapsed(start);
+
+    profile_counters_stop(operations);
+    return elapsed;
+}
+
+void profile_histogram_clear(struct profile_histogram *histogram)
+{
+    assert(histogram);
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+void profile_histogram_record(
+        struct profile_histogram *histogram,
+        double latency)
+{
+    assert(histogram);
+    assert(latency >= 0.);
+
+    ++histogram->counts[bucket_index(
+            (unsigned long long)(latency * 1000. + 0.5))];
+    ++histogram->total;
+    histogram->sum += latency;
+    if (latency > histogram->max) {
+        histogram->max = latency;
+    }
+}
+
+double profile_histogram_percentile(
+        struct profile_histogram const *histogram,
+        double percentile)
+{
+    unsigned long rank = 0, seen = 0;
+    double limit = 0.;
+    int i = 0;
+
+    assert(histogram);
+    assert(percentile >= 0. && percentile <= 100.);
+
+    if (histogram->total == 0) {
+        return 0.;
+    }
+
+    /* The rank of the percentile, rounded up, and at least the first */
+    rank = (unsigned long)(percentile / 100. * (double)histogram->total);
+    if ((double)rank < percentile / 100. * (double)histogram->total
+            || rank == 0) {
+        ++rank;
+    }
+
+    for (i = 0; i < PROFILE_BUCKETS; ++i) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            break;
+        }
+    }
+
+    limit = (double)bucket_limit(i) / 1000.;
+    return limit < histogram->max ? limit : histogram->max;
+}
+
+void profile_histogram_summary(
+        struct profile_histogram const *histogram,
+        double *values)
+{
+    assert(histogram && values);
+
+    values[0] = histogram->total > 0
+        ? histogram->sum / (double)histogram->total
+        : 0.;
+    values[1] = profile_histogram_percentile(histogram, 50.);
+    values[2] = histogram->total >= 100
+        ? profile_histogram_percentile(histogram, 99.)
+        : NAN;
+    values[3] = histogram->total >= 1000
+        ? profile_histogram_percentile(histogram, 99.9)
+        : NAN;
+    values[4] = histogram->max;
+}
+
+void profile_set_format(enum profile_format f)
+{
+    format = f;
+}
+
+void profile_header(char const *const *labels, int count)
+{
+    char const *counters[PROFILE_COUNTERS];
+    int i = 0, counter_count = 0;
+
+    assert(labels && count > 0);
+
+    counter_count = profile_counters_labels(counters);
+
+    if (format == PROFILE_JSON) {
+        fputs("{\"columns\": [", stdout);
+        for (i = 0; i < count + counter_count; ++i) {
+            printf("%s\"%s\"", i > 0 ? ", " : "",
+                    i < count ? labels[i] : counters[i - count]);
+        }
+        fputs("],\n \"rows\": [", stdout);
+    } else {
+        for (i = 0; i < count + counter_count; ++i) {
+            printf("%s%s", i > 0 ? "," : "",
+                    i < count ? labels[i] : counters[i - count]);
+        }
+        putchar('\n');
+    }
+
+    fflush(stdout);
+}
+
+void profile_row(double const *values, int count)
+{
+    double counters[PROFILE_COUNTERS];
+    int i = 0, counter_count = 0;
+
+    assert(values && count > 0);
+
+    counter_count = profile_counters_read(counters);
+
+    if (format == PROFILE_JSON) {
+        printf("%s\n  [", rows > 0 ? "," : "");
+        for (i = 0; i < count + counter_count; ++i) {
+            double value = i < count ? values[i] : counters[i - count];
+
+            /* JSON has no NaN, so a missing value is written as null */
+            fputs(i > 0 ? ", " : "", stdout);
+            if (isnan(value)) {
+                fputs("null", stdout);
+            } else {
+                printf("%g", value);
+            }
+        }
+        putchar(']');
+    } else {
+        for (i = 0; i < count + counter_count; ++i) {
+            printf("%s%f", i > 0 ? "," : "",
+                    i < count ? values[i] : counters[i - count]);
+        }
+        putchar('\n');
+    }
+
+    fflush(stdout);
+    ++rows;
+}
+
+void profile_end(void)
+{
+    if (format == PROFILE_JSON) {
+        fputs("\n]}\n", stdout);
+    }
+}
+
 size_t get_file_size(FILE *file)
 {
-    size_t size = 0;
+    long size = 0;
 
     assert(file);
     fseek(file, 0, SEEK_END);
     size = ftell(file);
     rewind(file);
 
-    return size;
+    return size < 0 ? 0 : (size_t)size;
 }
 
 int count_lines(char const *string)
 {
-    assert(string);
     int i = 0, lines = 0;
 
+    assert(string);
+
     while (string[i]) {
         if (string[i++] == '\n') {
             ++lines;
@@ -65,3 +288,69 @@ int count_lines(char const *string)
 
     return lines;
 }
+
+int index_lines(struct profile_sample *sample)
+{
+    size_t i = 0, first = 0;
+
+    assert(sample && sample->buf);
+
+    sample->line_count = 0;
+    sample->lines = calloc((size_t)sample->count + 1, sizeof(*sample->lines));
+    if (!sample->lines) {
+        return 0;
+    }
+
+    /* A final line without a newline counts too */
+    for (i = 0; i < sample->size; ++i) {
+        if (sample->buf[i] == '\n' || sample->buf[i] == '\0') {
+            if (i > first) {
+                sample->lines[sample->line_count].offset = first;
+                sample->lines[sample->line_count].length = i - first;
+                ++sample->line_count;
+            }
+            first = i + 1;
+        }
+
+        if (!sample->buf[i]) {
+            break;
+        }
+    }
+
+    return 1;
+}
+
+int bucket_index(unsigned long long picoseconds)
+{
+    int shift = 0;
+
+    if (picoseconds < PROFILE_SUB_BUCKETS) {
+        return (int)picoseconds;
+    }
+
+    /* Keep the top log2(PROFILE_SUB_BUCKETS) bits of the value, which lie in
+     * [PROFILE_SUB_BUCKETS/2, PROFILE_SUB_BUCKETS) */
+    while ((picoseconds >> shift) >= PROFILE_SUB_BUCKETS) {
+        ++shift;
+    }
+
+    /* Latencies too large for the last bucket are kept there */
+    if (shift > PROFILE_BUCKETS / (PROFILE_SUB_BUCKETS / 2) - 2) {
+        return PROFILE_BUCKETS - 1;
+    }
+
+    return PROFILE_SUB_BUCKETS / 2 * shift + (int)(picoseconds >> shift);
+}
+
+unsigned long long bucket_limit(int index)
+{
+    int shift = 0;
+
+    if (index < PROFILE_SUB_BUCKETS) {
+        return (unsigned long long)index;
+    }
+
+    shift = index / (PROFILE_SUB_BUCKETS / 2) - 1;
+    return (((unsigned long long)(index % (PROFILE_SUB_BUCKETS / 2)
+                    + PROFILE_SUB_BUCKETS / 2 + 1)) << shift) - 1;
+}
@@ -11,14 +11,74 @@
 /* Defines some shared functions for use in profiling and benchmarking
  * stringv code. */
 
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
 #define STRINGV_ALLOCATION  (4*1024*1024)
 #define RAND_SEED           0xDEADBEEF
 
-/* The profile sample object stores the raw string data contiguously. */
+/* The number of operations timed together as one latency sample. A single
+ * operation can take less time than the resolution of the clock, so each
+ * sample records the mean latency of a batch. */
+#define PROFILE_BATCH       16
+
+/* The number of latency samples recorded for each row of a latency profile,
+ * independently of the replicates. A percentile above 100 - 100/n% of n
+ * samples is just the maximum, so p99.9 needs thousands of samples. */
+#ifndef PROFILE_LATENCY_SAMPLES
+#   define PROFILE_LATENCY_SAMPLES  10000
+#endif
+
+/* Latency histograms keep PROFILE_SUB_BUCKETS/2 buckets for every power of
+ * two above PROFILE_SUB_BUCKETS picoseconds, and one bucket for each
+ * picosecond below it, so that every recorded value is kept to within about
+ * 6% of its true value. */
+#define PROFILE_SUB_BUCKETS 32
+#define PROFILE_BUCKETS     (PROFILE_SUB_BUCKETS * 31)
+
+/* The number of values written by profile_histogram_summary */
+#define PROFILE_SUMMARY_COUNT   5
+
+/* A line of the sample, as an offset into the sample buffer and a length */
+struct profile_line {
+    size_t offset;
+    size_t length;
+};
+
+/* The profile sample object stores the raw string data contiguously. The
+ * non-empty lines are indexed in lines, so that profiles can push them
+ * without measuring the search for each newline. */
 struct profile_sample {
     char *buf;
     size_t size;
     int count;
+    struct profile_line *lines;
+    int line_count;
+};
+
+/* A log-linear (HDR style) histogram of latencies */
+struct profile_histogram {
+    unsigned long counts[PROFILE_BUCKETS];
+    unsigned long total;
+    double sum;         /* Of every recorded latency, in nanoseconds */
+    double max;         /* The largest recorded latency, in nanoseconds */
+};
+
+/* The hardware performance counters that a profile can report */
+enum profile_counter {
+    PROFILE_CYCLES,
+    PROFILE_INSTRUCTIONS,
+    PROFILE_L1D_MISSES,     /* L1 data cache read misses */
+    PROFILE_LLC_MISSES,     /* Last level cache misses */
+    PROFILE_BRANCH_MISSES,
+    PROFILE_COUNTERS        /* The number of counters */
+};
+
+/* The formats a profile can write its results in */
+enum profile_format {
+    PROFILE_CSV,        /* A header row of labels, then one row per sweep */
+    PROFILE_JSON        /* {"columns": [labels], "rows": [[values], ...]} */
 };
 
 /* Reads a profile sample from a file */
@@ -29,4 +89,111 @@ struct profile_sample *profile_sample_read(
 /* Returns a pseudo-uniformly distributed integer in the range [low, high). */
 int rand_range(int low, int high);
 
+/* Returns the time elapsed on a monotonic clock since an arbitrary point, in
+ * seconds. Only differences between the values are meaningful. */
+double profile_now(void);
+
+/* Returns the overhead of a pair of profile_now calls, in seconds, as the
+ * smallest of many measurements. It is measured on the first call, and
+ * should be subtracted from each timed region. */
+double profile_timer_overhead(void);
+
+/* Returns the seconds elapsed since start, a value of profile_now, less the
+ * overhead of the timer. The result is never negative. */
+double profile_elapsed(double start);
+
+/* Begins a measured region. Returns the time, as profile_now, and starts
+ * the counters if they are open. */
+double profile_region_begin(void);
+
+/* Ends a measured region that began at start and performed the given number
+ * of operations. Stops the counters, and returns the elapsed time in seconds
+ * as profile_elapsed. */
+double profile_region_end(double start, long long operations);
+
+/* Opens the hardware performance counters with perf_event_open, for this
+ * process and the threads it creates afterwards. Must be called before
+ * profile_header. Returns the number of counters opened, which is 0 if perf
+ * events are unavailable (outside Linux, in a container, or when
+ * perf_event_paranoid forbids them); the results are then timing only. */
+int profile_counters_open(void);
+
+/* Writes the labels of the open counters to out, which must have room for
+ * PROFILE_COUNTERS labels. Returns the number written. */
+int profile_counters_labels(char const **out);
+
+/* Resets and starts the open counters */
+void profile_counters_start(void);
+
+/* Stops the open counters, and adds their counts and the given number of
+ * operations to the totals for the current row */
+void profile_counters_stop(long long operations);
+
+/* Writes the totals of the open counters for the current row to values,
+ * each divided by the number of operations, and resets the totals. values
+ * must have room for PROFILE_COUNTERS values. Returns the number written. */
+int profile_counters_read(double *values);
+
+/* Returns the count per operation of one counter over the regions measured
+ * since the last call to profile_counters_take for the same counter, or to
+ * profile_counters_read, or -1 if the counter isn't open. Lets a profile
+ * report counters for each of its phases; the totals written by profile_row
+ * are not affected. */
+double profile_counters_take(enum profile_counter counter);
+
+/* Empties a histogram */
+void profile_histogram_clear(struct profile_histogram *histogram);
+
+/* Records a latency, in nanoseconds, in a histogram */
+void profile_histogram_record(
+        struct profile_histogram *histogram,
+        double latency);
+
+/* Returns the latency, in nanoseconds, at or below which the given
+ * percentage of the recorded latencies lie, or 0 if the histogram is empty.
+ * The result is the upper bound of the bucket holding the percentile, but
+ * never more than the largest recorded latency. */
+double profile_histogram_percentile(
+        struct profile_histogram const *histogram,
+        double percentile);
+
+/* Writes the mean, p50, p99, p99.9 and max latencies of a histogram, in
+ * nanoseconds, to the first PROFILE_SUMMARY_COUNT elements of values. The p99
+ * and p99.9 are written as NaN unless the histogram holds at least 100 and
+ * 1000 latencies respectively, since with fewer they only repeat the max. */
+void profile_histogram_summary(
+        struct profile_histogram const *histogram,
+        double *values);
+
+/* Selects the format of the results written by profile_header and
+ * profile_row. Must be called before profile_header. */
+void profile_set_format(enum profile_format format);
+
+/* Writes the labels of the result columns. The first column is the
+ * independent variable. A column is added for each open counter. */
+void profile_header(char const *const *labels, int count);
+
+/* Writes one row of results, with a value for each column. The counts per
+ * operation of the regions measured since the last row are added for each
+ * open counter. */
+void profile_row(double const *values, int count);
+
+/* Finishes writing the results */
+void profile_end(void);
+
+/* Implemented by each profile. Prepares the profile to run over the sample,
+ * writes the header of its results, and returns nonzero on success. */
+int profile_init(struct profile_sample *const sample);
+
+/* Implemented by each profile. Runs the profile over the sample with the
+ * given block size, and writes one row of results. */
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates);
+
+#if defined(__cplusplus)
+}
+#endif /* defined(__cplusplus) */
+
 #endif /* PROFILE_H_ */
@@ -3,6 +3,7 @@ from matplotlib.pyplot import cm
 import numpy as np
 import sys
 import csv
+import json
 import argparse
 
 CLOCKS_PER_SEC = 1000000
@@ -25,9 +26,16 @@ class ProfileData(object):
             self._read_data(sys.stdin)
 
     def _read_data(self, f):
-        """ Reads the data stored in the given *open* file """
-        strings = f.read().split('\n')
-        string_data = [x for x in csv.reader(strings) if x != []]
+        """
+        Reads the data stored in the given *open* file, which is either csv
+        or json as written by a profile.
+        """
+        text = f.read()
+        if text.lstrip().startswith('{'):
+            self._read_json(json.loads(text))
+            return
+
+        string_data = [x for x in csv.reader(text.split('\n')) if x != []]
 
         # Read the labels, which is always the first element of string_data.
         # The number of series is always determined from the length of the
@@ -41,6 +49,16 @@ class ProfileData(object):
         for i in range(self._n_series):
             self._series.append([float(e[i]) for e in string_data[1:]])
 
+    def _read_json(self, data):
+        """ Reads data of the form {"columns": [...], "rows": [[...], ...]} """
+        self._labels = data['columns']
+        self._n_series = len(self._labels)
+
+        for i in range(self._n_series):
+            # Missing values (null) are read as NaN, as in the csv format
+            self._series.append([float('nan') if row[i] is None
+                                 else float(row[i]) for row in data['rows']])
+
     def n_series(self):
         """ Returns the number of series. """
         return self._n_series
@@ -74,16 +92,18 @@ def profile_arg_parser():
     Defines and returns an argument parser for parsing the options of a
     profile plot.
     """
-    parser = argparse.ArgumentParser(description='Plots csv profile data')
+    parser = argparse.ArgumentParser(description='Plots csv or json profile '
+            'data')
     # The output file (positional)
     parser.add_argument('output_file', help='The name of the output file', \
             type=str)
     # The input file (optional)
-    parser.add_argument('-i', '--input', help='The name of the input csv '
-            'file. Defaults to stdin if no value is given', nargs=1, type=str)
+    parser.add_argument('-i', '--input', help='The name of the input csv or '
+            'json file. Defaults to stdin if no value is given', nargs=1,
+            type=str)
     # The output file format (optional)
     parser.add_argument('-f', '--format', help='The output file format. ',
-            nargs=1, default='svg', choices=['png', 'svg'])
+            nargs=1, default=['svg'], choices=['png', 'svg'])
     # The plot title
     parser.add_argument('-t', '--title', help='The title of the plot', \
             nargs=1, required=True)
@@ -0,0 +1,296 @@
+#include "profile.h"
+#include "../stringv.h"
+
+/* Compares stringv with the structures a user would otherwise store a list of
+ * strings in: an array of pointers to malloc'd strings, and an offset table
+ * (one buffer holding every string, with the offset of each). Each row gives,
+ * for each structure, the build, random access and iteration times in
+ * nanoseconds per string, the memory used in bytes per string, and the last
+ * level cache misses per string of each phase (or -1 without counters). Only
+ * stringv depends on the block size. */
+
+/* The structures compared */
+enum structure {
+    STRINGV,
+    POINTERS,
+    OFFSETS,
+    STRUCTURES      /* The number of structures */
+};
+
+/* The measurements made of each structure, in column order */
+enum measure {
+    BUILD,
+    ACCESS,
+    ITERATION,
+    BYTES,
+    BUILD_MISSES,
+    ACCESS_MISSES,
+    ITERATION_MISSES,
+    MEASURES        /* The number of measurements */
+};
+
+char *buf = NULL;
+
+/* The pointer array, and the offset table with its data */
+char **pointers = NULL;
+size_t *offsets = NULL;
+char *data = NULL;
+
+static void measure_stringv(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates,
+        double *values);
+
+static void measure_pointers(
+        struct profile_sample const *sample,
+        int replicates,
+        double *values);
+
+static void measure_offsets(
+        struct profile_sample const *sample,
+        int replicates,
+        double *values);
+
+/* Fills indices with PROFILE_BATCH random indices in [0, count) */
+static void random_indices(int count, int *indices);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char const *const structures[STRUCTURES] = {
+        "stringv", "pointers", "offsets"
+    };
+    static char const *const measures[MEASURES] = {
+        "build", "access", "iteration", "bytes",
+        "build LLC misses", "access LLC misses", "iteration LLC misses"
+    };
+    static char names[STRUCTURES * MEASURES][48];
+    char const *labels[1 + STRUCTURES * MEASURES] = {"Block size"};
+    int i = 0;
+
+    assert(sample);
+
+    buf = calloc(1, STRINGV_ALLOCATION + 1);
+    pointers = calloc((size_t)sample->line_count + 1, sizeof(*pointers));
+    offsets = calloc((size_t)sample->line_count + 1, sizeof(*offsets));
+    data = malloc(sample->size);
+    if (!buf || !pointers || !offsets || !data || sample->line_count == 0) {
+        return 0;
+    }
+
+    for (i = 0; i < STRUCTURES * MEASURES; ++i) {
+        sprintf(names[i], "%s %s",
+                structures[i / MEASURES], measures[i % MEASURES]);
+        labels[i + 1] = names[i];
+    }
+
+    profile_header(labels, 1 + STRUCTURES * MEASURES);
+    return 1;
+}
+
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[1 + STRUCTURES * MEASURES];
+
+    assert(sample);
+
+    row[0] = block_size;
+    measure_stringv(sample, block_size, replicates,
+            row + 1 + STRINGV * MEASURES);
+    measure_pointers(sample, replicates, row + 1 + POINTERS * MEASURES);
+    measure_offsets(sample, replicates, row + 1 + OFFSETS * MEASURES);
+    profile_row(row, 1 + STRUCTURES * MEASURES);
+}
+
+void measure_stringv(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates,
+        double *values)
+{
+    struct stringv s = STRINGV_ZERO;
+    char const *iter = NULL, *end = NULL;
+    volatile char c = 0;
+    int indices[PROFILE_BATCH];
+    double start = 0., sum = 0.;
+    int i = 0, n = 0;
+
+    for (i = 0; i < replicates; ++i) {
+        stringv_init(&s, buf, STRINGV_ALLOCATION, block_size);
+
+        start = profile_region_begin();
+        for (n = 0; n < sample->line_count; ++n) {
+            stringv_push_back(&s,
+                    sample->buf + sample->lines[n].offset,
+                    sample->lines[n].length);
+        }
+        sum += profile_region_end(start, sample->line_count);
+    }
+    values[BUILD] = 1e9 * sum / replicates / sample->line_count;
+    values[BUILD_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    srand(RAND_SEED);
+    for (i = 0, sum = 0.; i < replicates; ++i) {
+        random_indices(s.string_count, indices);
+
+        start = profile_region_begin();
+        for (n = 0; n < PROFILE_BATCH; ++n) {
+            c = *stringv_get(&s, indices[n]);
+        }
+        sum += profile_region_end(start, PROFILE_BATCH);
+    }
+    values[ACCESS] = 1e9 * sum / replicates / PROFILE_BATCH;
+    values[ACCESS_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    end = stringv_end(&s);
+    for (i = 0, sum = 0.; i < replicates; ++i) {
+        start = profile_region_begin();
+        for (iter = stringv_begin(&s); iter != end;
+                iter = stringv_next(&s, iter)) {
+            c = *iter;
+        }
+        sum += profile_region_end(start, s.string_count);
+    }
+    values[ITERATION] = 1e9 * sum / replicates / s.string_count;
+    values[ITERATION_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    values[BYTES] = (double)(sizeof(s)
+            + (size_t)s.block_used * (size_t)s.block_size)
+        / s.string_count;
+    (void)c;
+}
+
+/* The memory used is the memory requested from malloc, and doesn't count the
+ * allocator's own overhead for each string. */
+void measure_pointers(
+        struct profile_sample const *sample,
+        int replicates,
+        double *values)
+{
+    volatile char c = 0;
+    int indices[PROFILE_BATCH];
+    double start = 0., sum = 0.;
+    size_t bytes = 0;
+    int i = 0, n = 0;
+
+    for (i = 0; i < replicates; ++i) {
+        start = profile_region_begin();
+        for (n = 0; n < sample->line_count; ++n) {
+            pointers[n] = malloc(sample->lines[n].length + 1);
+            memcpy(pointers[n],
+                    sample->buf + sample->lines[n].offset,
+                    sample->lines[n].length);
+            pointers[n][sample->lines[n].length] = '\0';
+        }
+        sum += profile_region_end(start, sample->line_count);
+
+        /* Keep the strings of the last replicate to read */
+        if (i < replicates - 1) {
+            for (n = 0; n < sample->line_count; ++n) {
+                free(pointers[n]);
+            }
+        }
+    }
+    values[BUILD] = 1e9 * sum / replicates / sample->line_count;
+    values[BUILD_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    srand(RAND_SEED);
+    for (i = 0, sum = 0.; i < replicates; ++i) {
+        random_indices(sample->line_count, indices);
+
+        start = profile_region_begin();
+        for (n = 0; n < PROFILE_BATCH; ++n) {
+            c = *pointers[indices[n]];
+        }
+        sum += profile_region_end(start, PROFILE_BATCH);
+    }
+    values[ACCESS] = 1e9 * sum / replicates / PROFILE_BATCH;
+    values[ACCESS_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    for (i = 0, sum = 0.; i < replicates; ++i) {
+        start = profile_region_begin();
+        for (n = 0; n < sample->line_count; ++n) {
+            c = *pointers[n];
+        }
+        sum += profile_region_end(start, sample->line_count);
+    }
+    values[ITERATION] = 1e9 * sum / replicates / sample->line_count;
+    values[ITERATION_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    bytes = (size_t)sample->line_count * sizeof(*pointers);
+    for (n = 0; n < sample->line_count; ++n) {
+        bytes += sample->lines[n].length + 1;
+        free(pointers[n]);
+    }
+    values[BYTES] = (double)bytes / sample->line_count;
+    (void)c;
+}
+
+/* The strings are stored with NUL terminators, so that a lookup gives a C
+ * string as with the other structures. */
+void measure_offsets(
+        struct profile_sample const *sample,
+        int replicates,
+        double *values)
+{
+    volatile char c = 0;
+    int indices[PROFILE_BATCH];
+    double start = 0., sum = 0.;
+    size_t length = 0;
+    int i = 0, n = 0;
+
+    for (i = 0; i < replicates; ++i) {
+        start = profile_region_begin();
+        for (n = 0, length = 0; n < sample->line_count; ++n) {
+            offsets[n] = length;
+            memcpy(data + length,
+                    sample->buf + sample->lines[n].offset,
+                    sample->lines[n].length);
+            length += sample->lines[n].length;
+            data[length++] = '\0';
+        }
+        offsets[n] = length;
+        sum += profile_region_end(start, sample->line_count);
+    }
+    values[BUILD] = 1e9 * sum / replicates / sample->line_count;
+    values[BUILD_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    srand(RAND_SEED);
+    for (i = 0, sum = 0.; i < replicates; ++i) {
+        random_indices(sample->line_count, indices);
+
+        start = profile_region_begin();
+        for (n = 0; n < PROFILE_BATCH; ++n) {
+            c = data[offsets[indices[n]]];
+        }
+        sum += profile_region_end(start, PROFILE_BATCH);
+    }
+    values[ACCESS] = 1e9 * sum / replicates / PROFILE_BATCH;
+    values[ACCESS_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    for (i = 0, sum = 0.; i < replicates; ++i) {
+        start = profile_region_begin();
+        for (n = 0; n < sample->line_count; ++n) {
+            c = data[offsets[n]];
+        }
+        sum += profile_region_end(start, sample->line_count);
+    }
+    values[ITERATION] = 1e9 * sum / replicates / sample->line_count;
+    values[ITERATION_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    values[BYTES] = (double)((size_t)(sample->line_count + 1)
+            * sizeof(*offsets) + length) / sample->line_count;
+    (void)c;
+}
+
+void random_indices(int count, int *indices)
+{
+    int i = 0;
+
+    for (i = 0; i < PROFILE_BATCH; ++i) {
+        indices[i] = rand_range(0, count - 1);
+    }
+}
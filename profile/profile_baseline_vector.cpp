@@ -0,0 +1,137 @@
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "profile.h"
+
+/* Measures a std::vector<std::string> as profile_baseline measures its
+ * structures, for comparison with its results: the build, random access and
+ * iteration times in nanoseconds per string, the memory used in bytes per
+ * string, and the last level cache misses per string of each phase (or -1
+ * without counters). The block size has no effect. */
+
+/* The measurements made, in column order */
+enum measure {
+    BUILD,
+    ACCESS,
+    ITERATION,
+    BYTES,
+    BUILD_MISSES,
+    ACCESS_MISSES,
+    ITERATION_MISSES,
+    MEASURES        /* The number of measurements */
+};
+
+static void measure_vector(
+        struct profile_sample const *sample,
+        int replicates,
+        double *values);
+
+/* Returns the memory used by a vector of strings, in bytes. Strings short
+ * enough to be stored inside the std::string object itself use no more. */
+static size_t vector_bytes(std::vector<std::string> const &strings);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char const *const labels[1 + MEASURES] = {
+        "Block size",
+        "vector build", "vector access", "vector iteration", "vector bytes",
+        "vector build LLC misses", "vector access LLC misses",
+        "vector iteration LLC misses"
+    };
+
+    assert(sample);
+
+    if (sample->line_count == 0) {
+        return 0;
+    }
+
+    profile_header(labels, 1 + MEASURES);
+    return 1;
+}
+
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[1 + MEASURES];
+
+    assert(sample);
+
+    row[0] = block_size;
+    measure_vector(sample, replicates, row + 1);
+    profile_row(row, 1 + MEASURES);
+}
+
+void measure_vector(
+        struct profile_sample const *sample,
+        int replicates,
+        double *values)
+{
+    std::vector<std::string> strings;
+    volatile char c = 0;
+    int indices[PROFILE_BATCH];
+    double start = 0., sum = 0.;
+    int i = 0, n = 0;
+
+    for (i = 0; i < replicates; ++i) {
+        strings.clear();
+        strings.shrink_to_fit();
+
+        start = profile_region_begin();
+        for (n = 0; n < sample->line_count; ++n) {
+            strings.emplace_back(
+                    sample->buf + sample->lines[n].offset,
+                    sample->lines[n].length);
+        }
+        sum += profile_region_end(start, sample->line_count);
+    }
+    values[BUILD] = 1e9 * sum / replicates / sample->line_count;
+    values[BUILD_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    srand(RAND_SEED);
+    for (i = 0, sum = 0.; i < replicates; ++i) {
+        for (n = 0; n < PROFILE_BATCH; ++n) {
+            indices[n] = rand_range(0, sample->line_count - 1);
+        }
+
+        start = profile_region_begin();
+        for (n = 0; n < PROFILE_BATCH; ++n) {
+            c = strings[(size_t)indices[n]].c_str()[0];
+        }
+        sum += profile_region_end(start, PROFILE_BATCH);
+    }
+    values[ACCESS] = 1e9 * sum / replicates / PROFILE_BATCH;
+    values[ACCESS_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    for (i = 0, sum = 0.; i < replicates; ++i) {
+        start = profile_region_begin();
+        for (std::string const &string : strings) {
+            c = string.c_str()[0];
+        }
+        sum += profile_region_end(start, sample->line_count);
+    }
+    values[ITERATION] = 1e9 * sum / replicates / sample->line_count;
+    values[ITERATION_MISSES] = profile_counters_take(PROFILE_LLC_MISSES);
+
+    values[BYTES] = (double)vector_bytes(strings) / sample->line_count;
+    (void)c;
+}
+
+size_t vector_bytes(std::vector<std::string> const &strings)
+{
+    std::less<char const *> const before;
+    size_t bytes = sizeof(strings) + strings.capacity() * sizeof(std::string);
+    char const *object = NULL;
+
+    for (std::string const &string : strings) {
+        object = reinterpret_cast<char const *>(&string);
+        if (before(string.data(), object)
+                || !before(string.data(), object + sizeof(string))) {
+            bytes += string.capacity() + 1;
+        }
+    }
+
+    return bytes;
+}
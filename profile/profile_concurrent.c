@@ -0,0 +1,201 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+
+#include "profile.h"
+#include "../stringv.h"
+#include "../stringv_concurrent.h"
+#include "../stringv_shard.h"
+
+/* The largest number of writer threads profiled. Thread counts are doubled
+ * from 1 up to this value. */
+#define MAX_THREADS 8
+
+/* The ways in which the writer threads can share the stringv */
+enum push_mode {
+    PUSH_LOCKED,        /* stringv_push_back under a mutex */
+    PUSH_CONCURRENT,    /* stringv_concurrent_push_back */
+    PUSH_SHARDED        /* stringv_shard_push_back, one shard per thread */
+};
+
+/* Arguments for a writer thread. Each thread pushes the lines in
+ * [first, last). */
+struct writer {
+    struct profile_sample const *sample;
+    struct stringv *stringv;
+    struct stringv_concurrent *cs;
+    struct stringv_shard *ss;
+    pthread_mutex_t *mutex;
+    int shard;
+    int first;
+    int last;
+};
+
+char *buf = NULL;
+
+static void *push_back_locked(void *arg);
+static void *push_back_concurrent(void *arg);
+static void *push_back_sharded(void *arg);
+
+static double concurrent_push_back(
+        struct profile_sample const *sample,
+        int block_size,
+        int threads,
+        enum push_mode mode,
+        int replicates);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char names[3 * MAX_THREADS][32];
+    char const *labels[1 + 3 * MAX_THREADS] = {"Block size"};
+    int threads = 0, count = 1;
+
+    assert(sample);
+
+    buf = calloc(1, STRINGV_ALLOCATION + 1);
+    if (!buf) {
+        return 0;
+    }
+
+    for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        sprintf(names[count - 1], "mutex %d", threads);
+        sprintf(names[count], "concurrent %d", threads);
+        sprintf(names[count + 1], "sharded %d", threads);
+        labels[count] = names[count - 1];
+        labels[count + 1] = names[count];
+        labels[count + 2] = names[count + 1];
+        count += 3;
+    }
+
+    profile_header(labels, count);
+    return 1;
+}
+
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[1 + 3 * MAX_THREADS];
+    int threads = 0, count = 1;
+
+    assert(sample);
+
+    row[0] = block_size;
+    for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        row[count++] = concurrent_push_back(sample, block_size, threads,
+                PUSH_LOCKED, replicates);
+        row[count++] = concurrent_push_back(sample, block_size, threads,
+                PUSH_CONCURRENT, replicates);
+        row[count++] = concurrent_push_back(sample, block_size, threads,
+                PUSH_SHARDED, replicates);
+    }
+
+    profile_row(row, count);
+}
+
+void *push_back_locked(void *arg)
+{
+    struct writer *w = arg;
+    int i = 0;
+
+    for (i = w->first; i < w->last; ++i) {
+        pthread_mutex_lock(w->mutex);
+        stringv_push_back(
+                w->stringv,
+                w->sample->buf + w->sample->lines[i].offset,
+                w->sample->lines[i].length);
+        pthread_mutex_unlock(w->mutex);
+    }
+
+    return NULL;
+}
+
+void *push_back_concurrent(void *arg)
+{
+    struct writer *w = arg;
+    int i = 0;
+
+    for (i = w->first; i < w->last; ++i) {
+        stringv_concurrent_push_back(
+                w->cs,
+                w->sample->buf + w->sample->lines[i].offset,
+                w->sample->lines[i].length);
+    }
+
+    return NULL;
+}
+
+void *push_back_sharded(void *arg)
+{
+    struct writer *w = arg;
+    int i = 0;
+
+    for (i = w->first; i < w->last; ++i) {
+        stringv_shard_push_back(
+                w->ss,
+                w->shard,
+                w->sample->buf + w->sample->lines[i].offset,
+                w->sample->lines[i].length);
+    }
+
+    return NULL;
+}
+
+/* Returns the mean wall clock time, in seconds, taken for the given number
+ * of threads to push every line of the sample into one shared stringv, in
+ * the given mode. */
+double concurrent_push_back(
+        struct profile_sample const *sample,
+        int block_size,
+        int threads,
+        enum push_mode mode,
+        int replicates)
+{
+    static void *(*const functions[])(void *) = {
+        push_back_locked,
+        push_back_concurrent,
+        push_back_sharded
+    };
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_concurrent cs;
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[MAX_THREADS];
+    struct writer writers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    double start = 0., sum = 0.;
+    int i = 0, t = 0;
+
+    for (i = 0; i < replicates; ++i) {
+        assert(stringv_init(&s, buf, STRINGV_ALLOCATION, block_size));
+        assert(stringv_concurrent_init(&cs, buf, STRINGV_ALLOCATION,
+                    block_size));
+        assert(stringv_shard_init(&ss, slots, threads, buf,
+                    STRINGV_ALLOCATION, block_size));
+
+        for (t = 0; t < threads; ++t) {
+            writers[t].sample = sample;
+            writers[t].stringv = &s;
+            writers[t].cs = &cs;
+            writers[t].ss = &ss;
+            writers[t].mutex = &mutex;
+            writers[t].shard = t;
+            writers[t].first = (int)((long)sample->line_count * t / threads);
+            writers[t].last =
+                (int)((long)sample->line_count * (t + 1) / threads);
+        }
+
+        start = profile_region_begin();
+        for (t = 0; t < threads; ++t) {
+            pthread_create(&ids[t], NULL, functions[mode], &writers[t]);
+        }
+        for (t = 0; t < threads; ++t) {
+            pthread_join(ids[t], NULL);
+        }
+        sum += profile_region_end(start, sample->line_count);
+    }
+
+    pthread_mutex_destroy(&mutex);
+    return sum / replicates;
+}
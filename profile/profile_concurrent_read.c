@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+
+#include "profile.h"
+#include "../stringv.h"
+#include "../stringv_concurrent.h"
+
+/* The largest number of reader threads profiled. Thread counts are doubled
+ * from 1 up to this value. */
+#define MAX_THREADS 8
+
+/* The number of strings loaded from the sample, which bounds the cost of a
+ * lookup in a stringv that isn't one-to-one */
+#define MAX_STRINGS 1024
+
+/* The number of lookups made by each reader thread */
+#define LOOKUPS     100000
+
+/* The time the writer sleeps between modifications, in nanoseconds */
+#define WRITE_INTERVAL  10000
+
+/* The state shared by the reader threads and the writer thread of one run.
+ * If locked is nonzero, stringv is guarded by rwlock; otherwise cs is used
+ * in single-writer mode. */
+struct shared {
+    struct profile_sample const *sample;
+    struct stringv *stringv;
+    struct stringv_concurrent *cs;
+    pthread_rwlock_t *rwlock;
+    int locked;
+    int done;
+};
+
+char *buf = NULL;
+
+/* The number of lines of the sample loaded, at most MAX_STRINGS */
+int line_count = 0;
+
+static void *read_strings(void *arg);
+static void *write_strings(void *arg);
+
+static double concurrent_read(
+        struct profile_sample const *sample,
+        int block_size,
+        int threads,
+        int locked,
+        int replicates);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char names[2 * MAX_THREADS][32];
+    char const *labels[1 + 2 * MAX_THREADS] = {"Block size"};
+    int threads = 0, count = 1;
+
+    assert(sample);
+
+    buf = calloc(1, STRINGV_ALLOCATION + 1);
+    if (!buf) {
+        return 0;
+    }
+
+    line_count = sample->line_count < MAX_STRINGS
+        ? sample->line_count
+        : MAX_STRINGS;
+    if (line_count == 0) {
+        return 0;
+    }
+
+    for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        sprintf(names[count - 1], "rwlock %d", threads);
+        sprintf(names[count], "seqlock %d", threads);
+        labels[count] = names[count - 1];
+        labels[count + 1] = names[count];
+        count += 2;
+    }
+
+    profile_header(labels, count);
+    return 1;
+}
+
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[1 + 2 * MAX_THREADS];
+    int threads = 0, count = 1;
+
+    assert(sample);
+
+    row[0] = block_size;
+    for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        row[count++] = concurrent_read(sample, block_size, threads, 1,
+                replicates);
+        row[count++] = concurrent_read(sample, block_size, threads, 0,
+                replicates);
+    }
+
+    profile_row(row, count);
+}
+
+void *read_strings(void *arg)
+{
+    struct shared *sh = arg;
+    char out[256];
+    char const *string = NULL;
+    int i = 0, n = 0;
+
+    for (i = 0; i < LOOKUPS; ++i) {
+        n = (int)(((long)i * 7919) % line_count);
+
+        if (sh->locked) {
+            pthread_rwlock_rdlock(sh->rwlock);
+            string = stringv_get(sh->stringv, n);
+            strncpy(out, string, sizeof(out) - 1);
+            pthread_rwlock_unlock(sh->rwlock);
+        } else {
+            stringv_concurrent_get(sh->cs, n, out, sizeof(out));
+        }
+    }
+
+    return NULL;
+}
+
+/* Replaces strings with other lines of the sample until the readers are
+ * done, so that the readers measure contention with a live writer */
+void *write_strings(void *arg)
+{
+    struct shared *sh = arg;
+    struct timespec const interval = {0, WRITE_INTERVAL};
+    struct profile_line const *line = NULL;
+    int i = 0;
+
+    while (!__atomic_load_n(&sh->done, __ATOMIC_RELAXED)) {
+        line = &sh->sample->lines[((long)i * 31) % line_count];
+
+        if (sh->locked) {
+            pthread_rwlock_wrlock(sh->rwlock);
+            stringv_replace(sh->stringv, i % line_count,
+                    sh->sample->buf + line->offset, line->length);
+            pthread_rwlock_unlock(sh->rwlock);
+        } else {
+            stringv_concurrent_write_begin(sh->cs);
+            stringv_replace(&sh->cs->stringv, i % line_count,
+                    sh->sample->buf + line->offset, line->length);
+            stringv_concurrent_write_end(sh->cs);
+        }
+
+        ++i;
+        nanosleep(&interval, NULL);
+    }
+
+    return NULL;
+}
+
+/* Returns the mean wall clock time, in seconds, taken for the given number
+ * of threads to each make LOOKUPS lookups while one writer modifies the
+ * stringv. If locked is nonzero, the threads use stringv_get under a
+ * read-write lock; otherwise they use stringv_concurrent_get. */
+double concurrent_read(
+        struct profile_sample const *sample,
+        int block_size,
+        int threads,
+        int locked,
+        int replicates)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_concurrent cs;
+    struct shared sh;
+    pthread_t ids[MAX_THREADS], writer;
+    pthread_rwlock_t rwlock;
+    double start = 0., sum = 0.;
+    int i = 0, t = 0;
+
+    pthread_rwlock_init(&rwlock, NULL);
+
+    for (i = 0; i < replicates; ++i) {
+        memset(buf, 0, STRINGV_ALLOCATION);
+        assert(stringv_concurrent_init(&cs, buf, STRINGV_ALLOCATION,
+                    block_size));
+        for (t = 0; t < line_count; ++t) {
+            stringv_concurrent_push_back(&cs,
+                    sample->buf + sample->lines[t].offset,
+                    sample->lines[t].length);
+        }
+        s = cs.stringv;
+
+        sh.sample = sample;
+        sh.stringv = &s;
+        sh.cs = &cs;
+        sh.rwlock = &rwlock;
+        sh.locked = locked;
+        sh.done = 0;
+
+        pthread_create(&writer, NULL, write_strings, &sh);
+
+        start = profile_region_begin();
+        for (t = 0; t < threads; ++t) {
+            pthread_create(&ids[t], NULL, read_strings, &sh);
+        }
+        for (t = 0; t < threads; ++t) {
+            pthread_join(ids[t], NULL);
+        }
+        sum += profile_region_end(start, (long long)threads * LOOKUPS);
+
+        __atomic_store_n(&sh.done, 1, __ATOMIC_RELAXED);
+        pthread_join(writer, NULL);
+    }
+
+    pthread_rwlock_destroy(&rwlock);
+    return sum / replicates;
+}
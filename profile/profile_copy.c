@@ -0,0 +1,95 @@
+#include "profile.h"
+#include "../stringv.h"
+
+/* The source stringv holds the sample lines truncated to fit a single block,
+ * so that it is one-to-one and every copy strategy can be reached. */
+char *source_buf = NULL;
+
+/* The destination buffer is twice the size of the source buffer, so that an
+ * injective copy into blocks twice the size always has room. */
+char *dest_buf = NULL;
+
+/* Returns the mean time, in nanoseconds, taken to copy one string from a
+ * source stringv with the given block size to a destination stringv with the
+ * given block size. */
+static double copy(
+        struct profile_sample const *sample,
+        int source_block_size,
+        int dest_block_size,
+        int replicates);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char const *const labels[] = {
+        "Block size",
+        "bijective",
+        "injective",
+        "stringwise"
+    };
+
+    assert(sample);
+
+    source_buf = calloc(1, STRINGV_ALLOCATION + 1);
+    dest_buf = calloc(1, 2 * STRINGV_ALLOCATION + 1);
+    if (!source_buf || !dest_buf || sample->line_count == 0) {
+        return 0;
+    }
+
+    profile_header(labels, 4);
+    return 1;
+}
+
+/* The bijective copy uses equal block sizes, the injective copy doubles the
+ * destination block size, and the stringwise copy halves it (a block size of
+ * 2 can't be halved, so that row's stringwise column is bijective). */
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[4];
+
+    assert(sample);
+
+    row[0] = block_size;
+    row[1] = copy(sample, block_size, block_size, replicates);
+    row[2] = copy(sample, block_size, 2 * block_size, replicates);
+    row[3] = copy(sample, block_size,
+            block_size / 2 < 2 ? 2 : block_size / 2, replicates);
+    profile_row(row, 4);
+}
+
+double copy(
+        struct profile_sample const *sample,
+        int source_block_size,
+        int dest_block_size,
+        int replicates)
+{
+    struct stringv source = STRINGV_ZERO, dest = STRINGV_ZERO;
+    size_t length = 0;
+    double start = 0., sum = 0.;
+    int i = 0, n = 0;
+
+    stringv_init(&source, source_buf, STRINGV_ALLOCATION, source_block_size);
+    for (n = 0; n < sample->line_count; ++n) {
+        length = sample->lines[n].length;
+        if (length > (size_t)source_block_size - 1) {
+            length = (size_t)source_block_size - 1;
+        }
+
+        if (!stringv_push_back(&source,
+                    sample->buf + sample->lines[n].offset, length)) {
+            break;
+        }
+    }
+
+    stringv_init(&dest, dest_buf, 2 * STRINGV_ALLOCATION, dest_block_size);
+
+    for (i = 0; i < replicates; ++i) {
+        start = profile_region_begin();
+        stringv_copy(&dest, &source);
+        sum += profile_region_end(start, source.string_count);
+    }
+
+    return 1e9 * sum / replicates / source.string_count;
+}
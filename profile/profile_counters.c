@@ -0,0 +1,185 @@
+#define _GNU_SOURCE
+
+#include "profile.h"
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(__linux__)
+#   include <linux/perf_event.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif /* defined(__linux__) */
+
+/* The file descriptors of the counters, or -1 for a counter that couldn't
+ * be opened */
+static int fds[PROFILE_COUNTERS] = {-1, -1, -1, -1, -1};
+
+/* The counts and operations accumulated since the last call to
+ * profile_counters_read */
+static long long totals[PROFILE_COUNTERS];
+static long long operations = 0;
+
+/* The total and operations of each counter at the last call to
+ * profile_counters_take for that counter */
+static long long marks[PROFILE_COUNTERS];
+static long long mark_operations[PROFILE_COUNTERS];
+
+static char const *const labels[PROFILE_COUNTERS] = {
+    "cycles",
+    "instructions",
+    "L1D misses",
+    "LLC misses",
+    "branch misses"
+};
+
+#if defined(__linux__)
+/* Opens a counter of the given type and configuration for the calling
+ * process (and the threads it creates from now on), disabled and counting
+ * user space only. Returns the file descriptor, or -1 on failure. */
+static int open_counter(unsigned type, unsigned long long config);
+#endif /* defined(__linux__) */
+
+int profile_counters_open(void)
+{
+    int opened = 0;
+#if defined(__linux__)
+    static unsigned const types[PROFILE_COUNTERS] = {
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE
+    };
+    static unsigned long long const configs[PROFILE_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+    int i = 0;
+
+    for (i = 0; i < PROFILE_COUNTERS; ++i) {
+        if (fds[i] < 0) {
+            fds[i] = open_counter(types[i], configs[i]);
+        }
+
+        if (fds[i] >= 0) {
+            ++opened;
+        }
+    }
+#endif /* defined(__linux__) */
+
+    return opened;
+}
+
+int profile_counters_labels(char const **out)
+{
+    int i = 0, count = 0;
+
+    assert(out);
+
+    for (i = 0; i < PROFILE_COUNTERS; ++i) {
+        if (fds[i] >= 0) {
+            out[count++] = labels[i];
+        }
+    }
+
+    return count;
+}
+
+void profile_counters_start(void)
+{
+#if defined(__linux__)
+    int i = 0;
+
+    for (i = 0; i < PROFILE_COUNTERS; ++i) {
+        if (fds[i] >= 0) {
+            ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif /* defined(__linux__) */
+}
+
+void profile_counters_stop(long long count)
+{
+#if defined(__linux__)
+    long long value = 0;
+    int i = 0;
+
+    for (i = 0; i < PROFILE_COUNTERS; ++i) {
+        if (fds[i] >= 0) {
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fds[i], &value, sizeof(value)) == sizeof(value)) {
+                totals[i] += value;
+            }
+        }
+    }
+#endif /* defined(__linux__) */
+
+    operations += count;
+}
+
+int profile_counters_read(double *values)
+{
+    int i = 0, count = 0;
+
+    assert(values);
+
+    for (i = 0; i < PROFILE_COUNTERS; ++i) {
+        if (fds[i] >= 0) {
+            values[count++] = operations > 0
+                ? (double)totals[i] / (double)operations
+                : 0.;
+        }
+    }
+
+    memset(totals, 0, sizeof(totals));
+    memset(marks, 0, sizeof(marks));
+    memset(mark_operations, 0, sizeof(mark_operations));
+    operations = 0;
+    return count;
+}
+
+double profile_counters_take(enum profile_counter counter)
+{
+    double value = 0.;
+
+    assert(counter >= 0 && counter < PROFILE_COUNTERS);
+
+    if (fds[counter] < 0) {
+        return -1.;
+    }
+
+    if (operations > mark_operations[counter]) {
+        value = (double)(totals[counter] - marks[counter])
+            / (double)(operations - mark_operations[counter]);
+    }
+
+    marks[counter] = totals[counter];
+    mark_operations[counter] = operations;
+    return value;
+}
+
+#if defined(__linux__)
+int open_counter(unsigned type, unsigned long long config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0UL);
+}
+#endif /* defined(__linux__) */
@@ -0,0 +1,77 @@
+#include "profile.h"
+#include "../stringv.h"
+
+/* The number of strings loaded from the sample. stringv_insert moves every
+ * string after the position written, so the cost of a whole run grows with the
+ * square of this number. */
+#define MAX_STRINGS 2000
+
+char *buf = NULL;
+
+/* The number of lines of the sample used, at most MAX_STRINGS */
+int line_count = 0;
+
+static double insert_middle(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char const *const labels[] = {"Block size", "insert"};
+
+    assert(sample);
+
+    buf = calloc(1, STRINGV_ALLOCATION + 1);
+    line_count = sample->line_count < MAX_STRINGS
+        ? sample->line_count
+        : MAX_STRINGS;
+    if (!buf || line_count == 0) {
+        return 0;
+    }
+
+    profile_header(labels, 2);
+    return 1;
+}
+
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[2];
+
+    assert(sample);
+
+    row[0] = block_size;
+    row[1] = insert_middle(sample, block_size, replicates);
+    profile_row(row, 2);
+}
+
+/* Returns the mean time, in nanoseconds, taken to insert one line of the
+ * sample into the middle of a stringv, as it grows from empty to line_count
+ * strings. */
+double insert_middle(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates)
+{
+    struct stringv s = STRINGV_ZERO;
+    double start = 0., sum = 0.;
+    int i = 0, n = 0;
+
+    for (i = 0; i < replicates; ++i) {
+        stringv_init(&s, buf, STRINGV_ALLOCATION, block_size);
+
+        start = profile_region_begin();
+        for (n = 0; n < line_count; ++n) {
+            stringv_insert(&s,
+                    sample->buf + sample->lines[n].offset,
+                    sample->lines[n].length,
+                    n / 2);
+        }
+        sum += profile_region_end(start, line_count);
+    }
+
+    return 1e9 * sum / replicates / line_count;
+}
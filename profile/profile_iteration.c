@@ -0,0 +1,69 @@
+#include "profile.h"
+#include "../stringv.h"
+
+char *buf = NULL;
+
+static double iteration(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char const *const labels[] = {"Block size", "iteration"};
+
+    assert(sample);
+
+    buf = calloc(1, STRINGV_ALLOCATION + 1);
+    if (!buf || sample->line_count == 0) {
+        return 0;
+    }
+
+    profile_header(labels, 2);
+    return 1;
+}
+
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[2];
+
+    assert(sample);
+
+    row[0] = block_size;
+    row[1] = iteration(sample, block_size, replicates);
+    profile_row(row, 2);
+}
+
+/* Returns the mean time, in nanoseconds, taken per string to iterate over a
+ * stringv holding the sample with stringv_begin/stringv_next, reading the
+ * first character of each string. */
+double iteration(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates)
+{
+    struct stringv s = STRINGV_ZERO;
+    char const *iter = NULL, *end = NULL;
+    volatile char c = 0;
+    double start = 0., sum = 0.;
+    int i = 0;
+
+    stringv_init(&s, buf, STRINGV_ALLOCATION, block_size);
+    stringv_split_c(&s, sample->buf, sample->size - 1, '\n');
+    end = stringv_end(&s);
+
+    for (i = 0; i < replicates; ++i) {
+        start = profile_region_begin();
+        for (iter = stringv_begin(&s); iter != end;
+                iter = stringv_next(&s, iter)) {
+            c = *iter;
+        }
+        sum += profile_region_end(start, s.string_count);
+    }
+
+    (void)c;
+    return 1e9 * sum / replicates / s.string_count;
+}
@@ -1,27 +1,21 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "profile.h"
 
-extern int profile_init(struct profile_sample *const sample);
-
-extern void profile_function(
-        struct profile_sample *const sample,
-        int block_size,
-        int replicates);
-
 /* Prints the usage to stdout. Takes as an argument the executable name. */
 static void print_usage(char const *name);
 
 int main(int argc, char **argv)
 {
-    struct profile_sample sample = {NULL, 0};
+    struct profile_sample sample = {NULL, 0, 0, NULL, 0};
     char const *sample_file = NULL;
     int block_size_min = 0, block_size_max = 0, replicates = 0;
-    int i = 0, j = 0;
+    int i = 0;
 
-    if (argc != 5) {
+    if (argc < 5 || argc > 7) {
         print_usage(argv[0]);
         return 1;
     }
@@ -38,6 +32,21 @@ int main(int argc, char **argv)
 
     assert(block_size_min < block_size_max);
 
+    /* The options may be given in any order */
+    for (i = 5; i < argc; ++i) {
+        if (strcmp(argv[i], "json") == 0) {
+            profile_set_format(PROFILE_JSON);
+        } else if (strcmp(argv[i], "counters") == 0) {
+            if (profile_counters_open() == 0) {
+                fputs("Hardware counters unavailable, timing only\n",
+                        stderr);
+            }
+        } else if (strcmp(argv[i], "csv") != 0) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
     /* Generate the profile sample object from the sample file */
     if (!profile_sample_read(&sample, sample_file)) {
         printf("Failed to read sample file %s\n", sample_file);
@@ -54,11 +63,12 @@ int main(int argc, char **argv)
         profile_function(&sample, i, replicates);
     }
 
+    profile_end();
     return 0;
 }
 
 void print_usage(char const *name)
 {
     printf("Usage: %s <sample_file> <block_size_min> <block_size_max> "
-            "<replicates>\n", name);
+            "<replicates> [csv|json] [counters]\n", name);
 }
@@ -6,7 +6,7 @@ import profile
 
 def main():
     args = vars(profile.profile_arg_parser().parse_args())
-    data = profile.ProfileData(args['input'])
+    data = profile.ProfileData(args['input'][0] if args['input'] else None)
     colours = profile.plot_colours(data.n_series())
 
     figure = plt.figure()
@@ -0,0 +1,64 @@
+#include "profile.h"
+#include "../stringv.h"
+
+char *buf = NULL;
+
+static double push_back(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char const *const labels[] = {"Block size", "push_back"};
+
+    assert(sample);
+
+    buf = calloc(1, STRINGV_ALLOCATION + 1);
+    if (!buf || sample->line_count == 0) {
+        return 0;
+    }
+
+    profile_header(labels, 2);
+    return 1;
+}
+
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[2];
+
+    assert(sample);
+
+    row[0] = block_size;
+    row[1] = push_back(sample, block_size, replicates);
+    profile_row(row, 2);
+}
+
+/* Returns the mean time, in nanoseconds, taken to push one line of the
+ * sample onto the back of an empty stringv. */
+double push_back(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates)
+{
+    struct stringv s = STRINGV_ZERO;
+    double start = 0., sum = 0.;
+    int i = 0, n = 0;
+
+    for (i = 0; i < replicates; ++i) {
+        stringv_init(&s, buf, STRINGV_ALLOCATION, block_size);
+
+        start = profile_region_begin();
+        for (n = 0; n < sample->line_count; ++n) {
+            stringv_push_back(&s,
+                    sample->buf + sample->lines[n].offset,
+                    sample->lines[n].length);
+        }
+        sum += profile_region_end(start, sample->line_count);
+    }
+
+    return 1e9 * sum / replicates / sample->line_count;
+}
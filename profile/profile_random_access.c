@@ -3,38 +3,54 @@
 
 char *buf = NULL;
 
-static double random_access_stringv(
+static void random_access_stringv(
         struct profile_sample const *sample,
         struct stringv const *stringv,
-        int replicates);
+        int samples,
+        struct profile_histogram *histogram);
 
-static double random_access_naive(
+static void random_access_naive(
         struct profile_sample const *sample,
-        int replicates);
+        int samples,
+        struct profile_histogram *histogram);
 
-int profile_init(struct profile_sample const *sample)
+int profile_init(struct profile_sample *const sample)
 {
+    static char const *const labels[] = {
+        "Block size",
+        "stringv mean", "stringv p50", "stringv p99", "stringv p99.9",
+        "stringv max",
+        "naive mean", "naive p50", "naive p99", "naive p99.9", "naive max"
+    };
+
     assert(sample);
-    (void)sample;
 
-    buf = calloc(1, STRINGV_ALLOCATION);
-    if (!buf) {
+    buf = calloc(1, STRINGV_ALLOCATION + 1);
+    if (!buf || sample->line_count == 0) {
         return 0;
     }
 
-    puts("Block size,stringv,naive");
+    profile_header(labels, 1 + 2 * PROFILE_SUMMARY_COUNT);
     return 1;
 }
 
 void profile_function(
-        struct profile_sample const *sample,
+        struct profile_sample *const sample,
         int block_size,
         int replicates)
 {
+    static struct profile_histogram histogram;
+    static double naive[PROFILE_SUMMARY_COUNT];
+    static int naive_done = 0;
     struct stringv s = STRINGV_ZERO;
+    double row[1 + 2 * PROFILE_SUMMARY_COUNT];
 
     assert(sample);
 
+    /* The histograms take PROFILE_LATENCY_SAMPLES samples whatever the
+     * replicates, so that their tail percentiles are meaningful */
+    (void)replicates;
+
     /* Clear the global buffer */
     assert(buf);
     memset(buf, 0, STRINGV_ALLOCATION);
@@ -43,63 +59,83 @@ void profile_function(
     stringv_init(&s, buf, STRINGV_ALLOCATION, block_size);
 
     /* Fill the stringv with the sample strings (they are newline delimited) */
-    stringv_split(&s, sample->buf, (int)sample->size, '\n');
+    stringv_split_c(&s, sample->buf, sample->size - 1, '\n');
 
     /* Run the profiles */
-    printf("%d,%f,%f\n", block_size,
-            random_access_stringv(sample, &s, replicates),
-            random_access_naive(sample, replicates));
+    row[0] = block_size;
+    random_access_stringv(sample, &s, PROFILE_LATENCY_SAMPLES, &histogram);
+    profile_histogram_summary(&histogram, row + 1);
+
+    /* The naive scan does not depend on the block size, so it is measured
+     * once and repeated in every row */
+    if (!naive_done) {
+        random_access_naive(sample, PROFILE_LATENCY_SAMPLES, &histogram);
+        profile_histogram_summary(&histogram, naive);
+        naive_done = 1;
+    }
+
+    memcpy(row + 1 + PROFILE_SUMMARY_COUNT, naive, sizeof naive);
+    profile_row(row, 1 + 2 * PROFILE_SUMMARY_COUNT);
 }
 
-double random_access_stringv(
+/* Records in histogram the latency, in nanoseconds, of each of the given
+ * number of stringv_get lookups of a random line of the sample. A lookup
+ * scans the blocks, which takes far longer than the resolution of the clock,
+ * so each lookup is timed on its own rather than in a batch. */
+void random_access_stringv(
         struct profile_sample const *sample,
         struct stringv const *stringv,
-        int replicates)
+        int samples,
+        struct profile_histogram *histogram)
 {
-    volatile char const *P = NULL;
-    int i = 0, j = 0, r = 0;
-    clock_t start = 0;
-    double sum = 0.;
+    char const *volatile p = NULL;
+    double start = 0.;
+    int i = 0, r = 0;
 
     srand(RAND_SEED);
+    profile_histogram_clear(histogram);
 
-    for (i = 0; i < replicates; ++i) {
-        r = rand_range(0, sample->count);
+    for (i = 0; i < samples; ++i) {
+        r = rand_range(0, sample->line_count - 1);
 
-        start = clock();
-        P = stringv_get(stringv, r);
-        sum += (clock() - start);
+        start = profile_region_begin();
+        p = stringv_get(stringv, r);
+        profile_histogram_record(histogram,
+                1e9 * profile_region_end(start, 1));
     }
 
-    return sum / replicates;
+    (void)p;
 }
 
-double random_access_naive(
+/* Records in histogram the latency, in nanoseconds, of each of the given
+ * number of lookups of a random line of the sample by counting newlines from
+ * the start of the sample. Each lookup is timed on its own. */
+void random_access_naive(
         struct profile_sample const *sample,
-        int replicates)
+        int samples,
+        struct profile_histogram *histogram)
 {
-    volatile char const *P = NULL;
-    int i = 0, j = 0, r = 0;
-    clock_t start = 0;
-    double sum = 0.;
+    char const *volatile p = NULL;
+    double start = 0.;
+    int i = 0, n = 0;
+    size_t j = 0;
 
     srand(RAND_SEED);
+    profile_histogram_clear(histogram);
 
-    for (i = 0; i < replicates; ++i) {
-        r = rand_range(0, sample->count);
+    for (i = 0; i < samples; ++i) {
+        n = rand_range(0, sample->line_count - 1);
 
-        start = clock();
-        while (r > 0) {
-            if (!sample->buf[j]) {
-                --r;
+        start = profile_region_begin();
+        for (j = 0; n > 0; ++j) {
+            if (sample->buf[j] == '\n') {
+                --n;
             }
-
-            ++j;
         }
-        P = sample->buf + j;
-        sum += (clock() - start);
-        j = 0;
+        p = sample->buf + j;
+        profile_histogram_record(histogram,
+                1e9 * profile_region_end(start, 1));
     }
 
-    return sum / replicates;
+    (void)p;
 }
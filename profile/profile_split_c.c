@@ -0,0 +1,60 @@
+#include "profile.h"
+#include "../stringv.h"
+
+char *buf = NULL;
+
+static double split_c(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char const *const labels[] = {"Block size", "split_c"};
+
+    assert(sample);
+
+    buf = calloc(1, STRINGV_ALLOCATION + 1);
+    if (!buf || sample->line_count == 0) {
+        return 0;
+    }
+
+    profile_header(labels, 2);
+    return 1;
+}
+
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[2];
+
+    assert(sample);
+
+    row[0] = block_size;
+    row[1] = split_c(sample, block_size, replicates);
+    profile_row(row, 2);
+}
+
+/* Returns the mean time, in nanoseconds, taken per line to split the whole
+ * sample on newlines into an empty stringv. */
+double split_c(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates)
+{
+    struct stringv s = STRINGV_ZERO;
+    double start = 0., sum = 0.;
+    int i = 0;
+
+    for (i = 0; i < replicates; ++i) {
+        stringv_init(&s, buf, STRINGV_ALLOCATION, block_size);
+
+        start = profile_region_begin();
+        stringv_split_c(&s, sample->buf, sample->size - 1, '\n');
+        sum += profile_region_end(start, sample->line_count);
+    }
+
+    return 1e9 * sum / replicates / sample->line_count;
+}
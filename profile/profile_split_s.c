@@ -0,0 +1,80 @@
+#include "profile.h"
+#include "../stringv.h"
+
+/* The separator that replaces each newline of the sample */
+#define SEPARATOR           ", "
+#define SEPARATOR_LENGTH    2
+
+char *buf = NULL;
+
+/* The lines of the sample joined with SEPARATOR */
+char *text = NULL;
+size_t text_length = 0;
+
+static double split_s(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates);
+
+int profile_init(struct profile_sample *const sample)
+{
+    static char const *const labels[] = {"Block size", "split_s"};
+    int n = 0;
+
+    assert(sample);
+
+    buf = calloc(1, STRINGV_ALLOCATION + 1);
+    text = malloc((size_t)sample->line_count * SEPARATOR_LENGTH
+            + sample->size);
+    if (!buf || !text || sample->line_count == 0) {
+        return 0;
+    }
+
+    for (n = 0; n < sample->line_count; ++n) {
+        memcpy(text + text_length,
+                sample->buf + sample->lines[n].offset,
+                sample->lines[n].length);
+        text_length += sample->lines[n].length;
+        memcpy(text + text_length, SEPARATOR, SEPARATOR_LENGTH);
+        text_length += SEPARATOR_LENGTH;
+    }
+
+    profile_header(labels, 2);
+    return 1;
+}
+
+void profile_function(
+        struct profile_sample *const sample,
+        int block_size,
+        int replicates)
+{
+    double row[2];
+
+    assert(sample);
+
+    row[0] = block_size;
+    row[1] = split_s(sample, block_size, replicates);
+    profile_row(row, 2);
+}
+
+/* Returns the mean time, in nanoseconds, taken per line to split the joined
+ * sample on SEPARATOR into an empty stringv. */
+double split_s(
+        struct profile_sample const *sample,
+        int block_size,
+        int replicates)
+{
+    struct stringv s = STRINGV_ZERO;
+    double start = 0., sum = 0.;
+    int i = 0;
+
+    for (i = 0; i < replicates; ++i) {
+        stringv_init(&s, buf, STRINGV_ALLOCATION, block_size);
+
+        start = profile_region_begin();
+        stringv_split_s(&s, text, text_length, SEPARATOR, SEPARATOR_LENGTH);
+        sum += profile_region_end(start, sample->line_count);
+    }
+
+    return 1e9 * sum / replicates / sample->line_count;
+}
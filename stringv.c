@@ -1,8 +1,92 @@
+/* Trace events are timestamped with the POSIX monotonic clock */
+#if defined(STRINGV_TRACE) && !defined(_POSIX_C_SOURCE)
+#   define _POSIX_C_SOURCE 200809L
+#endif /* defined(STRINGV_TRACE) && ... */
+
 #include "stringv.h"
 
 #include <assert.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif /* defined(__SSE2__) */
+
+/* Buffer regions of at least this many chars are zeroed and copied with
+ * non-temporal (streaming) stores where the target supports them. Streaming
+ * stores bypass the cache, so clearing or copying a very large stringv does
+ * not evict the caller's working set. Below the threshold the ordinary
+ * memset and memcpy are faster, since the written data is likely to be read
+ * again soon. */
+#ifndef STRINGV_STREAM_THRESHOLD
+#   define STRINGV_STREAM_THRESHOLD     (4 * 1024 * 1024)
+#endif /* STRINGV_STREAM_THRESHOLD */
+
+/* stringv_tombstone compacts the stringv once more than this percentage of
+ * its stored strings are dead. Defining it as 100 disables automatic
+ * compaction altogether. */
+#ifndef STRINGV_COMPACT_PERCENT
+#   define STRINGV_COMPACT_PERCENT      50
+#endif /* STRINGV_COMPACT_PERCENT */
+
+/* With STRINGV_COUNTERS defined, COUNT adds n to one of the calling thread's
+ * operation counters. Otherwise it compiles to nothing. */
+#if defined(STRINGV_COUNTERS)
+#   if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#       define THREAD_LOCAL     _Thread_local
+#   elif defined(__GNUC__)
+#       define THREAD_LOCAL     __thread
+#   else
+#       define THREAD_LOCAL     /* Nothing: the counters are shared */
+#   endif
+#   define COUNT(counter, n)    (counters.counter += (unsigned long long)(n))
+static THREAD_LOCAL struct stringv_counters counters;
+#else
+#   define COUNT(counter, n)    ((void)0)
+#endif /* defined(STRINGV_COUNTERS) */
+
+/* With STRINGV_TRACE defined, each traced function is compiled as a static
+ * function of another name, and a function of the public name (at the end of
+ * this file) calls the trace hook on either side of it. Calls between the
+ * traced functions within this file go to the untraced functions, so that
+ * each call from outside gives exactly one pair of events. */
+#if defined(STRINGV_TRACE)
+#   include <time.h>
+#   if defined(STRINGV_USDT)
+#       include <sys/sdt.h>
+#   endif /* defined(STRINGV_USDT) */
+#   define stringv_init                 untraced_init
+#   define stringv_clear                untraced_clear
+#   define stringv_copy                 untraced_copy
+#   define stringv_append               untraced_append
+#   define stringv_reblock              untraced_reblock
+#   define stringv_push_back            untraced_push_back
+#   define stringv_push_front           untraced_push_front
+#   define stringv_insert               untraced_insert
+#   define stringv_replace              untraced_replace
+#   define stringv_split_c              untraced_split_c
+#   define stringv_split_s              untraced_split_s
+#   define stringv_join                 untraced_join
+#   define stringv_column_import        untraced_column_import
+#   define stringv_column_import64      untraced_column_import64
+#   define stringv_remove               untraced_remove
+#   define stringv_tombstone            untraced_tombstone
+#   define stringv_compact              untraced_compact
+#   define stringv_swap                 untraced_swap
+#   define stringv_rotate               untraced_rotate
+#   define stringv_reverse              untraced_reverse
+#   define stringv_stable_partition     untraced_stable_partition
+#   define stringv_snapshot_copy        untraced_snapshot_copy
+#endif /* defined(STRINGV_TRACE) */
+
+/* The states of a snapshot chunk that has no preserved copy. A chunk is live
+ * until it is about to be modified, and pinned while a reader is copying it
+ * from the live buffer (which the writer must wait out). A chunk modified once
+ * the store was full is lost. Non-negative states index the store. */
+#define CHUNK_LIVE      (-1)
+#define CHUNK_PINNED    (-2)
+#define CHUNK_LOST      (-3)
+
 /* block_pos is an integral quantity that uniquely determines a block in a
  * stringv. It is defined in terms of a string_pos because in a one-to-one
  * stringv (ie. stringv->block_used == stringv->string_count) a string_pos
@@ -33,8 +117,6 @@ static int valid_block_range(
         block_pos first,
         block_pos last);
 
-#endif /* NDEBUG */
-
 /* Checks that a string_pos is valid, given the corresponding stringv. A
  * string_pos is valid for *reads* if it is in the interval
  * [0, s->string_count). However, a string_pos is valid for *writes* if it is
@@ -43,6 +125,25 @@ static int valid_block_range(
  */
 static int valid_string_pos(struct stringv const *s, string_pos sn, int read);
 
+#endif /* NDEBUG */
+
+/* Checks that a position counting live strings only is valid, in the same
+ * read/write sense as valid_string_pos. This is the check applied to the
+ * positions passed to the public functions. */
+static int valid_live_pos(struct stringv const *s, string_pos n, int read);
+
+/* Checks the string passed to a function that writes one: it must be
+ * non-empty and contain no NUL, which would end it early in its blocks or,
+ * as its first char, mark it as tombstoned. */
+static int valid_string(char const *string, size_t length);
+
+/* Converts a position counting live strings only into the string_pos of the
+ * same string, which also counts tombstoned strings. When the stringv has no
+ * tombstones the two are identical. */
+static string_pos live_pos_to_string_pos(
+        struct stringv const *s,
+        string_pos n);
+
 /* Given a string_pos, returns the corresponding block pos. */
 static block_pos string_pos_to_block_pos(
         struct stringv const *s,
@@ -71,6 +172,71 @@ static block_pos clear_block_range(
         block_pos first,
         block_pos last);
 
+/* Fills size chars at dest with zeros. Equivalent to memset, except that
+ * regions of at least STRINGV_STREAM_THRESHOLD chars are written with non-
+ * temporal stores. */
+static void bulk_zero(char *dest, size_t size);
+
+/* Copies size chars from source to dest, which must not overlap. Equivalent
+ * to memcpy, except that regions of at least STRINGV_STREAM_THRESHOLD chars
+ * are written with non-temporal stores. */
+static void bulk_copy(
+        char *STRINGV_RESTRICT dest,
+        char const *STRINGV_RESTRICT source,
+        size_t size);
+
+/* Returns the length of the string at the start of a block, which must be
+ * terminated within the block (as every string in a one-to-one stringv is).
+ * The search does not read past the end of the block. */
+static size_t block_string_length(char const *block, size_t block_size);
+
+/* Copies the string at the start of a block to dest and returns the end of
+ * the copy. Whole 16 char vectors may be copied past the end of the string,
+ * into the padding of its block, as long as they stay within the block and
+ * before end; the extra chars are expected to be overwritten by the caller.
+ */
+static char *join_block_string(
+        char *STRINGV_RESTRICT dest,
+        char const *end,
+        char const *block,
+        size_t length,
+        size_t block_size);
+
+/* Writes a string that fits in a single unused block to the start of that
+ * block. readable is the number of chars that may be read from string, which
+ * may exceed its length. The rest of the block must already be zero, as
+ * unused blocks are. */
+static void import_block_string(
+        block_ptr block,
+        char const *STRINGV_RESTRICT string,
+        size_t length,
+        size_t readable,
+        size_t block_size);
+
+/* Returns entry i of an array of column offsets, which are 64 bit if large is
+ * nonzero and 32 bit otherwise. */
+static int64_t column_offset(void const *offsets, int large, int i);
+
+/* Sets entry i of an array of column offsets, as column_offset. */
+static void set_column_offset(void *offsets, int large, int i, int64_t value);
+
+/* Implements stringv_column_export and stringv_column_export64 */
+static int export_column(
+        struct stringv_column_cursor *STRINGV_RESTRICT cursor,
+        void *STRINGV_RESTRICT offsets,
+        int large,
+        char *STRINGV_RESTRICT data,
+        int max_count,
+        size_t data_size);
+
+/* Implements stringv_column_import and stringv_column_import64 */
+static int import_column(
+        struct stringv *STRINGV_RESTRICT s,
+        void const *STRINGV_RESTRICT offsets,
+        int large,
+        char const *STRINGV_RESTRICT data,
+        int count);
+
 /* Determines how many blocks would be required to store the given length
  * of data (in chars; NOT including the NUL terminator) in the given
  * stringv. */
@@ -85,29 +251,59 @@ static int is_block_terminal(struct stringv const *s, block_pos bn);
  * string_pos. */
 static int blocks_used_by(struct stringv const *s, string_pos sn);
 
-/* Copies blocks from a source stringv to a destination stringv assuming that
- * source and destination have identical block sizes and destination has
- * the same or a higher block total. Returns the number of strings copied
- * (which is always equal to source->string_count). */
+/* Given the block position of the start of a string, returns the block
+ * position of the start of the string following it (or the one-past-the-end
+ * block position of the used blocks, if there is none). */
+static block_pos next_string_block_pos(struct stringv const *s, block_pos bn);
+
+/* Determines if the string starting at the given block has been tombstoned.
+ * Live strings are never empty, so a string is dead iff its first char is
+ * NUL. */
+static int is_string_dead(struct stringv const *s, block_pos bn);
+
+/* Removes the string at the given string_pos, shifting the blocks to its
+ * right over it if required. Unlike stringv_remove, sn counts tombstoned
+ * strings. Returns 1. */
+static int remove_string(struct stringv *stringv, string_pos sn);
+
+/* Appends the blocks of a source stringv to a destination stringv assuming
+ * that source and destination have identical block sizes and destination has
+ * at least source->block_used free blocks. Returns the number of live strings
+ * appended (which is always all of them). */
 static int copy_blockwise_bijective(
         struct stringv *STRINGV_RESTRICT dest,
         struct stringv const *STRINGV_RESTRICT source);
 
-/* Copies blocks from a source stringv to a destination stringv assuming that
+/* Appends blocks from a source stringv to a destination stringv assuming that
  * the source stringv has as many blocks as strings, and the destination
- * stringv has the same or greater block size. Returns the number of strings
- * copied (which is always equal to source->string_count). */
+ * stringv has the same or greater block size and at least
+ * source->block_used free blocks. Returns the number of live strings appended
+ * (which is always all of them). */
 static int copy_blockwise_injective(
         struct stringv *STRINGV_RESTRICT dest,
         struct stringv const *STRINGV_RESTRICT source);
 
-/* Copies strings from a source stringv to a destination stringv. Returns the
- * number of strings copied, which may be less than the source's string count
- * depending on the destination stringv's block size and block total. */
+/* Appends strings from a source stringv to a destination stringv. Returns the
+ * number of strings appended, which may be less than the source's live string
+ * count depending on the destination stringv's block size and free blocks. */
 static int copy_stringwise(
         struct stringv *STRINGV_RESTRICT dest,
         struct stringv const *STRINGV_RESTRICT source);
 
+/* Appends the live strings of a source stringv, starting with the one at
+ * block *next, to a destination stringv with its unused blocks still to be
+ * zeroed. Each string is copied once, with its terminal block searched for
+ * its end, and the rest of its last destination block is zeroed. Returns 1
+ * once every string is appended, or 0 if the destination ran out of room,
+ * with *next set to the block of the first string not appended. */
+static int reblock_strings(
+        struct stringv *STRINGV_RESTRICT dest,
+        struct stringv const *STRINGV_RESTRICT source,
+        block_pos *next);
+
+/* Implements stringv_reblock for a NULL buffer, with the same results. */
+static int reblock_in_place(struct stringv *s, int block_size);
+
 /* Shifts a range of blocks by the given offset. The offset may be negative
  * (indicating a left shift) or positive (indicating a right shift). In the
  * case of a right shift, the gap created is zeroed. Note that a right shift
@@ -121,6 +317,68 @@ static block_pos shift_blocks(
         block_pos last,
         int offset);
 
+/* Exchanges size chars between p and q, which must not overlap. */
+static void swap_chars(
+        char *STRINGV_RESTRICT p,
+        char *STRINGV_RESTRICT q,
+        size_t size);
+
+/* Exchanges the contents of the block ranges [a, a + count) and
+ * [b, b + count), which must not overlap. */
+static void swap_block_ranges(
+        struct stringv *s,
+        block_pos a,
+        block_pos b,
+        int count);
+
+/* Reverses the order of the blocks in the range [first, last). */
+static void reverse_blocks(struct stringv *s, block_pos first, block_pos last);
+
+/* Rotates the blocks in the range [first, last) so that middle becomes the
+ * first block. Returns the new position of the block at first. */
+static block_pos rotate_blocks(
+        struct stringv *s,
+        block_pos first,
+        block_pos middle,
+        block_pos last);
+
+/* Stably partitions the count strings stored in the block range
+ * [first, last), returning the block position of the first string not
+ * selected by the predicate. The number of selected strings is added to
+ * selected. */
+static block_pos stable_partition_blocks(
+        struct stringv *s,
+        block_pos first,
+        block_pos last,
+        int count,
+        string_predicate predicate,
+        void *context,
+        int *selected);
+
+/* Must be called before the block range [first, last) of a stringv is
+ * modified, so that any snapshotted chunks in the range can be preserved. Does
+ * nothing if the stringv has no snapshot. */
+static void prepare_write(struct stringv *s, block_pos first, block_pos last);
+
+/* Preserves a chunk of a snapshot in its store (or marks it lost if the store
+ * is full), unless that has already been done. */
+static void preserve_chunk(struct stringv_snapshot *snapshot, int chunk);
+
+/* Returns the size of a chunk of a snapshot, in chars. Only the last chunk
+ * may be smaller than the chunk size. */
+static size_t chunk_bytes(struct stringv_snapshot const *snapshot, int chunk);
+
+/* Atomically compares the state of a chunk with *expected and, if they are
+ * equal, replaces it with desired. Otherwise, the current state is stored in
+ * *expected. Returns nonzero if the state was replaced. */
+static int chunk_state_cas(int *state, int *expected, int desired);
+
+/* Atomically loads the state of a chunk. */
+static int chunk_state_load(int const *state);
+
+/* Atomically stores the state of a chunk, releasing prior writes. */
+static void chunk_state_store(int *state, int value);
+
 /* Writes data to the given block position, returning a pointer to that same
  * block. This function does no bounds checking, nor does it zero the remain-
  * der of the block. Both of these conditions are assumed. */
@@ -131,6 +389,141 @@ static block_ptr block_write(
         block_pos first,
         block_pos last);
 
+/* Prepares each candidate analysis to accumulate strings */
+static void analysis_begin(struct stringv_block_analysis *analyses, int count);
+
+/* Accumulates a string of the given (nonzero) length into each candidate
+ * analysis. Until analysis_end, padding holds the unused chars, multi_block
+ * the number of multi-block strings, and lookup_cost the sum of the strings'
+ * starting block positions. */
+static void analysis_add(
+        struct stringv_block_analysis *analyses,
+        int count,
+        size_t length);
+
+/* Turns the accumulated sums of strings strings into the reported fractions
+ * and costs, scores each candidate, and returns the block size of the best. */
+static int analysis_end(
+        struct stringv_block_analysis *analyses,
+        int count,
+        int strings,
+        double memory_weight,
+        double latency_weight);
+
+/* Checks the arguments common to both analysis functions */
+static int valid_analysis(
+        double memory_weight,
+        double latency_weight,
+        struct stringv_block_analysis const *analyses,
+        int count);
+
+#if defined(STRINGV_TRACE)
+
+/* The registered trace hook, and the context to pass it. They are written
+ * under a sequence counter, which is odd while they are being changed, so
+ * that a thread tracing an event never pairs one hook with another's
+ * context. */
+static stringv_trace_hook trace_hook = NULL;
+static void *trace_context = NULL;
+static unsigned trace_sequence = 0;
+
+/* Reads the registered hook and its context as a consistent pair, returning
+ * the hook and storing the context to context */
+static stringv_trace_hook load_trace_hook(void **context);
+
+/* Returns the time on the monotonic clock, in nanoseconds, or 0 if there is
+ * no monotonic clock */
+static uint64_t trace_time(void);
+
+/* Passes an event to the trace hook, if one is registered, and fires the
+ * corresponding USDT probe if STRINGV_USDT is defined. */
+static void trace(
+        enum stringv_trace_op op,
+        int exit,
+        struct stringv const *s,
+        size_t size,
+        string_pos sn,
+        long result);
+
+/* Returns the bytes in the used blocks of s, or 0 if s is NULL */
+static size_t used_bytes(struct stringv const *s);
+
+/* The traced functions, under the names given to them above */
+static struct stringv *stringv_init(
+        struct stringv *stringv,
+        char *buf,
+        int buf_size,
+        int block_size);
+static struct stringv *stringv_clear(struct stringv *stringv);
+static int stringv_copy(struct stringv *dest, struct stringv const *source);
+static int stringv_append(struct stringv *dest, struct stringv const *source);
+static int stringv_reblock(
+        struct stringv *stringv,
+        int block_size,
+        char *buf,
+        int buf_size,
+        struct stringv_reblock_progress *progress);
+static char const *stringv_push_back(
+        struct stringv *stringv,
+        char const *string,
+        size_t length);
+static char const *stringv_push_front(
+        struct stringv *stringv,
+        char const *string,
+        size_t length);
+static char const *stringv_insert(
+        struct stringv *stringv,
+        char const *string,
+        size_t length,
+        string_pos sn);
+static char const *stringv_replace(
+        struct stringv *stringv,
+        string_pos sn,
+        char const *string,
+        size_t length);
+static size_t stringv_split_c(
+        struct stringv *stringv,
+        char const *string,
+        size_t length,
+        int separator);
+static size_t stringv_split_s(
+        struct stringv *stringv,
+        char const *string,
+        size_t length,
+        char const *separator,
+        size_t separator_length);
+static size_t stringv_join(
+        struct stringv const *stringv,
+        char const *separator,
+        size_t separator_length,
+        char *out,
+        size_t out_size);
+static int stringv_column_import(
+        struct stringv *stringv,
+        int32_t const *offsets,
+        char const *data,
+        int count);
+static int stringv_column_import64(
+        struct stringv *stringv,
+        int64_t const *offsets,
+        char const *data,
+        int count);
+static int stringv_remove(struct stringv *stringv, string_pos sn);
+static int stringv_tombstone(struct stringv *stringv, string_pos sn);
+static int stringv_compact(struct stringv *stringv);
+static int stringv_swap(struct stringv *stringv, string_pos a, string_pos b);
+static int stringv_rotate(struct stringv *stringv, string_pos middle);
+static int stringv_reverse(struct stringv *stringv);
+static int stringv_stable_partition(
+        struct stringv *stringv,
+        string_predicate predicate,
+        void *context);
+static int stringv_snapshot_copy(
+        struct stringv *dest,
+        struct stringv_snapshot *snapshot);
+
+#endif /* defined(STRINGV_TRACE) */
+
 struct stringv *stringv_init(
         struct stringv *stringv,
         char *buf,
@@ -148,7 +541,8 @@ struct stringv *stringv_init(
     stringv->buf = buf;
     stringv->block_total = buf_size / block_size;
     stringv->block_size = block_size;
-    stringv->block_used = stringv->string_count = 0;
+    stringv->block_used = stringv->string_count = stringv->dead_count = 0;
+    stringv->snapshot = NULL;
     clear_block_range(stringv, 0, stringv->block_total);
 
     return stringv;
@@ -156,20 +550,26 @@ struct stringv *stringv_init(
 
 char const *stringv_get(struct stringv const *stringv, string_pos sn)
 {
-    if (!stringv || !valid_string_pos(stringv, sn, 1)) {
+    if (!stringv || !valid_live_pos(stringv, sn, 1)) {
         return NULL;
     }
 
     assert(valid_stringv(stringv));
-    return string_pos_to_block_ptr(stringv, sn);
+    return string_pos_to_block_ptr(
+            stringv,
+            live_pos_to_string_pos(stringv, sn));
 }
 
 struct stringv *stringv_clear(struct stringv *stringv)
 {
     if (stringv) {
         assert(valid_stringv(stringv));
+
+        /* The blocks past block_used are already zero, so clearing them
+         * doesn't modify any snapshotted chunk. */
+        prepare_write(stringv, 0, stringv->block_used);
         clear_block_range(stringv, 0, stringv->block_total);
-        stringv->block_used = stringv->string_count = 0;
+        stringv->block_used = stringv->string_count = stringv->dead_count = 0;
     }
 
     return stringv;
@@ -184,36 +584,123 @@ int stringv_copy(struct stringv *dest, struct stringv const *source)
     assert(valid_stringv(dest));
     assert(valid_stringv(source));
 
-    /* The destination needs to be cleared. */
+    /* The destination needs to be cleared, after which a copy is just an
+     * append. */
     stringv_clear(dest);
+    return stringv_append(dest, source);
+}
+
+int stringv_append(struct stringv *dest, struct stringv const *source)
+{
+    int free_blocks = 0;
+
+    if (!dest || !source) {
+        return 0;
+    }
+
+    assert(valid_stringv(dest));
+    assert(valid_stringv(source));
 
     /* If the source stringv is empty, then we don't need to do anything. */
     if (source->string_count == 0) {
         return 0;
     }
 
+    free_blocks = dest->block_total - dest->block_used;
+
     /* If the destination stringv has the same block size, then we can just
-     * memcpy the entire block over if it also has a greater than or equal
-     * block total. */
+     * memcpy the entire block range over if it also has enough free
+     * blocks. */
     if (dest->block_size == source->block_size
-            && dest->block_total >= source->block_used) {
+            && free_blocks >= source->block_used) {
+        prepare_write(
+                dest,
+                dest->block_used,
+                dest->block_used + source->block_used);
+        COUNT(blockwise_copies, 1);
         return copy_blockwise_bijective(dest, source);
     }
 
     /* If the destination stringv has a block size greater than or equal to the
      * source's block size, each source string fits in a single source block,
-     * and there are at least as many total destination blocks as there are
+     * and there are at least as many free destination blocks as there are
      * used source blocks, then we don't need to compute the length of each
      * string before copying, as we know all strings will fit. */
     if (dest->block_size >= source->block_size
             && is_one_to_one(source)
-            && dest->block_total >= source->block_used) {
+            && free_blocks >= source->block_used) {
+        prepare_write(
+                dest,
+                dest->block_used,
+                dest->block_used + source->block_used);
+        COUNT(blockwise_copies, 1);
         return copy_blockwise_injective(dest, source);
     }
 
+    prepare_write(dest, dest->block_used, dest->block_total);
+    COUNT(stringwise_copies, 1);
     return copy_stringwise(dest, source);
 }
 
+int stringv_reblock(
+        struct stringv *stringv,
+        int block_size,
+        char *buf,
+        int buf_size,
+        struct stringv_reblock_progress *progress)
+{
+    struct stringv dest = STRINGV_ZERO;
+    struct stringv_reblock_progress start = {0, 0, 0};
+    int done = 0;
+
+    if (!stringv || block_size <= 1 || stringv->snapshot) {
+        return -1;
+    }
+
+    assert(valid_stringv(stringv));
+
+    if (!buf) {
+        return reblock_in_place(stringv, block_size);
+    }
+
+    if (!progress) {
+        progress = &start;
+    }
+
+    if (buf == stringv->buf
+            || buf_size < block_size
+            || progress->next_block < 0
+            || progress->next_block > stringv->block_used
+            || progress->block_used < 0
+            || progress->block_used > buf_size / block_size
+            || progress->string_count < 0
+            || progress->string_count > progress->block_used) {
+        return -1;
+    }
+
+    /* When resuming, the strings already reblocked are at the start of buf,
+     * and only the blocks after them need zeroing. */
+    dest.buf = buf;
+    dest.block_total = buf_size / block_size;
+    dest.block_size = block_size;
+    dest.block_used = progress->block_used;
+    dest.string_count = progress->string_count;
+
+    done = reblock_strings(&dest, stringv, &progress->next_block);
+    if (dest.block_used < dest.block_total) {
+        clear_block_range(&dest, dest.block_used, dest.block_total);
+    }
+
+    progress->block_used = dest.block_used;
+    progress->string_count = dest.string_count;
+    if (!done) {
+        return 0;
+    }
+
+    *stringv = dest;
+    return 1;
+}
+
 char const *stringv_push_back(
         struct stringv *stringv,
         char const *string,
@@ -221,7 +708,7 @@ char const *stringv_push_back(
 {
     int blocks_req = 0;
 
-    if (!stringv || !string || length == 0) {
+    if (!stringv || !valid_string(string, length)) {
         return NULL;
     }
 
@@ -233,11 +720,16 @@ char const *stringv_push_back(
      * capacity check. */
     blocks_req = blocks_required(stringv, length);
     if (stringv->block_used + blocks_req > stringv->block_total) {
+        COUNT(capacity_failures, 1);
         return NULL;
     }
 
     /* If there is enough room, all we need to do is write to the end of the
      * stringv and bump the string and block counts as appropriate. */
+    prepare_write(
+            stringv,
+            stringv->block_used,
+            stringv->block_used + blocks_req);
     return block_write(
             stringv,
             string,
@@ -264,9 +756,8 @@ char const *stringv_insert(
     block_pos write_pos = 0;
 
     if (!stringv
-            || !string
-            || length <= 0
-            || !valid_string_pos(stringv, sn, 0)) {
+            || !valid_string(string, length)
+            || !valid_live_pos(stringv, sn, 0)) {
         return NULL;
     }
 
@@ -274,13 +765,16 @@ char const *stringv_insert(
 
     /* An insertion at the end of the stringv is equivalent to a push_back.
      * This also handles insertions into an empty stringv */
-    if (sn == stringv->string_count) {
+    if (sn == stringv->string_count - stringv->dead_count) {
         return stringv_push_back(stringv, string, length);
     }
 
+    sn = live_pos_to_string_pos(stringv, sn);
+
     /* Ensure there is sufficient room in the stringv */
     blocks_req = blocks_required(stringv, length);
     if (stringv->block_used + blocks_req > stringv->block_total) {
+        COUNT(capacity_failures, 1);
         return NULL;
     }
 
@@ -289,9 +783,11 @@ char const *stringv_insert(
     /* We know that the insertion is occurring internally, so we will need
      * to shift blocks *right* to accomodate this. We also know that there
      * is sufficient space to do so. */
+    write_pos = string_pos_to_block_pos(stringv, sn);
+    prepare_write(stringv, write_pos, stringv->block_used + blocks_req);
     write_pos = shift_blocks(
             stringv,
-            string_pos_to_block_pos(stringv, sn),
+            write_pos,
             stringv->block_used,
             blocks_req);
 
@@ -303,6 +799,89 @@ char const *stringv_insert(
             write_pos + blocks_req);
 }
 
+char const *stringv_replace(
+        struct stringv *stringv,
+        string_pos sn,
+        char const *string,
+        size_t length)
+{
+    block_pos bn = 0;
+    block_ptr write_ptr = NULL;
+    int blocks_old = 0, blocks_new = 0;
+
+    if (!stringv
+            || !valid_string(string, length)
+            || !valid_live_pos(stringv, sn, 1)) {
+        return NULL;
+    }
+
+    assert(valid_stringv(stringv));
+
+    /* Check for room before locating the string: the existing string frees
+     * at least one block, so a replacement needing only one block always
+     * fits. */
+    blocks_new = blocks_required(stringv, length);
+    if (stringv->block_used + blocks_new - 1 > stringv->block_total) {
+        COUNT(capacity_failures, 1);
+        return NULL;
+    }
+
+    bn = string_pos_to_block_pos(stringv, live_pos_to_string_pos(stringv, sn));
+    blocks_old = next_string_block_pos(stringv, bn) - bn;
+
+    if (stringv->block_used + blocks_new - blocks_old > stringv->block_total) {
+        COUNT(capacity_failures, 1);
+        return NULL;
+    }
+
+    /* A replacement of the same size only touches the string's own blocks;
+     * otherwise everything after it moves too. */
+    prepare_write(
+            stringv,
+            bn,
+            blocks_new == blocks_old
+                ? bn + blocks_old
+                : stringv->block_used + (blocks_new > blocks_old
+                    ? blocks_new - blocks_old
+                    : 0));
+
+    if (blocks_new != blocks_old) {
+        if (bn + blocks_old < stringv->block_used) {
+            /* Move the strings to the right of the replaced string exactly
+             * once. A left shift leaves stale blocks at the end of the used
+             * blocks, which must be cleared; a right shift zeroes the gap
+             * itself. */
+            (void)shift_blocks(
+                    stringv,
+                    bn + blocks_old,
+                    stringv->block_used,
+                    blocks_new - blocks_old);
+
+            if (blocks_new < blocks_old) {
+                clear_block_range(
+                        stringv,
+                        stringv->block_used + blocks_new - blocks_old,
+                        stringv->block_used);
+            }
+        } else if (blocks_new < blocks_old) {
+            /* The replaced string is the last one and is shrinking, so the
+             * blocks it no longer needs must be cleared. */
+            clear_block_range(stringv, bn + blocks_new, bn + blocks_old);
+        }
+
+        stringv->block_used += blocks_new - blocks_old;
+    }
+
+    /* Overwrite the string, then zero whatever remains of its old contents
+     * after it, up to the end of its last block. */
+    write_ptr = memcpy(block_pos_to_block_ptr(stringv, bn), string, length);
+    memset(write_ptr + length,
+            0,
+            (size_t)(blocks_new * stringv->block_size) - length);
+
+    return write_ptr;
+}
+
 size_t stringv_split_c(
         struct stringv *stringv,
         char const *string,
@@ -380,354 +959,2379 @@ size_t stringv_split_s(
     return length;
 }
 
-int stringv_remove(struct stringv *stringv, string_pos sn)
+size_t stringv_join(
+        struct stringv const *stringv,
+        char const *separator,
+        size_t separator_length,
+        char *out,
+        size_t out_size)
 {
-    block_pos bn = 0;
-    int offset = 0;
-
-    if (!stringv
-            || !valid_string_pos(stringv, sn, 1)
-            || stringv->string_count == 0) {
+    size_t const block_size = stringv ? (size_t)stringv->block_size : 0;
+    size_t total = 0, length = 0;
+    char const *iter = NULL;
+    char *dest = out;
+    block_ptr block = NULL;
+    int live = 0;
+
+    if (!stringv || (!separator && separator_length > 0)) {
         return 0;
     }
 
-    /* If there is only one string in the stringv, then it is the one specified
-     * by sn since the string pos is valid for reads. So clear the stringv. */
-    if (stringv->string_count == 1) {
-       (void)stringv_clear(stringv);
-       return 1;
-    }
+    assert(valid_stringv(stringv));
 
-    bn = string_pos_to_block_pos(stringv, sn);
-    assert(valid_block_pos(stringv, bn));
+    /* Compute the exact length first, so nothing is written unless it all
+     * fits. In a one-to-one stringv, each block holds one string, and dead
+     * strings are exactly the empty ones. */
+    if (is_one_to_one(stringv)) {
+        for (block = stringv->buf;
+                block != stringv_end(stringv);
+                block += block_size) {
+            length = block_string_length(block, block_size);
+            total += length;
+            live += length > 0;
+        }
+    } else {
+        for (iter = stringv_begin(stringv);
+                iter != stringv_end(stringv);
+                iter = stringv_next(stringv, iter)) {
+            total += strlen(iter);
+            ++live;
+        }
+    }
 
-    /* Otherwise, if the string position refers to the string at the end of the
-     * stringv, then we can rewind the stringv's block_used field and clear
-     * the end of the buffer. This way we avoid shifting blocks. */
-    if (sn == stringv->string_count - 1) {
-        /* Clear the last string. clear_block_range returns bn, which
-         * will be the number of used blocks in the stringv after the last
-         * string is removed. */
-        stringv->block_used = clear_block_range(
-                stringv,
-                bn,
-                stringv->block_used);
+    if (live > 1) {
+        total += (size_t)(live - 1) * separator_length;
+    }
 
-        --stringv->string_count;
-        return 1;
+    if (!out || total >= out_size) {
+        return total;
     }
 
-    /* Finally, if the insertion is internal (there are strings to the right
-     * of the string we want to remove) then we can shift the blocks over the
-     * string to be removed. We first compute the shift offset, which is the
-     * number of blocks used by the string to remove. */
-    offset = blocks_used_by(stringv, sn);
-    clear_block_range(
-            stringv,
-            shift_blocks(stringv, bn + offset, stringv->block_used, -offset),
-            stringv->block_used);
+    /* Separators go before every string but the first. An empty separator
+     * may be NULL, which memcpy mustn't be given even to copy nothing. */
+    if (is_one_to_one(stringv)) {
+        for (block = stringv->buf;
+                block != stringv_end(stringv);
+                block += block_size) {
+            length = block_string_length(block, block_size);
+            if (length > 0) {
+                if (dest != out && separator_length > 0) {
+                    memcpy(dest, separator, separator_length);
+                    dest += separator_length;
+                }
+                dest = join_block_string(
+                        dest, out + total, block, length, block_size);
+            }
+        }
+    } else {
+        for (iter = stringv_begin(stringv);
+                iter != stringv_end(stringv);
+                iter = stringv_next(stringv, iter)) {
+            if (dest != out && separator_length > 0) {
+                memcpy(dest, separator, separator_length);
+                dest += separator_length;
+            }
+            length = strlen(iter);
+            memcpy(dest, iter, length);
+            dest += length;
+        }
+    }
 
-    --stringv->string_count;
-    stringv->block_used -= offset;
-    return 1;
+    assert(dest == out + total);
+    *dest = '\0';
+    return total;
 }
 
-char const *stringv_begin(struct stringv const *stringv)
+struct stringv_column_cursor *stringv_column_begin(
+        struct stringv_column_cursor *cursor,
+        struct stringv const *stringv)
 {
-    assert(stringv);
-    assert(valid_stringv(stringv));
-    return stringv->buf;
-}
+    if (!cursor || !stringv) {
+        return NULL;
+    }
 
-char const *stringv_end(struct stringv const *stringv)
-{
-    assert(stringv);
     assert(valid_stringv(stringv));
-    return stringv->buf + (stringv->block_size * stringv->block_used);
+
+    cursor->stringv = stringv;
+    cursor->iter = stringv_begin(stringv);
+    return cursor;
 }
 
-char const *stringv_next(struct stringv const *stringv, char const *iter)
+int stringv_column_export(
+        struct stringv_column_cursor *cursor,
+        int32_t *offsets,
+        char *data,
+        int max_count,
+        size_t data_size)
 {
-    assert(stringv);
-    assert(valid_stringv(stringv));
-    assert(iter);
-
-    do {
-        iter += stringv->block_size;
-    } while (*(iter - 1) != '\0');
-
-    return iter;
+    return export_column(cursor, offsets, 0, data, max_count, data_size);
 }
 
-#ifndef NDEBUG
-
-int valid_stringv(struct stringv const *s)
+int stringv_column_export64(
+        struct stringv_column_cursor *cursor,
+        int64_t *offsets,
+        char *data,
+        int max_count,
+        size_t data_size)
 {
-    return s
-        && s->buf
-        && s->block_total > 0
-        && s->block_size > 0
-        && s->block_used >= 0 && s->block_used <= s->block_total
-        && s->string_count >= 0 && s->string_count <= s->block_total;
+    return export_column(cursor, offsets, 1, data, max_count, data_size);
 }
 
-int valid_block_pos(struct stringv const *s, block_pos bn)
+int stringv_column_import(
+        struct stringv *stringv,
+        int32_t const *offsets,
+        char const *data,
+        int count)
 {
-    /* A block pos is valid if it is in the interval [0, s->block_total]. The
-     * right end of the interval includes the block total since block positions
-     * can be used as ranges, and we want to allow one-past-the-end positions
-     * to make range arithmetic simpler. */
-    return  bn >= 0 && bn <= s->block_total;
+    return import_column(stringv, offsets, 0, data, count);
 }
 
-int valid_block_range(struct stringv const *s, block_pos first, block_pos last)
+int stringv_column_import64(
+        struct stringv *stringv,
+        int64_t const *offsets,
+        char const *data,
+        int count)
 {
-    return s
-        && valid_block_pos(s, first)
-        && (valid_block_pos(s, last) || last == s->block_used)
-        && (first < last);
+    return import_column(stringv, offsets, 1, data, count);
 }
 
-#endif /* NDEBUG */
-
-int valid_string_pos(struct stringv const *s, string_pos sn, int read)
+int stringv_remove(struct stringv *stringv, string_pos sn)
 {
-    return sn >= 0 && (read ? sn < s->string_count : sn <= s->string_count);
+    if (!stringv
+            || !valid_live_pos(stringv, sn, 1)
+            || stringv->string_count == 0) {
+        return 0;
+    }
+
+    assert(valid_stringv(stringv));
+    return remove_string(stringv, live_pos_to_string_pos(stringv, sn));
 }
 
-block_pos string_pos_to_block_pos(struct stringv const *s, string_pos sn)
+int stringv_tombstone(struct stringv *stringv, string_pos sn)
 {
-    block_pos bn = 0;
-
-    assert(s && valid_stringv(s));
-    assert(valid_string_pos(s, sn, 0));
+    block_pos bn = 0, end = 0, i = 0;
 
-    /* The first string always starts at the start of the stringv's buffer. */
-    if (sn == 0) {
+    if (!stringv || !valid_live_pos(stringv, sn, 1)) {
         return 0;
     }
 
-    /* If the stringv's string count is equal to the number of used blocks,
-     * then the block position corresponding to any string position is simply
-     * that string position. */
-    if (is_one_to_one(s)) {
-        return sn;
+    assert(valid_stringv(stringv));
+    sn = live_pos_to_string_pos(stringv, sn);
+
+    /* The last string can be removed by rewinding block_used, which is
+     * as cheap as leaving a tombstone and doesn't need compacting later. */
+    if (sn == stringv->string_count - 1) {
+        return remove_string(stringv, sn);
     }
 
-    while (sn > 0) {
-        if (is_block_terminal(s, bn)) {
-            --sn;
-        }
-        ++bn;
+    bn = string_pos_to_block_pos(stringv, sn);
+    end = next_string_block_pos(stringv, bn);
+    prepare_write(stringv, bn, end);
+
+    /* Zero the whole string, so that no stale chars are left in its blocks to
+     * be moved about later. The last char of each non-terminal block is kept,
+     * since that is what joins the blocks into one (dead) string. */
+    for (i = bn; i < end - 1; ++i) {
+        memset(block_pos_to_block_ptr(stringv, i),
+                0,
+                (size_t)stringv->block_size - 1);
     }
 
-    assert(sn == 0);
-    return bn;
+    (void)clear_block_range(stringv, end - 1, end);
+    ++stringv->dead_count;
+
+    if ((double)stringv->dead_count * 100.
+            > (double)stringv->string_count * STRINGV_COMPACT_PERCENT) {
+        (void)stringv_compact(stringv);
+    }
+
+    return 1;
 }
 
-block_ptr block_pos_to_block_ptr(struct stringv const *s, block_pos bn)
+int stringv_compact(struct stringv *stringv)
 {
-    assert(s && valid_stringv(s));
-    assert(valid_block_pos(s, bn));
-    return s->buf + bn * s->block_size;
+    block_pos read = 0, write = 0, run = 0, next = 0;
+    int freed = 0;
+
+    if (!stringv) {
+        return 0;
+    }
+
+    assert(valid_stringv(stringv));
+
+    if (stringv->dead_count == 0) {
+        return 0;
+    }
+
+    /* run is the start of the current run of live strings. Each time a dead
+     * string ends a run, the whole run is moved left over the gap left by
+     * previous dead strings. The counts aren't touched until the end, so
+     * next_string_block_pos sees the stringv as it was before compaction;
+     * this is safe since the blocks ahead of read are never moved. */
+    while (read < stringv->block_used) {
+        next = next_string_block_pos(stringv, read);
+
+        if (is_string_dead(stringv, read)) {
+            /* Nothing before the first dead string is moved */
+            if (run == 0 && write == 0) {
+                prepare_write(stringv, read, stringv->block_used);
+            }
+
+            if (run < read) {
+                write = write == run
+                    ? read
+                    : shift_blocks(stringv, run, read, write - run);
+            }
+
+            run = next;
+        }
+
+        read = next;
+    }
+
+    if (run < read) {
+        write = write == run
+            ? read
+            : shift_blocks(stringv, run, read, write - run);
+    }
+
+    freed = stringv->block_used - write;
+    assert(freed > 0);
+    clear_block_range(stringv, write, stringv->block_used);
+
+    stringv->block_used = write;
+    stringv->string_count -= stringv->dead_count;
+    stringv->dead_count = 0;
+    return freed;
 }
 
-block_ptr string_pos_to_block_ptr(struct stringv const *s, string_pos sn)
+struct stringv_stats *stringv_get_stats(
+        struct stringv const *stringv,
+        struct stringv_stats *stats)
 {
-    return block_pos_to_block_ptr(
-            s,
-            string_pos_to_block_pos(s, sn));
+    block_pos bn = 0, next = 0;
+
+    if (!stringv || !stats) {
+        return NULL;
+    }
+
+    assert(valid_stringv(stringv));
+
+    stats->live_count = stringv->string_count - stringv->dead_count;
+    stats->dead_count = stringv->dead_count;
+    stats->dead_blocks = 0;
+
+    if (is_one_to_one(stringv)) {
+        stats->dead_blocks = stringv->dead_count;
+    } else if (stringv->dead_count > 0) {
+        for (bn = 0; bn < stringv->block_used; bn = next) {
+            next = next_string_block_pos(stringv, bn);
+            if (is_string_dead(stringv, bn)) {
+                stats->dead_blocks += next - bn;
+            }
+        }
+    }
+
+    stats->live_blocks = stringv->block_used - stats->dead_blocks;
+    stats->free_blocks = stringv->block_total - stringv->block_used;
+    return stats;
 }
 
-int is_one_to_one(struct stringv const *s)
+int stringv_analyze(
+        size_t const *lengths,
+        int count,
+        double memory_weight,
+        double latency_weight,
+        struct stringv_block_analysis *analyses,
+        int analysis_count)
 {
-    assert(s && valid_stringv(s));
-    return s->string_count == s->block_used;
+    int i = 0, strings = 0;
+
+    if (!lengths
+            || count <= 0
+            || !valid_analysis(
+                memory_weight,
+                latency_weight,
+                analyses,
+                analysis_count)) {
+        return 0;
+    }
+
+    analysis_begin(analyses, analysis_count);
+    for (i = 0; i < count; ++i) {
+        if (lengths[i] > 0) {
+            analysis_add(analyses, analysis_count, lengths[i]);
+            ++strings;
+        }
+    }
+
+    return analysis_end(
+            analyses,
+            analysis_count,
+            strings,
+            memory_weight,
+            latency_weight);
 }
 
-block_pos clear_block_range(struct stringv *s, block_pos first, block_pos last)
+int stringv_analyze_stringv(
+        struct stringv const *stringv,
+        double memory_weight,
+        double latency_weight,
+        struct stringv_block_analysis *analyses,
+        int analysis_count)
 {
-    assert(s && valid_stringv(s));
-    assert(valid_block_range(s, first, last));
+    char const *iter = NULL;
+    int strings = 0;
 
-    memset(block_pos_to_block_ptr(s, first),
-            0,
-            (last - first) * s->block_size);
+    if (!stringv
+            || !valid_analysis(
+                memory_weight,
+                latency_weight,
+                analyses,
+                analysis_count)) {
+        return 0;
+    }
 
-    return first;
+    assert(valid_stringv(stringv));
+
+    analysis_begin(analyses, analysis_count);
+    for (iter = stringv_begin(stringv);
+            iter != stringv_end(stringv);
+            iter = stringv_next(stringv, iter)) {
+        analysis_add(analyses, analysis_count, strlen(iter));
+        ++strings;
+    }
+
+    return analysis_end(
+            analyses,
+            analysis_count,
+            strings,
+            memory_weight,
+            latency_weight);
 }
 
-int blocks_required(struct stringv const *s, size_t length)
+struct stringv_counters *stringv_get_counters(
+        struct stringv_counters *out,
+        int reset)
 {
-    assert(s && valid_stringv(s));
-    assert(length != 0);
+    if (!out) {
+        return NULL;
+    }
 
-    /* Increment the length to accomodate the NUL character. All strings
-     * in a stringv are NUL terminated (with at least one NUL terminator, 
-     * by design. */
-    ++length;
+#if defined(STRINGV_COUNTERS)
+    *out = counters;
+    if (reset) {
+        memset(&counters, 0, sizeof(counters));
+    }
+#else
+    (void)reset;
+    memset(out, 0, sizeof(*out));
+#endif /* defined(STRINGV_COUNTERS) */
 
-    return (int)((length / (size_t)s->block_size) +
-        (length % (size_t)s->block_size != 0));
+    return out;
 }
 
-int is_block_terminal(struct stringv const *s, block_pos bn)
+stringv_trace_hook stringv_set_trace_hook(
+        stringv_trace_hook hook,
+        void *context)
 {
-    assert(s && valid_stringv(s));
-    assert(valid_block_pos(s, bn));
-    return is_one_to_one(s)
-        || *(block_pos_to_block_ptr(s, bn) + s->block_size - 1) == '\0';
+#if defined(STRINGV_TRACE) && defined(__GNUC__)
+    stringv_trace_hook previous = NULL;
+    unsigned const sequence =
+        __atomic_load_n(&trace_sequence, __ATOMIC_RELAXED);
+
+    /* As write_begin and write_end in stringv_concurrent.c */
+    __atomic_store_n(&trace_sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    previous = __atomic_exchange_n(&trace_hook, hook, __ATOMIC_RELAXED);
+    __atomic_store_n(&trace_context, context, __ATOMIC_RELAXED);
+    __atomic_store_n(&trace_sequence, sequence + 2, __ATOMIC_RELEASE);
+    return previous;
+#elif defined(STRINGV_TRACE)
+    stringv_trace_hook const previous = trace_hook;
+
+    trace_hook = hook;
+    trace_context = context;
+    return previous;
+#else
+    (void)hook;
+    (void)context;
+    return NULL;
+#endif /* defined(STRINGV_TRACE) */
 }
 
-int blocks_used_by(struct stringv const *s, string_pos sn)
+int stringv_swap(struct stringv *stringv, string_pos a, string_pos b)
 {
-    block_pos bn = 0;
-    int i = 0;
+    block_pos a_first = 0, a_last = 0, b_first = 0, b_last = 0;
 
-    assert(s && valid_stringv(s));
-    assert(valid_string_pos(s, sn, 1));
+    if (!stringv
+            || !valid_live_pos(stringv, a, 1)
+            || !valid_live_pos(stringv, b, 1)) {
+        return 0;
+    }
 
-    /* If the stringv has the same number of strings as it does used blocks,
-     * then all strings necessarily occupy a single block */
-    if (is_one_to_one(s)) {
+    assert(valid_stringv(stringv));
+
+    if (a == b) {
         return 1;
     }
 
-    /* Otherwise, we iterate through the blocks until we find a terminal block.
-     * This (by definition) ends the string). */
-    bn = string_pos_to_block_pos(s, sn);
-    while (!is_block_terminal(s, bn + i)) {
-        ++i;
+    if (a > b) {
+        string_pos const t = a;
+        a = b;
+        b = t;
     }
 
-    return i;
-}
-
-int copy_blockwise_bijective(
-        struct stringv *dest,
-        struct stringv const *source)
-{
-    assert(dest && valid_stringv(dest));
-    assert(source && valid_stringv(source));
-    assert(source->block_size == dest->block_size);
-    assert(source->block_used <= dest->block_total);
+    a_first = string_pos_to_block_pos(
+            stringv,
+            live_pos_to_string_pos(stringv, a));
+    b_first = string_pos_to_block_pos(
+            stringv,
+            live_pos_to_string_pos(stringv, b));
+    a_last = next_string_block_pos(stringv, a_first);
+    b_last = next_string_block_pos(stringv, b_first);
+    prepare_write(stringv, a_first, b_last);
+
+    /* Strings of equal size (always the case in a one-to-one stringv) can be
+     * exchanged directly. */
+    if (a_last - a_first == b_last - b_first) {
+        swap_block_ranges(stringv, a_first, b_first, a_last - a_first);
+        return 1;
+    }
 
-    memcpy(dest->buf, source->buf, source->block_size * source->block_used);
-    dest->string_count = source->string_count;
-    dest->block_used = source->block_used;
-    return dest->string_count;
+    /* Otherwise the blocks are A M B, where M is everything between the two
+     * strings. Rotating A to the end gives M B A, and rotating B to the front
+     * of M B then gives B M A. */
+    (void)rotate_blocks(stringv, a_first, a_last, b_last);
+    (void)rotate_blocks(
+            stringv,
+            a_first,
+            a_first + (b_first - a_last),
+            a_first + (b_last - a_last));
+    return 1;
 }
 
-int copy_blockwise_injective(
-        struct stringv *dest,
-        struct stringv const *source)
+int stringv_rotate(struct stringv *stringv, string_pos middle)
 {
-    string_pos i = 0;
+    if (!stringv || !valid_live_pos(stringv, middle, 0)) {
+        return 0;
+    }
 
-    assert(dest && valid_stringv(dest));
-    assert(source && valid_stringv(source));
-    assert(is_one_to_one(source));
-    assert(source->block_size <= dest->block_size);
+    assert(valid_stringv(stringv));
 
-    for (i = 0; i < source->string_count; ++i) {
-        /* We know that each string in the source stringv occupies exactly
-         * one block in the destination stringv. So we copy each string
-         * over to each block. Instead of computing the strings length with
-         * strlen, we just copy source->block_size - 1 characters since the
-         * string lengths are bounded by this value. */
-        memcpy(
-                block_pos_to_block_ptr(dest, i),
-                block_pos_to_block_ptr(source, i),
-                source->block_size - 1);
+    if (middle == 0 || middle == stringv->string_count - stringv->dead_count) {
+        return 1;
     }
 
-    dest->string_count = dest->block_used = source->string_count;
-    return dest->string_count;
+    /* Tombstones before the middle string are rotated to the end along with
+     * the live strings, which doesn't affect the order of the live strings. */
+    prepare_write(stringv, 0, stringv->block_used);
+    (void)rotate_blocks(
+            stringv,
+            0,
+            string_pos_to_block_pos(
+                stringv,
+                live_pos_to_string_pos(stringv, middle)),
+            stringv->block_used);
+    return 1;
 }
 
-int copy_stringwise(struct stringv *dest, struct stringv const *source)
+int stringv_reverse(struct stringv *stringv)
 {
-    char const *ith_string = NULL;
-    size_t ith_length = 0;
-    string_pos i = 0;
-    int blocks_req = 0;
+    block_pos first = 0, last = 0;
 
-    assert(dest && valid_stringv(dest));
-    assert(source && valid_stringv(source));
+    if (!stringv) {
+        return 0;
+    }
 
-    for (i = 0; i < source->string_count; ++i) {
-        /* We don't know whether the source string will fit in the destination
-         * stringv, so we need to compute the length of each string,
-         * determine how many blocks it uses, and bail out if the required
-         * number of blocks is greater than the available blocks in dest. */
-        ith_string = string_pos_to_block_ptr(source, i);
-        ith_length = strlen(ith_string);
-        blocks_req = blocks_required(dest, ith_length);
+    assert(valid_stringv(stringv));
 
-        /* If there is insufficient room, stop copying */
-        if (dest->block_used + blocks_req > dest->block_total) {
-            break;
+    if (stringv->block_used < 2) {
+        return 1;
+    }
+
+    prepare_write(stringv, 0, stringv->block_used);
+    reverse_blocks(stringv, 0, stringv->block_used);
+
+    if (is_one_to_one(stringv)) {
+        return 1;
+    }
+
+    /* Reversing the blocks also reversed the blocks within each multi-block
+     * string, so each string now starts with its terminal block. Find each
+     * string by looking for the next terminal block, and reverse it back. */
+    for (first = 0; first < stringv->block_used; first = last) {
+        last = first + 1;
+        while (last < stringv->block_used
+                && !is_block_terminal(stringv, last)) {
+            ++last;
         }
 
-        /* Otherwise, copy the string over */
-        memcpy(
-                block_pos_to_block_ptr(dest, dest->block_used),
-                ith_string,
-                ith_length);
+        if (last - first > 1) {
+            reverse_blocks(stringv, first, last);
+        }
+    }
 
-        /* And increment the string and block counters */
-        dest->block_used += blocks_req;
-        ++dest->string_count;
+    return 1;
+}
+
+int stringv_stable_partition(
+        struct stringv *stringv,
+        string_predicate predicate,
+        void *context)
+{
+    int selected = 0;
+
+    if (!stringv || !predicate) {
+        return -1;
+    }
+
+    assert(valid_stringv(stringv));
+
+    if (stringv->string_count > 0) {
+        prepare_write(stringv, 0, stringv->block_used);
+        (void)stable_partition_blocks(
+                stringv,
+                0,
+                stringv->block_used,
+                stringv->string_count,
+                predicate,
+                context,
+                &selected);
     }
 
-    return dest->string_count;
+    return selected;
 }
 
-block_pos shift_blocks(
-        struct stringv *s,
-        block_pos first,
-        block_pos last,
-        int offset)
+struct stringv_snapshot *stringv_snapshot_take(
+        struct stringv_snapshot *snapshot,
+        struct stringv *stringv,
+        int chunk_size,
+        int *chunk_map,
+        int map_size,
+        char *store,
+        int store_size)
 {
-    assert(s && valid_stringv(s));
-    assert(valid_block_range(s, first, last));
-    assert(offset != 0);
+    size_t size = 0;
+    int i = 0;
 
-    memmove(
-            block_pos_to_block_ptr(s, first + offset),
-            block_pos_to_block_ptr(s, first),
-            (last - first) * s->block_size);
+    if (!snapshot
+            || !stringv
+            || stringv->snapshot
+            || chunk_size <= 0
+            || !chunk_map
+            || store_size < 0
+            || (!store && store_size > 0)) {
+        return NULL;
+    }
 
-    if (offset < 0) {
-        /* If the offset is negative, then the shift is a left shift.
-         * We return the block position of the end of the shifted range. */
-        return last + offset;
-    } else {
-        /* Otherwise, the offset is positive and the shift is a right shift.
-         * We return the block position of the start of the gap that we just
-         * created from the shift after zeroing it out. */
-        clear_block_range(s, first, first + offset);
-        return first;
+    assert(valid_stringv(stringv));
+
+    size = (size_t)stringv->block_used * (size_t)stringv->block_size;
+    snapshot->chunk_count =
+        (int)((size + (size_t)chunk_size - 1) / (size_t)chunk_size);
+    if (map_size < snapshot->chunk_count) {
+        return NULL;
+    }
+
+    for (i = 0; i < snapshot->chunk_count; ++i) {
+        chunk_map[i] = CHUNK_LIVE;
     }
+
+    snapshot->stringv = stringv;
+    snapshot->state = *stringv;
+    snapshot->state.snapshot = NULL;
+    snapshot->store = store;
+    snapshot->chunk_map = chunk_map;
+    snapshot->chunk_size = chunk_size;
+    snapshot->store_total = store_size / chunk_size;
+    snapshot->store_used = 0;
+    snapshot->lost_count = 0;
+
+    stringv->snapshot = snapshot;
+    return snapshot;
 }
 
-block_ptr block_write(
-        struct stringv *s,
-        char const *string,
-        size_t length,
-        block_pos first,
-        block_pos last)
+void stringv_snapshot_release(struct stringv_snapshot *snapshot)
 {
-    block_ptr write_ptr = NULL;
+    if (snapshot && snapshot->stringv) {
+        assert(snapshot->stringv->snapshot == snapshot);
+        snapshot->stringv->snapshot = NULL;
+        snapshot->stringv = NULL;
+    }
+}
 
-    assert(s && valid_stringv(s));
-    assert(string);
-    assert(length > 0);
-    assert(valid_block_range(s, first, last));
+int stringv_snapshot_read(
+        struct stringv_snapshot *snapshot,
+        int chunk,
+        char *out)
+{
+    size_t size = 0;
+    int state = CHUNK_LIVE;
+
+    if (!snapshot
+            || !snapshot->stringv
+            || !out
+            || chunk < 0
+            || chunk >= snapshot->chunk_count) {
+        return -1;
+    }
 
-    write_ptr = memcpy(block_pos_to_block_ptr(s, first), string, length);
-    s->block_used += (last - first);
-    ++s->string_count;
+    size = chunk_bytes(snapshot, chunk);
 
-    return write_ptr;
+    /* Pin a live chunk, so the writer can't modify it until it has been
+     * copied. If another reader has it pinned, wait for it to finish. */
+    while (!chunk_state_cas(
+                &snapshot->chunk_map[chunk],
+                &state,
+                CHUNK_PINNED)) {
+        if (state == CHUNK_LOST) {
+            return -1;
+        }
+
+        if (state >= 0) {
+            memcpy(out,
+                    snapshot->store + (size_t)state
+                        * (size_t)snapshot->chunk_size,
+                    size);
+            return (int)size;
+        }
+
+        state = CHUNK_LIVE;
+    }
+
+    memcpy(out,
+            snapshot->state.buf + (size_t)chunk * (size_t)snapshot->chunk_size,
+            size);
+    chunk_state_store(&snapshot->chunk_map[chunk], CHUNK_LIVE);
+    return (int)size;
 }
+
+int stringv_snapshot_copy(
+        struct stringv *dest,
+        struct stringv_snapshot *snapshot)
+{
+    int i = 0;
+
+    if (!dest
+            || !snapshot
+            || !snapshot->stringv
+            || dest == snapshot->stringv
+            || dest->block_size != snapshot->state.block_size
+            || dest->block_total < snapshot->state.block_used) {
+        return -1;
+    }
+
+    /* The chunks tile the snapshotted blocks, so each one can be read
+     * straight into place. */
+    (void)stringv_clear(dest);
+    prepare_write(dest, 0, snapshot->state.block_used);
+
+    for (i = 0; i < snapshot->chunk_count; ++i) {
+        if (stringv_snapshot_read(
+                    snapshot,
+                    i,
+                    dest->buf + (size_t)i * (size_t)snapshot->chunk_size) < 0) {
+            clear_block_range(dest, 0, snapshot->state.block_used);
+            return -1;
+        }
+    }
+
+    dest->block_used = snapshot->state.block_used;
+    dest->string_count = snapshot->state.string_count;
+    dest->dead_count = snapshot->state.dead_count;
+    return dest->string_count - dest->dead_count;
+}
+
+char const *stringv_begin(struct stringv const *stringv)
+{
+    char const *iter = NULL;
+
+    assert(stringv);
+    assert(valid_stringv(stringv));
+
+    /* stringv_next skips over tombstones after the string it is given, so
+     * only the first string needs checking here. */
+    iter = stringv->buf;
+    if (stringv->dead_count > 0
+            && iter != stringv_end(stringv)
+            && *iter == '\0') {
+        iter = stringv_next(stringv, iter);
+    }
+
+    return iter;
+}
+
+char const *stringv_end(struct stringv const *stringv)
+{
+    assert(stringv);
+    assert(valid_stringv(stringv));
+    return stringv->buf + (stringv->block_size * stringv->block_used);
+}
+
+char const *stringv_next(struct stringv const *stringv, char const *iter)
+{
+    assert(stringv);
+    assert(valid_stringv(stringv));
+    assert(iter);
+
+    /* A block starting with NUL within the used blocks can only be the start
+     * of a tombstoned string, so there is nothing to check without them. */
+    do {
+        do {
+            iter += stringv->block_size;
+        } while (*(iter - 1) != '\0');
+    } while (stringv->dead_count > 0
+            && iter != stringv_end(stringv)
+            && *iter == '\0');
+
+    return iter;
+}
+
+#ifndef NDEBUG
+
+int valid_stringv(struct stringv const *s)
+{
+    return s
+        && s->buf
+        && s->block_total > 0
+        && s->block_size > 0
+        && s->block_used >= 0 && s->block_used <= s->block_total
+        && s->string_count >= 0 && s->string_count <= s->block_total
+        && s->dead_count >= 0 && s->dead_count <= s->string_count;
+}
+
+int valid_block_pos(struct stringv const *s, block_pos bn)
+{
+    /* A block pos is valid if it is in the interval [0, s->block_total]. The
+     * right end of the interval includes the block total since block positions
+     * can be used as ranges, and we want to allow one-past-the-end positions
+     * to make range arithmetic simpler. */
+    return  bn >= 0 && bn <= s->block_total;
+}
+
+int valid_block_range(struct stringv const *s, block_pos first, block_pos last)
+{
+    return s
+        && valid_block_pos(s, first)
+        && (valid_block_pos(s, last) || last == s->block_used)
+        && (first < last);
+}
+
+int valid_string_pos(struct stringv const *s, string_pos sn, int read)
+{
+    return sn >= 0 && (read ? sn < s->string_count : sn <= s->string_count);
+}
+
+#endif /* NDEBUG */
+
+int valid_live_pos(struct stringv const *s, string_pos n, int read)
+{
+    int const live = s->string_count - s->dead_count;
+    return n >= 0 && (read ? n < live : n <= live);
+}
+
+int valid_string(char const *string, size_t length)
+{
+    return string && length > 0 && !memchr(string, '\0', length);
+}
+
+string_pos live_pos_to_string_pos(struct stringv const *s, string_pos n)
+{
+    string_pos sn = 0;
+    block_pos bn = 0;
+
+    assert(s && valid_stringv(s));
+    assert(valid_live_pos(s, n, 1));
+
+    if (s->dead_count == 0) {
+        return n;
+    }
+
+    /* Count strings until we reach the nth live one. This terminates since
+     * n is a valid read position, so there are more than n live strings. */
+    for (;;) {
+        if (!is_string_dead(s, bn)) {
+            if (n == 0) {
+                break;
+            }
+            --n;
+        }
+
+        bn = next_string_block_pos(s, bn);
+        ++sn;
+    }
+
+    COUNT(blocks_scanned, bn);
+    return sn;
+}
+
+block_pos string_pos_to_block_pos(struct stringv const *s, string_pos sn)
+{
+    block_pos bn = 0;
+
+    assert(s && valid_stringv(s));
+    assert(valid_string_pos(s, sn, 0));
+
+    /* The first string always starts at the start of the stringv's buffer. */
+    if (sn == 0) {
+        COUNT(fast_lookups, 1);
+        return 0;
+    }
+
+    /* If the stringv's string count is equal to the number of used blocks,
+     * then the block position corresponding to any string position is simply
+     * that string position. */
+    if (is_one_to_one(s)) {
+        COUNT(fast_lookups, 1);
+        return sn;
+    }
+
+    while (sn > 0) {
+        if (is_block_terminal(s, bn)) {
+            --sn;
+        }
+        ++bn;
+    }
+
+    COUNT(slow_lookups, 1);
+    COUNT(blocks_scanned, bn);
+    assert(sn == 0);
+    return bn;
+}
+
+block_ptr block_pos_to_block_ptr(struct stringv const *s, block_pos bn)
+{
+    assert(s && valid_stringv(s));
+    assert(valid_block_pos(s, bn));
+    return s->buf + bn * s->block_size;
+}
+
+block_ptr string_pos_to_block_ptr(struct stringv const *s, string_pos sn)
+{
+    return block_pos_to_block_ptr(
+            s,
+            string_pos_to_block_pos(s, sn));
+}
+
+int is_one_to_one(struct stringv const *s)
+{
+    assert(s && valid_stringv(s));
+    return s->string_count == s->block_used;
+}
+
+block_pos clear_block_range(struct stringv *s, block_pos first, block_pos last)
+{
+    assert(s && valid_stringv(s));
+    assert(valid_block_range(s, first, last));
+
+    bulk_zero(block_pos_to_block_ptr(s, first),
+            (size_t)((last - first) * s->block_size));
+    COUNT(bytes_zeroed, (last - first) * s->block_size);
+
+    return first;
+}
+
+void bulk_zero(char *dest, size_t size)
+{
+#if defined(__SSE2__)
+    __m128i const zero = _mm_setzero_si128();
+    __m128i *p = NULL;
+    size_t head = 0;
+#endif /* defined(__SSE2__) */
+
+    assert(dest || size == 0);
+
+#if defined(__SSE2__)
+    if (size >= STRINGV_STREAM_THRESHOLD) {
+        /* Streaming stores must be 16-byte aligned, so the unaligned head is
+         * written normally. The threshold guarantees that size > head. */
+        head = (16 - ((size_t)dest & 15)) & 15;
+        memset(dest, 0, head);
+        dest += head;
+        size -= head;
+
+        /* Write whole cache lines at a time, so that the write-combining
+         * buffers are flushed as full lines. */
+        for (p = (__m128i *)(void *)dest; size >= 64; size -= 64, p += 4) {
+            _mm_stream_si128(p, zero);
+            _mm_stream_si128(p + 1, zero);
+            _mm_stream_si128(p + 2, zero);
+            _mm_stream_si128(p + 3, zero);
+        }
+
+        /* The streamed stores are weakly ordered; fence them before anything
+         * else can observe the buffer. */
+        _mm_sfence();
+        dest = (char *)(void *)p;
+    }
+#endif /* defined(__SSE2__) */
+
+    memset(dest, 0, size);
+}
+
+void bulk_copy(
+        char *STRINGV_RESTRICT dest,
+        char const *STRINGV_RESTRICT source,
+        size_t size)
+{
+#if defined(__SSE2__)
+    __m128i *p = NULL;
+    __m128i const *q = NULL;
+    size_t head = 0;
+#endif /* defined(__SSE2__) */
+
+    assert((dest && source) || size == 0);
+
+#if defined(__SSE2__)
+    if (size >= STRINGV_STREAM_THRESHOLD) {
+        /* Only the destination needs to be aligned: the source is read with
+         * unaligned loads, which are cheap on anything with SSE2. */
+        head = (16 - ((size_t)dest & 15)) & 15;
+        memcpy(dest, source, head);
+        dest += head;
+        source += head;
+        size -= head;
+
+        p = (__m128i *)(void *)dest;
+        q = (__m128i const *)(void const *)source;
+        for (; size >= 64; size -= 64, p += 4, q += 4) {
+            _mm_stream_si128(p, _mm_loadu_si128(q));
+            _mm_stream_si128(p + 1, _mm_loadu_si128(q + 1));
+            _mm_stream_si128(p + 2, _mm_loadu_si128(q + 2));
+            _mm_stream_si128(p + 3, _mm_loadu_si128(q + 3));
+        }
+
+        _mm_sfence();
+        dest = (char *)(void *)p;
+        source = (char const *)(void const *)q;
+    }
+#endif /* defined(__SSE2__) */
+
+    memcpy(dest, source, size);
+}
+
+size_t block_string_length(char const *block, size_t block_size)
+{
+    char const *nul = NULL;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i const zero = _mm_setzero_si128();
+    int mask = 0;
+#endif /* defined(__SSE2__) */
+
+    assert(block);
+
+#if defined(__SSE2__)
+    for (; i + 16 <= block_size; i += 16) {
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+                    _mm_loadu_si128((__m128i const *)(void const *)(block + i)),
+                    zero));
+        if (mask != 0) {
+#   if defined(__GNUC__)
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+#   else
+            while (!(mask & 1)) {
+                mask >>= 1;
+                ++i;
+            }
+            return i;
+#   endif /* defined(__GNUC__) */
+        }
+    }
+#endif /* defined(__SSE2__) */
+
+    nul = memchr(block + i, '\0', block_size - i);
+    assert(nul);
+    return (size_t)(nul - block);
+}
+
+char *join_block_string(
+        char *dest,
+        char const *end,
+        char const *block,
+        size_t length,
+        size_t block_size)
+{
+    size_t i = 0;
+
+    assert(dest && end && block);
+    assert(length < block_size);
+
+#if defined(__SSE2__)
+    /* Short strings are the common case, and one or two vector copies are
+     * cheaper for them than a call to memcpy */
+    for (; i < length && i + 16 <= block_size && dest + i + 16 <= end;
+            i += 16) {
+        _mm_storeu_si128((__m128i *)(void *)(dest + i),
+                _mm_loadu_si128((__m128i const *)(void const *)(block + i)));
+    }
+#else
+    (void)end;
+    (void)block_size;
+#endif /* defined(__SSE2__) */
+
+    if (i < length) {
+        memcpy(dest + i, block + i, length - i);
+    }
+
+    return dest + length;
+}
+
+void import_block_string(
+        block_ptr block,
+        char const *string,
+        size_t length,
+        size_t readable,
+        size_t block_size)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i const lanes = _mm_setr_epi8(
+            0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i v;
+#endif /* defined(__SSE2__) */
+
+    assert(block && string);
+    assert(length > 0 && length < block_size);
+    assert(readable >= length);
+
+#if defined(__SSE2__)
+    /* Store whole vectors while they stay within the block and the source,
+     * zeroing the lanes past the end of the string, which is what the
+     * padding holds anyway. */
+    for (; i < length && i + 16 <= readable && i + 16 <= block_size;
+            i += 16) {
+        v = _mm_loadu_si128((__m128i const *)(void const *)(string + i));
+        if (length - i < 16) {
+            v = _mm_and_si128(v, _mm_cmplt_epi8(
+                        lanes, _mm_set1_epi8((char)(length - i))));
+        }
+        _mm_storeu_si128((__m128i *)(void *)(block + i), v);
+    }
+#else
+    (void)readable;
+    (void)block_size;
+#endif /* defined(__SSE2__) */
+
+    if (i < length) {
+        memcpy(block + i, string + i, length - i);
+    }
+}
+
+int64_t column_offset(void const *offsets, int large, int i)
+{
+    assert(offsets && i >= 0);
+
+    return large
+        ? ((int64_t const *)offsets)[i]
+        : ((int32_t const *)offsets)[i];
+}
+
+void set_column_offset(void *offsets, int large, int i, int64_t value)
+{
+    assert(offsets && i >= 0);
+    assert(large || value <= INT32_MAX);
+
+    if (large) {
+        ((int64_t *)offsets)[i] = value;
+    } else {
+        ((int32_t *)offsets)[i] = (int32_t)value;
+    }
+}
+
+int export_column(
+        struct stringv_column_cursor *cursor,
+        void *offsets,
+        int large,
+        char *data,
+        int max_count,
+        size_t data_size)
+{
+    struct stringv const *s = NULL;
+    char const *end = NULL;
+    size_t block_size = 0, length = 0, used = 0;
+    int count = 0, one_to_one = 0;
+
+    if (!cursor || !cursor->stringv || !offsets || !data || max_count <= 0) {
+        return -1;
+    }
+
+    s = cursor->stringv;
+    assert(valid_stringv(s));
+
+    block_size = (size_t)s->block_size;
+    one_to_one = is_one_to_one(s);
+    end = data + data_size;
+    if (!large && data_size > INT32_MAX) {
+        data_size = INT32_MAX;
+    }
+
+    set_column_offset(offsets, large, 0, 0);
+    while (count < max_count && cursor->iter != stringv_end(s)) {
+        /* In a one-to-one stringv, every block is a string, and the dead
+         * strings are the empty ones */
+        if (one_to_one) {
+            length = block_string_length(cursor->iter, block_size);
+            if (length == 0) {
+                cursor->iter += block_size;
+                continue;
+            }
+        } else {
+            length = strlen(cursor->iter);
+        }
+
+        if (length > data_size - used) {
+            break;
+        }
+
+        if (one_to_one) {
+            join_block_string(
+                    data + used, end, cursor->iter, length, block_size);
+            cursor->iter += block_size;
+        } else {
+            memcpy(data + used, cursor->iter, length);
+            cursor->iter = stringv_next(s, cursor->iter);
+        }
+
+        used += length;
+        set_column_offset(offsets, large, ++count, (int64_t)used);
+    }
+
+    if (count == 0 && cursor->iter != stringv_end(s)) {
+        return -1;
+    }
+
+    return count;
+}
+
+int import_column(
+        struct stringv *s,
+        void const *offsets,
+        int large,
+        char const *data,
+        int count)
+{
+    int64_t first = 0, last = 0, data_end = 0;
+    size_t length = 0;
+    int i = 0, blocks = 0, blocks_req = 0;
+
+    if (!s || !offsets || !data || count < 0) {
+        return -1;
+    }
+
+    assert(valid_stringv(s));
+
+    /* Check the whole column, and that it fits, before writing anything */
+    for (i = 0; i < count; ++i) {
+        first = column_offset(offsets, large, i);
+        last = column_offset(offsets, large, i + 1);
+        if (first < 0
+                || last <= first
+                || memchr(data + first, '\0', (size_t)(last - first))) {
+            return -1;
+        }
+
+        blocks_req = blocks_required(s, (size_t)(last - first));
+        if (blocks_req > s->block_total - s->block_used - blocks) {
+            COUNT(capacity_failures, 1);
+            return -1;
+        }
+        blocks += blocks_req;
+    }
+
+    prepare_write(s, s->block_used, s->block_used + blocks);
+
+    data_end = column_offset(offsets, large, count);
+    for (i = 0; i < count; ++i) {
+        first = column_offset(offsets, large, i);
+        length = (size_t)(column_offset(offsets, large, i + 1) - first);
+        blocks_req = blocks_required(s, length);
+
+        if (blocks_req == 1) {
+            import_block_string(block_pos_to_block_ptr(s, s->block_used),
+                    data + first,
+                    length,
+                    (size_t)(data_end - first),
+                    (size_t)s->block_size);
+        } else {
+            memcpy(block_pos_to_block_ptr(s, s->block_used),
+                    data + first,
+                    length);
+        }
+
+        s->block_used += blocks_req;
+        ++s->string_count;
+    }
+
+    return count;
+}
+
+int blocks_required(struct stringv const *s, size_t length)
+{
+    assert(s && valid_stringv(s));
+    assert(length != 0);
+
+    /* Increment the length to accomodate the NUL character. All strings
+     * in a stringv are NUL terminated (with at least one NUL terminator, 
+     * by design. */
+    ++length;
+
+    return (int)((length / (size_t)s->block_size) +
+        (length % (size_t)s->block_size != 0));
+}
+
+int is_block_terminal(struct stringv const *s, block_pos bn)
+{
+    assert(s && valid_stringv(s));
+    assert(valid_block_pos(s, bn));
+    return is_one_to_one(s)
+        || *(block_pos_to_block_ptr(s, bn) + s->block_size - 1) == '\0';
+}
+
+int blocks_used_by(struct stringv const *s, string_pos sn)
+{
+    block_pos bn = 0;
+
+    assert(s && valid_stringv(s));
+    assert(valid_string_pos(s, sn, 1));
+
+    /* If the stringv has the same number of strings as it does used blocks,
+     * then all strings necessarily occupy a single block */
+    if (is_one_to_one(s)) {
+        return 1;
+    }
+
+    bn = string_pos_to_block_pos(s, sn);
+    return next_string_block_pos(s, bn) - bn;
+}
+
+block_pos next_string_block_pos(struct stringv const *s, block_pos bn)
+{
+    assert(s && valid_stringv(s));
+    assert(valid_block_pos(s, bn) && bn < s->block_used);
+
+    if (is_one_to_one(s)) {
+        return bn + 1;
+    }
+
+    /* Iterate through the blocks until we find a terminal block. This (by
+     * definition) ends the string. */
+    while (!is_block_terminal(s, bn)) {
+        ++bn;
+    }
+
+    return bn + 1;
+}
+
+int is_string_dead(struct stringv const *s, block_pos bn)
+{
+    assert(s && valid_stringv(s));
+    assert(valid_block_pos(s, bn) && bn < s->block_used);
+    return *block_pos_to_block_ptr(s, bn) == '\0';
+}
+
+int copy_blockwise_bijective(
+        struct stringv *dest,
+        struct stringv const *source)
+{
+    assert(dest && valid_stringv(dest));
+    assert(source && valid_stringv(source));
+    assert(source->block_size == dest->block_size);
+    assert(source->block_used <= dest->block_total - dest->block_used);
+
+    bulk_copy(block_pos_to_block_ptr(dest, dest->block_used),
+            source->buf,
+            (size_t)(source->block_size * source->block_used));
+    dest->string_count += source->string_count;
+    dest->dead_count += source->dead_count;
+    dest->block_used += source->block_used;
+    return source->string_count - source->dead_count;
+}
+
+int copy_blockwise_injective(
+        struct stringv *dest,
+        struct stringv const *source)
+{
+    string_pos i = 0;
+
+    assert(dest && valid_stringv(dest));
+    assert(source && valid_stringv(source));
+    assert(is_one_to_one(source));
+    assert(source->block_size <= dest->block_size);
+    assert(source->block_used <= dest->block_total - dest->block_used);
+
+    for (i = 0; i < source->string_count; ++i) {
+        /* We know that each string in the source stringv occupies exactly
+         * one block in the destination stringv. So we copy each string
+         * over to each block. Instead of computing the strings length with
+         * strlen, we just copy source->block_size - 1 characters since the
+         * string lengths are bounded by this value. */
+        memcpy(
+                block_pos_to_block_ptr(dest, dest->block_used + i),
+                block_pos_to_block_ptr(source, i),
+                source->block_size - 1);
+    }
+
+    dest->string_count += source->string_count;
+    dest->block_used += source->string_count;
+    dest->dead_count += source->dead_count;
+    return source->string_count - source->dead_count;
+}
+
+int copy_stringwise(struct stringv *dest, struct stringv const *source)
+{
+    char const *ith_string = NULL;
+    size_t ith_length = 0;
+    block_pos bn = 0;
+    int blocks_req = 0, appended = 0;
+
+    assert(dest && valid_stringv(dest));
+    assert(source && valid_stringv(source));
+
+    /* Walk the source strings by block position, rather than looking each
+     * one up by its string_pos, which would rescan the blocks from the start
+     * for every string. */
+    for (bn = 0;
+            bn < source->block_used;
+            bn = next_string_block_pos(source, bn)) {
+        /* We don't know whether the source string will fit in the destination
+         * stringv, so we need to compute the length of each string,
+         * determine how many blocks it uses, and bail out if the required
+         * number of blocks is greater than the available blocks in dest. */
+        ith_string = block_pos_to_block_ptr(source, bn);
+        ith_length = strlen(ith_string);
+
+        /* Tombstoned strings are dropped rather than copied */
+        if (ith_length == 0) {
+            continue;
+        }
+
+        blocks_req = blocks_required(dest, ith_length);
+
+        /* If there is insufficient room, stop copying */
+        if (dest->block_used + blocks_req > dest->block_total) {
+            COUNT(capacity_failures, 1);
+            break;
+        }
+
+        /* Otherwise, copy the string over */
+        memcpy(
+                block_pos_to_block_ptr(dest, dest->block_used),
+                ith_string,
+                ith_length);
+
+        /* And increment the string and block counters */
+        dest->block_used += blocks_req;
+        ++dest->string_count;
+        ++appended;
+    }
+
+    return appended;
+}
+
+int reblock_strings(
+        struct stringv *dest,
+        struct stringv const *source,
+        block_pos *next)
+{
+    size_t const source_size = (size_t)source->block_size;
+    size_t const dest_size = (size_t)dest->block_size;
+    block_ptr block = NULL, write_ptr = NULL;
+    block_pos bn = 0, last = 0;
+    size_t length = 0;
+    int blocks_req = 0;
+
+    /* If every source string is in one block, and the destination blocks are
+     * no smaller, each source block can be copied whole without finding where
+     * its string ends. */
+    int const whole_blocks = is_one_to_one(source)
+        && dest->block_size >= source->block_size;
+
+    assert(dest && valid_stringv(dest));
+    assert(source && valid_stringv(source));
+    assert(next && *next >= 0 && *next <= source->block_used);
+
+    for (bn = *next; bn < source->block_used; bn = last) {
+        last = next_string_block_pos(source, bn);
+        block = block_pos_to_block_ptr(source, bn);
+
+        if (*block == '\0') {
+            continue;
+        }
+
+        if (whole_blocks) {
+            length = source_size;
+            blocks_req = 1;
+        } else {
+            length = (size_t)(last - bn - 1) * source_size
+                + block_string_length(
+                        block_pos_to_block_ptr(source, last - 1),
+                        source_size);
+            blocks_req = blocks_required(dest, length);
+        }
+
+        if (dest->block_used + blocks_req > dest->block_total) {
+            COUNT(capacity_failures, 1);
+            *next = bn;
+            return 0;
+        }
+
+        write_ptr = block_pos_to_block_ptr(dest, dest->block_used);
+        memcpy(write_ptr, block, length);
+        memset(write_ptr + length,
+                0,
+                (size_t)blocks_req * dest_size - length);
+        dest->block_used += blocks_req;
+        ++dest->string_count;
+    }
+
+    *next = bn;
+    return 1;
+}
+
+int reblock_in_place(struct stringv *s, int block_size)
+{
+    size_t const old_size = (size_t)s->block_size;
+    size_t const new_size = (size_t)block_size;
+    int const block_total =
+        (int)((size_t)s->block_total * old_size / new_size);
+    block_pos bn = 0;
+
+    assert(s && valid_stringv(s));
+
+    if (!is_one_to_one(s) || s->block_used > block_total) {
+        return -1;
+    }
+
+    if (new_size > old_size) {
+        /* Each block moves right, so they are moved from last to first, and
+         * the rest of each new block is zeroed once the blocks it overlaps
+         * have been moved. The chars after the used blocks are already zero.
+         */
+        for (bn = s->block_used - 1; bn >= 0; --bn) {
+            if (is_string_dead(s, bn)) {
+                memset(s->buf + (size_t)bn * new_size, 0, new_size);
+                continue;
+            }
+
+            if (bn > 0) {
+                memmove(s->buf + (size_t)bn * new_size,
+                        s->buf + (size_t)bn * old_size,
+                        old_size);
+            }
+            memset(s->buf + (size_t)bn * new_size + old_size,
+                    0,
+                    new_size - old_size);
+        }
+
+        COUNT(bytes_zeroed, (size_t)s->block_used * (new_size - old_size));
+    } else if (new_size < old_size) {
+        /* Every string must fit in a smaller block before any is moved */
+        for (bn = 0; bn < s->block_used; ++bn) {
+            if (block_string_length(block_pos_to_block_ptr(s, bn), old_size)
+                    >= new_size) {
+                return -1;
+            }
+        }
+
+        /* Each block moves left, so they are moved from first to last. The
+         * chars after each string in its old block are zero, so copying the
+         * start of each old block gives the new one. Dead blocks are zeroed
+         * instead: an image saved before stringv_tombstone zeroed the whole
+         * string may still hold its chars, which would otherwise leave the
+         * new block without a NUL at its end. */
+        for (bn = 0; bn < s->block_used; ++bn) {
+            if (is_string_dead(s, bn)) {
+                memset(s->buf + (size_t)bn * new_size, 0, new_size);
+            } else if (bn > 0) {
+                memmove(s->buf + (size_t)bn * new_size,
+                        s->buf + (size_t)bn * old_size,
+                        new_size);
+            }
+        }
+
+        bulk_zero(s->buf + (size_t)s->block_used * new_size,
+                (size_t)s->block_used * (old_size - new_size));
+        COUNT(bytes_zeroed, (size_t)s->block_used * (old_size - new_size));
+    }
+
+    if (s->block_used > 1) {
+        COUNT(bytes_moved, (size_t)(s->block_used - 1)
+                * (new_size < old_size ? new_size : old_size));
+    }
+
+    s->block_size = block_size;
+    s->block_total = block_total;
+    return 1;
+}
+
+block_pos shift_blocks(
+        struct stringv *s,
+        block_pos first,
+        block_pos last,
+        int offset)
+{
+    assert(s && valid_stringv(s));
+    assert(valid_block_range(s, first, last));
+    assert(offset != 0);
+
+    memmove(
+            block_pos_to_block_ptr(s, first + offset),
+            block_pos_to_block_ptr(s, first),
+            (last - first) * s->block_size);
+    COUNT(bytes_moved, (last - first) * s->block_size);
+
+    if (offset < 0) {
+        /* If the offset is negative, then the shift is a left shift.
+         * We return the block position of the end of the shifted range. */
+        return last + offset;
+    } else {
+        /* Otherwise, the offset is positive and the shift is a right shift.
+         * We return the block position of the start of the gap that we just
+         * created from the shift after zeroing it out. */
+        clear_block_range(s, first, first + offset);
+        return first;
+    }
+}
+
+block_ptr block_write(
+        struct stringv *s,
+        char const *string,
+        size_t length,
+        block_pos first,
+        block_pos last)
+{
+    block_ptr write_ptr = NULL;
+
+    assert(s && valid_stringv(s));
+    assert(string);
+    assert(length > 0);
+    assert(valid_block_range(s, first, last));
+
+    write_ptr = memcpy(block_pos_to_block_ptr(s, first), string, length);
+    s->block_used += (last - first);
+    ++s->string_count;
+
+    return write_ptr;
+}
+
+int remove_string(struct stringv *stringv, string_pos sn)
+{
+    block_pos bn = 0;
+    int offset = 0;
+
+    assert(stringv && valid_stringv(stringv));
+    assert(valid_string_pos(stringv, sn, 1));
+
+    /* If there is only one string in the stringv, then it is the one specified
+     * by sn since the string pos is valid for reads. So clear the stringv. */
+    if (stringv->string_count == 1) {
+       (void)stringv_clear(stringv);
+       return 1;
+    }
+
+    bn = string_pos_to_block_pos(stringv, sn);
+    assert(valid_block_pos(stringv, bn));
+    prepare_write(stringv, bn, stringv->block_used);
+
+    /* Otherwise, if the string position refers to the string at the end of the
+     * stringv, then we can rewind the stringv's block_used field and clear
+     * the end of the buffer. This way we avoid shifting blocks. */
+    if (sn == stringv->string_count - 1) {
+        /* Clear the last string. clear_block_range returns bn, which
+         * will be the number of used blocks in the stringv after the last
+         * string is removed. */
+        stringv->block_used = clear_block_range(
+                stringv,
+                bn,
+                stringv->block_used);
+
+        --stringv->string_count;
+        return 1;
+    }
+
+    /* Finally, if the insertion is internal (there are strings to the right
+     * of the string we want to remove) then we can shift the blocks over the
+     * string to be removed. We first compute the shift offset, which is the
+     * number of blocks used by the string to remove. */
+    offset = blocks_used_by(stringv, sn);
+    clear_block_range(
+            stringv,
+            shift_blocks(stringv, bn + offset, stringv->block_used, -offset),
+            stringv->block_used);
+
+    --stringv->string_count;
+    stringv->block_used -= offset;
+    return 1;
+}
+
+void swap_chars(char *p, char *q, size_t size)
+{
+    char tmp[64];
+
+    assert(p && q);
+
+    /* Swap in chunks of a cache line. The fixed size copies are lowered to
+     * vector loads and stores by the compiler. */
+    while (size >= sizeof(tmp)) {
+        memcpy(tmp, p, sizeof(tmp));
+        memcpy(p, q, sizeof(tmp));
+        memcpy(q, tmp, sizeof(tmp));
+        p += sizeof(tmp);
+        q += sizeof(tmp);
+        size -= sizeof(tmp);
+    }
+
+    /* Blocks are commonly a power of two in size, so give the compiler a
+     * constant size to work with in those cases too. */
+    switch (size) {
+    case 0:
+        break;
+    case 8:
+        memcpy(tmp, p, 8);
+        memcpy(p, q, 8);
+        memcpy(q, tmp, 8);
+        break;
+    case 16:
+        memcpy(tmp, p, 16);
+        memcpy(p, q, 16);
+        memcpy(q, tmp, 16);
+        break;
+    case 32:
+        memcpy(tmp, p, 32);
+        memcpy(p, q, 32);
+        memcpy(q, tmp, 32);
+        break;
+    default:
+        memcpy(tmp, p, size);
+        memcpy(p, q, size);
+        memcpy(q, tmp, size);
+        break;
+    }
+}
+
+void swap_block_ranges(
+        struct stringv *s,
+        block_pos a,
+        block_pos b,
+        int count)
+{
+    assert(s && valid_stringv(s));
+    assert(count > 0);
+    assert(valid_block_range(s, a, a + count));
+    assert(valid_block_range(s, b, b + count));
+    assert(a + count <= b || b + count <= a);
+
+    swap_chars(
+            block_pos_to_block_ptr(s, a),
+            block_pos_to_block_ptr(s, b),
+            (size_t)(count * s->block_size));
+}
+
+void reverse_blocks(struct stringv *s, block_pos first, block_pos last)
+{
+    assert(s && valid_stringv(s));
+    assert(valid_block_range(s, first, last));
+
+    while (first < --last) {
+        swap_block_ranges(s, first++, last, 1);
+    }
+}
+
+block_pos rotate_blocks(
+        struct stringv *s,
+        block_pos first,
+        block_pos middle,
+        block_pos last)
+{
+    block_pos const result = first + (last - middle);
+    int left = 0, right = 0;
+
+    assert(s && valid_stringv(s));
+    assert(first <= middle && middle <= last);
+
+    /* Gries-Mills rotation: repeatedly swap the shorter side with the
+     * adjacent part of the longer side, which puts the shorter side in its
+     * final place. Each swap is a single contiguous range, unlike a rotation
+     * by reversal, which swaps one block at a time. */
+    while (first != middle && middle != last) {
+        left = middle - first;
+        right = last - middle;
+
+        if (left <= right) {
+            /* A B1 B2 -> B1 A B2, leaving A B2 to rotate */
+            swap_block_ranges(s, first, middle, left);
+            first = middle;
+            middle += left;
+        } else {
+            /* A1 A2 B -> B A2 A1, leaving A2 A1 to rotate */
+            swap_block_ranges(s, first, middle, right);
+            first += right;
+        }
+    }
+
+    return result;
+}
+
+block_pos stable_partition_blocks(
+        struct stringv *s,
+        block_pos first,
+        block_pos last,
+        int count,
+        string_predicate predicate,
+        void *context,
+        int *selected)
+{
+    block_pos middle = 0, left = 0, right = 0;
+    int i = 0;
+
+    assert(s && valid_stringv(s));
+    assert(first < last && count > 0);
+    assert(predicate && selected);
+
+    if (count == 1) {
+        if (!is_string_dead(s, first)
+                && predicate(block_pos_to_block_ptr(s, first), context)) {
+            ++*selected;
+            return last;
+        }
+
+        return first;
+    }
+
+    /* Partition each half, which leaves the blocks as S1 U1 S2 U2 (selected
+     * and unselected). Rotating U1 S2 puts S1 S2 before U1 U2. */
+    if (is_one_to_one(s)) {
+        middle = first + count / 2;
+    } else {
+        for (middle = first, i = 0; i < count / 2; ++i) {
+            middle = next_string_block_pos(s, middle);
+        }
+    }
+
+    left = stable_partition_blocks(
+            s, first, middle, count / 2, predicate, context, selected);
+    right = stable_partition_blocks(
+            s, middle, last, count - count / 2, predicate, context, selected);
+
+    return rotate_blocks(s, left, middle, right);
+}
+
+void prepare_write(struct stringv *s, block_pos first, block_pos last)
+{
+    struct stringv_snapshot *const snapshot = s->snapshot;
+    size_t begin = 0, end = 0;
+    int chunk = 0;
+
+    if (!snapshot) {
+        return;
+    }
+
+    /* Only the blocks that were used when the snapshot was taken need to be
+     * preserved. */
+    if (last > snapshot->state.block_used) {
+        last = snapshot->state.block_used;
+    }
+
+    if (first >= last) {
+        return;
+    }
+
+    begin = (size_t)first * (size_t)s->block_size;
+    end = (size_t)last * (size_t)s->block_size;
+    for (chunk = (int)(begin / (size_t)snapshot->chunk_size);
+            (size_t)chunk * (size_t)snapshot->chunk_size < end;
+            ++chunk) {
+        preserve_chunk(snapshot, chunk);
+    }
+}
+
+void preserve_chunk(struct stringv_snapshot *snapshot, int chunk)
+{
+    int state = CHUNK_LIVE, target = CHUNK_LOST;
+
+    assert(chunk >= 0 && chunk < snapshot->chunk_count);
+
+    /* Only the writer moves a chunk out of the live and pinned states, so
+     * chunks that have been dealt with can be skipped without a CAS. */
+    state = chunk_state_load(&snapshot->chunk_map[chunk]);
+    if (state != CHUNK_LIVE && state != CHUNK_PINNED) {
+        return;
+    }
+
+    /* Copying the chunk while a reader has it pinned is fine, since neither
+     * modifies it; the writer just can't publish the copy (and go on to
+     * modify the chunk) until the reader has finished. */
+    if (snapshot->store_used < snapshot->store_total) {
+        target = snapshot->store_used;
+        memcpy(snapshot->store + (size_t)target * (size_t)snapshot->chunk_size,
+                snapshot->state.buf
+                    + (size_t)chunk * (size_t)snapshot->chunk_size,
+                chunk_bytes(snapshot, chunk));
+    }
+
+    do {
+        state = CHUNK_LIVE;
+    } while (!chunk_state_cas(&snapshot->chunk_map[chunk], &state, target));
+
+    if (target == CHUNK_LOST) {
+        ++snapshot->lost_count;
+    } else {
+        ++snapshot->store_used;
+    }
+}
+
+size_t chunk_bytes(struct stringv_snapshot const *snapshot, int chunk)
+{
+    size_t const size = (size_t)snapshot->state.block_used
+        * (size_t)snapshot->state.block_size;
+    size_t const offset = (size_t)chunk * (size_t)snapshot->chunk_size;
+
+    assert(offset < size);
+    return size - offset < (size_t)snapshot->chunk_size
+        ? size - offset
+        : (size_t)snapshot->chunk_size;
+}
+
+int chunk_state_cas(int *state, int *expected, int desired)
+{
+#if defined(__GNUC__)
+    return __atomic_compare_exchange_n(
+            state,
+            expected,
+            desired,
+            0,
+            __ATOMIC_ACQ_REL,
+            __ATOMIC_ACQUIRE);
+#else
+    if (*state == *expected) {
+        *state = desired;
+        return 1;
+    }
+
+    *expected = *state;
+    return 0;
+#endif /* defined(__GNUC__) */
+}
+
+int chunk_state_load(int const *state)
+{
+#if defined(__GNUC__)
+    return __atomic_load_n(state, __ATOMIC_ACQUIRE);
+#else
+    return *state;
+#endif /* defined(__GNUC__) */
+}
+
+void chunk_state_store(int *state, int value)
+{
+#if defined(__GNUC__)
+    __atomic_store_n(state, value, __ATOMIC_RELEASE);
+#else
+    *state = value;
+#endif /* defined(__GNUC__) */
+}
+
+void analysis_begin(struct stringv_block_analysis *analyses, int count)
+{
+    int i = 0;
+
+    for (i = 0; i < count; ++i) {
+        analyses[i].block_count = 0;
+        analyses[i].padding = 0.;
+        analyses[i].multi_block = 0.;
+        analyses[i].lookup_cost = 0.;
+        analyses[i].score = 0.;
+    }
+}
+
+void analysis_add(
+        struct stringv_block_analysis *analyses,
+        int count,
+        size_t length)
+{
+    size_t block_size = 0, blocks = 0;
+    int i = 0;
+
+    assert(length > 0);
+
+    /* As in blocks_required, the string needs room for its terminator */
+    for (i = 0; i < count; ++i) {
+        block_size = (size_t)analyses[i].block_size;
+        blocks = (length + block_size) / block_size;
+
+        analyses[i].lookup_cost += (double)analyses[i].block_count;
+        analyses[i].block_count += (long)blocks;
+        analyses[i].padding += (double)(blocks * block_size - length - 1);
+        analyses[i].multi_block += blocks > 1;
+    }
+}
+
+int analysis_end(
+        struct stringv_block_analysis *analyses,
+        int count,
+        int strings,
+        double memory_weight,
+        double latency_weight)
+{
+    double bytes = 0., min_bytes = 0., min_cost = 0.;
+    int i = 0, best = 0;
+
+    if (strings == 0) {
+        return 0;
+    }
+
+    /* A lookup in a one-to-one stringv goes straight to the string's block;
+     * otherwise it walks every block before the string's own. */
+    for (i = 0; i < count; ++i) {
+        bytes = (double)analyses[i].block_count * analyses[i].block_size;
+        analyses[i].padding /= bytes;
+        analyses[i].multi_block /= strings;
+        analyses[i].lookup_cost = analyses[i].block_count == strings
+            ? 1.
+            : 1. + analyses[i].lookup_cost / strings;
+
+        if (i == 0 || bytes < min_bytes) {
+            min_bytes = bytes;
+        }
+        if (i == 0 || analyses[i].lookup_cost < min_cost) {
+            min_cost = analyses[i].lookup_cost;
+        }
+    }
+
+    for (i = 0; i < count; ++i) {
+        bytes = (double)analyses[i].block_count * analyses[i].block_size;
+        analyses[i].score = memory_weight * bytes / min_bytes
+            + latency_weight * analyses[i].lookup_cost / min_cost;
+
+        if (analyses[i].score < analyses[best].score) {
+            best = i;
+        }
+    }
+
+    return analyses[best].block_size;
+}
+
+int valid_analysis(
+        double memory_weight,
+        double latency_weight,
+        struct stringv_block_analysis const *analyses,
+        int count)
+{
+    int i = 0;
+
+    if (!(memory_weight >= 0.)
+            || !(latency_weight >= 0.)
+            || !analyses
+            || count <= 0) {
+        return 0;
+    }
+
+    for (i = 0; i < count; ++i) {
+        if (analyses[i].block_size <= 1) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+#if defined(STRINGV_TRACE)
+
+void trace(
+        enum stringv_trace_op op,
+        int exit,
+        struct stringv const *s,
+        size_t size,
+        string_pos sn,
+        long result)
+{
+    struct stringv_trace_event event;
+    void *context = NULL;
+    stringv_trace_hook const hook = load_trace_hook(&context);
+
+    if (hook) {
+        event.op = op;
+        event.exit = exit;
+        event.stringv = s;
+        event.size = size;
+        event.position = sn;
+        event.result = result;
+        event.time = trace_time();
+        hook(&event, context);
+    }
+
+#if defined(STRINGV_USDT)
+    if (exit) {
+        DTRACE_PROBE5(stringv, exit, op, s, size, sn, result);
+    } else {
+        DTRACE_PROBE4(stringv, entry, op, s, size, sn);
+    }
+#endif /* defined(STRINGV_USDT) */
+}
+
+size_t used_bytes(struct stringv const *s)
+{
+    return s ? (size_t)s->block_used * (size_t)s->block_size : 0;
+}
+
+stringv_trace_hook load_trace_hook(void **context)
+{
+#if defined(__GNUC__)
+    stringv_trace_hook hook = NULL;
+    unsigned sequence = 0;
+
+    assert(context);
+
+    do {
+        while ((sequence = __atomic_load_n(&trace_sequence, __ATOMIC_ACQUIRE))
+                & 1u) {
+            /* A registration is in progress */
+        }
+
+        hook = __atomic_load_n(&trace_hook, __ATOMIC_RELAXED);
+        *context = __atomic_load_n(&trace_context, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&trace_sequence, __ATOMIC_RELAXED) != sequence);
+
+    return hook;
+#else
+    assert(context);
+    *context = trace_context;
+    return trace_hook;
+#endif /* defined(__GNUC__) */
+}
+
+uint64_t trace_time(void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec now;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == 0) {
+        return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+    }
+#endif /* defined(CLOCK_MONOTONIC) */
+
+    return 0;
+}
+
+/* The public traced functions follow, each calling the function compiled
+ * under its name above. */
+#undef stringv_init
+#undef stringv_clear
+#undef stringv_copy
+#undef stringv_append
+#undef stringv_reblock
+#undef stringv_push_back
+#undef stringv_push_front
+#undef stringv_insert
+#undef stringv_replace
+#undef stringv_split_c
+#undef stringv_split_s
+#undef stringv_join
+#undef stringv_column_import
+#undef stringv_column_import64
+#undef stringv_remove
+#undef stringv_tombstone
+#undef stringv_compact
+#undef stringv_swap
+#undef stringv_rotate
+#undef stringv_reverse
+#undef stringv_stable_partition
+#undef stringv_snapshot_copy
+
+struct stringv *stringv_init(
+        struct stringv *stringv,
+        char *buf,
+        int buf_size,
+        int block_size)
+{
+    struct stringv *result = NULL;
+
+    trace(STRINGV_TRACE_INIT, 0, stringv, (size_t)buf_size, -1, 0);
+    result = untraced_init(stringv, buf, buf_size, block_size);
+    trace(STRINGV_TRACE_INIT, 1, stringv, (size_t)buf_size, -1,
+            result != NULL);
+    return result;
+}
+
+struct stringv *stringv_clear(struct stringv *stringv)
+{
+    size_t const size = used_bytes(stringv);
+    struct stringv *result = NULL;
+
+    trace(STRINGV_TRACE_CLEAR, 0, stringv, size, -1, 0);
+    result = untraced_clear(stringv);
+    trace(STRINGV_TRACE_CLEAR, 1, stringv, size, -1, result != NULL);
+    return result;
+}
+
+int stringv_copy(struct stringv *dest, struct stringv const *source)
+{
+    size_t const size = used_bytes(source);
+    int result = 0;
+
+    trace(STRINGV_TRACE_COPY, 0, dest, size, -1, 0);
+    result = untraced_copy(dest, source);
+    trace(STRINGV_TRACE_COPY, 1, dest, size, -1, result);
+    return result;
+}
+
+int stringv_append(struct stringv *dest, struct stringv const *source)
+{
+    size_t const size = used_bytes(source);
+    int result = 0;
+
+    trace(STRINGV_TRACE_APPEND, 0, dest, size, -1, 0);
+    result = untraced_append(dest, source);
+    trace(STRINGV_TRACE_APPEND, 1, dest, size, -1, result);
+    return result;
+}
+
+int stringv_reblock(
+        struct stringv *stringv,
+        int block_size,
+        char *buf,
+        int buf_size,
+        struct stringv_reblock_progress *progress)
+{
+    size_t const size = used_bytes(stringv);
+    int result = 0;
+
+    trace(STRINGV_TRACE_REBLOCK, 0, stringv, size, -1, 0);
+    result = untraced_reblock(stringv, block_size, buf, buf_size, progress);
+    trace(STRINGV_TRACE_REBLOCK, 1, stringv, size, -1, result);
+    return result;
+}
+
+char const *stringv_push_back(
+        struct stringv *stringv,
+        char const *string,
+        size_t length)
+{
+    char const *result = NULL;
+
+    trace(STRINGV_TRACE_PUSH_BACK, 0, stringv, length, -1, 0);
+    result = untraced_push_back(stringv, string, length);
+    trace(STRINGV_TRACE_PUSH_BACK, 1, stringv, length, -1, result != NULL);
+    return result;
+}
+
+char const *stringv_push_front(
+        struct stringv *stringv,
+        char const *string,
+        size_t length)
+{
+    char const *result = NULL;
+
+    trace(STRINGV_TRACE_PUSH_FRONT, 0, stringv, length, 0, 0);
+    result = untraced_push_front(stringv, string, length);
+    trace(STRINGV_TRACE_PUSH_FRONT, 1, stringv, length, 0, result != NULL);
+    return result;
+}
+
+char const *stringv_insert(
+        struct stringv *stringv,
+        char const *string,
+        size_t length,
+        string_pos sn)
+{
+    char const *result = NULL;
+
+    trace(STRINGV_TRACE_INSERT, 0, stringv, length, sn, 0);
+    result = untraced_insert(stringv, string, length, sn);
+    trace(STRINGV_TRACE_INSERT, 1, stringv, length, sn, result != NULL);
+    return result;
+}
+
+char const *stringv_replace(
+        struct stringv *stringv,
+        string_pos sn,
+        char const *string,
+        size_t length)
+{
+    char const *result = NULL;
+
+    trace(STRINGV_TRACE_REPLACE, 0, stringv, length, sn, 0);
+    result = untraced_replace(stringv, sn, string, length);
+    trace(STRINGV_TRACE_REPLACE, 1, stringv, length, sn, result != NULL);
+    return result;
+}
+
+size_t stringv_split_c(
+        struct stringv *stringv,
+        char const *string,
+        size_t length,
+        int separator)
+{
+    size_t result = 0;
+
+    trace(STRINGV_TRACE_SPLIT_C, 0, stringv, length, -1, 0);
+    result = untraced_split_c(stringv, string, length, separator);
+    trace(STRINGV_TRACE_SPLIT_C, 1, stringv, length, -1, (long)result);
+    return result;
+}
+
+size_t stringv_split_s(
+        struct stringv *stringv,
+        char const *string,
+        size_t length,
+        char const *separator,
+        size_t separator_length)
+{
+    size_t result = 0;
+
+    trace(STRINGV_TRACE_SPLIT_S, 0, stringv, length, -1, 0);
+    result = untraced_split_s(
+            stringv,
+            string,
+            length,
+            separator,
+            separator_length);
+    trace(STRINGV_TRACE_SPLIT_S, 1, stringv, length, -1, (long)result);
+    return result;
+}
+
+size_t stringv_join(
+        struct stringv const *stringv,
+        char const *separator,
+        size_t separator_length,
+        char *out,
+        size_t out_size)
+{
+    size_t result = 0;
+
+    trace(STRINGV_TRACE_JOIN, 0, stringv, out_size, -1, 0);
+    result = untraced_join(
+            stringv,
+            separator,
+            separator_length,
+            out,
+            out_size);
+    trace(STRINGV_TRACE_JOIN, 1, stringv, out_size, -1, (long)result);
+    return result;
+}
+
+int stringv_column_import(
+        struct stringv *stringv,
+        int32_t const *offsets,
+        char const *data,
+        int count)
+{
+    int result = 0;
+
+    trace(STRINGV_TRACE_COLUMN_IMPORT, 0, stringv, (size_t)count, -1, 0);
+    result = untraced_column_import(stringv, offsets, data, count);
+    trace(STRINGV_TRACE_COLUMN_IMPORT, 1, stringv, (size_t)count, -1,
+            result);
+    return result;
+}
+
+int stringv_column_import64(
+        struct stringv *stringv,
+        int64_t const *offsets,
+        char const *data,
+        int count)
+{
+    int result = 0;
+
+    trace(STRINGV_TRACE_COLUMN_IMPORT, 0, stringv, (size_t)count, -1, 0);
+    result = untraced_column_import64(stringv, offsets, data, count);
+    trace(STRINGV_TRACE_COLUMN_IMPORT, 1, stringv, (size_t)count, -1,
+            result);
+    return result;
+}
+
+int stringv_remove(struct stringv *stringv, string_pos sn)
+{
+    int result = 0;
+
+    trace(STRINGV_TRACE_REMOVE, 0, stringv, 0, sn, 0);
+    result = untraced_remove(stringv, sn);
+    trace(STRINGV_TRACE_REMOVE, 1, stringv, 0, sn, result);
+    return result;
+}
+
+int stringv_tombstone(struct stringv *stringv, string_pos sn)
+{
+    int result = 0;
+
+    trace(STRINGV_TRACE_TOMBSTONE, 0, stringv, 0, sn, 0);
+    result = untraced_tombstone(stringv, sn);
+    trace(STRINGV_TRACE_TOMBSTONE, 1, stringv, 0, sn, result);
+    return result;
+}
+
+int stringv_compact(struct stringv *stringv)
+{
+    size_t const size = used_bytes(stringv);
+    int result = 0;
+
+    trace(STRINGV_TRACE_COMPACT, 0, stringv, size, -1, 0);
+    result = untraced_compact(stringv);
+    trace(STRINGV_TRACE_COMPACT, 1, stringv, size, -1, result);
+    return result;
+}
+
+int stringv_swap(struct stringv *stringv, string_pos a, string_pos b)
+{
+    size_t const size = used_bytes(stringv);
+    int result = 0;
+
+    trace(STRINGV_TRACE_SWAP, 0, stringv, size, a, 0);
+    result = untraced_swap(stringv, a, b);
+    trace(STRINGV_TRACE_SWAP, 1, stringv, size, a, result);
+    return result;
+}
+
+int stringv_rotate(struct stringv *stringv, string_pos middle)
+{
+    size_t const size = used_bytes(stringv);
+    int result = 0;
+
+    trace(STRINGV_TRACE_ROTATE, 0, stringv, size, middle, 0);
+    result = untraced_rotate(stringv, middle);
+    trace(STRINGV_TRACE_ROTATE, 1, stringv, size, middle, result);
+    return result;
+}
+
+int stringv_reverse(struct stringv *stringv)
+{
+    size_t const size = used_bytes(stringv);
+    int result = 0;
+
+    trace(STRINGV_TRACE_REVERSE, 0, stringv, size, -1, 0);
+    result = untraced_reverse(stringv);
+    trace(STRINGV_TRACE_REVERSE, 1, stringv, size, -1, result);
+    return result;
+}
+
+int stringv_stable_partition(
+        struct stringv *stringv,
+        string_predicate predicate,
+        void *context)
+{
+    size_t const size = used_bytes(stringv);
+    int result = 0;
+
+    trace(STRINGV_TRACE_STABLE_PARTITION, 0, stringv, size, -1, 0);
+    result = untraced_stable_partition(stringv, predicate, context);
+    trace(STRINGV_TRACE_STABLE_PARTITION, 1, stringv, size, -1, result);
+    return result;
+}
+
+int stringv_snapshot_copy(
+        struct stringv *dest,
+        struct stringv_snapshot *snapshot)
+{
+    size_t const size = snapshot ? used_bytes(&snapshot->state) : 0;
+    int result = 0;
+
+    trace(STRINGV_TRACE_SNAPSHOT_COPY, 0, dest, size, -1, 0);
+    result = untraced_snapshot_copy(dest, snapshot);
+    trace(STRINGV_TRACE_SNAPSHOT_COPY, 1, dest, size, -1, result);
+    return result;
+}
+
+#endif /* defined(STRINGV_TRACE) */
@@ -2,6 +2,7 @@
 #define STRINGV_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -9,18 +10,99 @@ extern "C" {
 
 #if defined(__STDC__) && defined(__STD_VERSION__) && __STD_VERSION__ >= 199901
 #   define STRINGV_RESTRICT     restrict
-#   define STRINGV_ZERO         (struct stringv){NULL,0,0,0,0}
+#   define STRINGV_ZERO         (struct stringv){NULL,0,0,0,0,0,NULL}
 #else
 #   define STRINGV_RESTRICT     /* Nothing */
-#   define STRINGV_ZERO         {NULL,0,0,0,0}
+#   define STRINGV_ZERO         {NULL,0,0,0,0,0,NULL}
 #endif /* defined(__STDC__) && ... */
 
+struct stringv_snapshot;
+
 struct stringv {
     char *buf;
     int block_total;
     int block_size;
     int block_used;
     int string_count;
+    int dead_count;
+    struct stringv_snapshot *snapshot;
+};
+
+/* The position of a columnar export, begun by stringv_column_begin. The
+ * fields should be treated as read-only. */
+struct stringv_column_cursor {
+    struct stringv const *stringv;
+    char const *iter;
+};
+
+/* The progress of stringv_reblock into a new buffer, from which a reblock
+ * that ran out of room can be resumed. It must be zeroed before the first
+ * call, and its fields should be treated as read-only. */
+struct stringv_reblock_progress {
+    int next_block;     /* The stringv's block holding the next string */
+    int block_used;     /* The blocks of the new buffer used so far */
+    int string_count;   /* The strings reblocked so far */
+};
+
+/* A copy-on-write snapshot of a stringv, taken by stringv_snapshot_take. The
+ * snapshotted blocks are divided into chunks of chunk_size chars. A chunk is
+ * read from the live buffer until the stringv is about to modify it, at which
+ * point its contents are first preserved in the store. chunk_map holds the
+ * state of each chunk: the index of its preserved copy in the store, or one
+ * of the negative states defined in stringv.c. The fields should be treated
+ * as read-only. */
+struct stringv_snapshot {
+    struct stringv *stringv;
+    struct stringv state;
+    char *store;
+    int *chunk_map;
+    int chunk_size;
+    int chunk_count;
+    int store_total;
+    int store_used;
+    int lost_count;
+};
+
+/* Summary of a stringv's space usage, as reported by stringv_get_stats. The
+ * string counts are live strings (those visible through stringv_get and
+ * iteration) and dead strings (tombstoned by stringv_tombstone but not yet
+ * compacted away). */
+struct stringv_stats {
+    int live_count;
+    int dead_count;
+    int live_blocks;
+    int dead_blocks;
+    int free_blocks;
+};
+
+/* The cost of storing a set of strings with one candidate block size, as
+ * reported by stringv_analyze. The lookup cost is the expected number of
+ * blocks visited to find a string at a uniformly random position: a single
+ * block when every string fits in one block, and otherwise the blocks walked
+ * from the start of the stringv, plus the string's own block. */
+struct stringv_block_analysis {
+    int block_size;         /* The candidate, set by the caller */
+    long block_count;       /* Blocks needed to store every string */
+    double padding;         /* Fraction of those blocks' chars left unused */
+    double multi_block;     /* Fraction of strings spanning several blocks */
+    double lookup_cost;     /* Expected blocks visited by a random lookup */
+    double score;           /* The weighted objective; lower is better */
+};
+
+/* Counts of the work done inside the stringv functions, for finding out why
+ * a workload is slow. The counters are only kept when stringv.c is compiled
+ * with STRINGV_COUNTERS defined, and cost nothing otherwise. Each thread has
+ * its own counters where the compiler supports thread-local storage (C11 or
+ * GNU C); elsewhere all threads share one unsynchronised set. */
+struct stringv_counters {
+    unsigned long long bytes_moved;     /* memmoved to open or close gaps */
+    unsigned long long bytes_zeroed;    /* cleared to free blocks */
+    unsigned long long blocks_scanned;  /* walked to find a string's block */
+    unsigned long long fast_lookups;    /* strings found without a walk */
+    unsigned long long slow_lookups;    /* strings found by walking blocks */
+    unsigned long long blockwise_copies;    /* copies of whole block ranges */
+    unsigned long long stringwise_copies;   /* copies string by string */
+    unsigned long long capacity_failures;   /* writes refused for space */
 };
 
 /* The string_pos is an integral quantity that determines (uniquely) a
@@ -34,12 +116,66 @@ typedef int string_pos;
  * the second respectively. */
 typedef int (*lexicographical_compare)(char const *, char const *, size_t);
 
+/* Predicate function used to select strings in a stringv. Currently only
+ * used by stringv_stable_partition. The function is given each string along
+ * with the context pointer passed by the caller, and should return nonzero
+ * if the string is selected. */
+typedef int (*string_predicate)(char const *, void *);
+
+/* The traced stringv functions, as reported in a stringv_trace_event */
+enum stringv_trace_op {
+    STRINGV_TRACE_INIT,
+    STRINGV_TRACE_CLEAR,
+    STRINGV_TRACE_COPY,
+    STRINGV_TRACE_APPEND,
+    STRINGV_TRACE_REBLOCK,
+    STRINGV_TRACE_PUSH_BACK,
+    STRINGV_TRACE_PUSH_FRONT,
+    STRINGV_TRACE_INSERT,
+    STRINGV_TRACE_REPLACE,
+    STRINGV_TRACE_SPLIT_C,
+    STRINGV_TRACE_SPLIT_S,
+    STRINGV_TRACE_JOIN,
+    STRINGV_TRACE_COLUMN_IMPORT,
+    STRINGV_TRACE_REMOVE,
+    STRINGV_TRACE_TOMBSTONE,
+    STRINGV_TRACE_COMPACT,
+    STRINGV_TRACE_SWAP,
+    STRINGV_TRACE_ROTATE,
+    STRINGV_TRACE_REVERSE,
+    STRINGV_TRACE_STABLE_PARTITION,
+    STRINGV_TRACE_SNAPSHOT_COPY
+};
+
+/* An event passed to the trace hook on entry to and exit from a traced
+ * function. size is the function's length argument (the string, input or
+ * output buffer length, or the string count for a column import), or for
+ * operations on a whole stringv the bytes in its used blocks on entry. time
+ * is read from the monotonic clock (CLOCK_MONOTONIC), which all threads
+ * share, so events from different threads can be ordered and timed. */
+struct stringv_trace_event {
+    enum stringv_trace_op op;
+    int exit;                       /* 0 on entry, 1 on exit */
+    struct stringv const *stringv;  /* The stringv operated on */
+    size_t size;
+    string_pos position;            /* The string position argument, or -1 */
+    long result;    /* On exit, the return value (pointers give 1 or 0) */
+    uint64_t time;  /* In nanoseconds, or 0 without a monotonic clock */
+};
+
+/* Function called with each trace event, along with the context pointer
+ * registered with it. */
+typedef void (*stringv_trace_hook)(struct stringv_trace_event const *, void *);
+
 /* Initialises a stringv to an initial valid (but empty) state with the
  * given block size. If the function succeeds, a pointer to an initialised
  * stringv is returned. If the function fails, no external state is
- * modified.
+ * modified. An initialised stringv may be reinitialised only once any
+ * snapshot of it has been released: the snapshot's chunks are not preserved
+ * before the buffer is cleared, so the snapshot would read zeroed blocks.
  *
- *      stringv     A pointer to an uninitialised stringv.
+ *      stringv     A pointer to an uninitialised stringv, or to one with no
+ *                  active snapshot.
  *      buf         A pointer to a writable buffer which will serve as the
  *                  storage for the stringv. buf must be NUL terminated.
  *      buf_size    The size of buf, in chars, including the terminating
@@ -55,7 +191,10 @@ typedef int (*lexicographical_compare)(char const *, char const *, size_t);
  *                  buf_size > 1
  *                  1 < block_size <= buf_size
  *                  buf[buf_size] == '\0'
+ *                  stringv has no active snapshot
  *      POST:       stringv->block_used == stringv->string_count == 0
+ *                  stringv->dead_count == 0
+ *                  stringv->snapshot == NULL
  *                  stringv->buf = {0, ..., 0}
  */
 struct stringv *stringv_init(
@@ -68,7 +207,8 @@ struct stringv *stringv_init(
  * arguments are invalid or the index is out of range, the function will
  * return NULL. stringv_get can be used to iterate, but it is inefficient
  * since stringv_get must count blocks from the beginning each time. For
- * iteration, use stringv_begin/stringv_next/stringv_end.
+ * iteration, use stringv_begin/stringv_next/stringv_end. Tombstoned strings
+ * are skipped, so n counts live strings only.
  *
  *      stringv     The stringv to read from.
  *      n           The position, starting from 0, that determines which
@@ -78,7 +218,7 @@ struct stringv *stringv_init(
  *                  value will be NULL.
  *
  *      PRE:        stringv != NULL
- *                  0 <= n < stringv->string_count
+ *                  0 <= n < stringv->string_count - stringv->dead_count
  *      POST:       stringv unchanged
  */
 char const *stringv_get(struct stringv const *stringv, int n);
@@ -94,6 +234,7 @@ char const *stringv_get(struct stringv const *stringv, int n);
  *      POST:       (stringv != NULL) ==> (stringv->buf == {0, ..., 0})
  *                          && (stringv->block_used == 0)
  *                          && (stringv->string_count == 0)
+ *                          && (stringv->dead_count == 0)
  *                  Iterators invalidated
  */
 struct stringv *stringv_clear(struct stringv *stringv);
@@ -104,7 +245,8 @@ struct stringv *stringv_clear(struct stringv *stringv);
  * destination stringv may be different, and their sizes are fixed, it may
  * not be possible to store all strings from the source stringv in the
  * destination stringv. stringv_copy will copy as many strings as possible,
- * and return the number of strings copied.
+ * and return the number of live strings copied. Tombstoned strings are copied
+ * as tombstones when the copy is done blockwise, and dropped otherwise.
  *
  *      dest        The stringv to write to. dest is cleared as if through
  *                  a call to stringv_clear (its block size is retained).
@@ -122,13 +264,87 @@ int stringv_copy(
         struct stringv *STRINGV_RESTRICT dest,
         struct stringv const *STRINGV_RESTRICT source);
 
+/* Appends the strings stored in the source stringv to the end of the dest-
+ * ination stringv, as many as will fit. When the block sizes match and there
+ * is room for all of them, the source blocks are appended with a single
+ * memcpy; otherwise strings are appended one at a time as in stringv_copy.
+ * Tombstoned strings are carried over as tombstones when the copy is done
+ * blockwise, and dropped otherwise.
+ *
+ *      dest        The stringv to append to.
+ *      source      The stringv to read from.
+ *      RETURNS     The number of live strings appended.
+ *
+ *      PRE:        dest != NULL
+ *                  source != NULL
+ *                  dest != source
+ *      POST:       source unchanged
+ *                  dest->block_size unchanged
+ *                  Strings previously stored in dest are unchanged
+ */
+int stringv_append(
+        struct stringv *STRINGV_RESTRICT dest,
+        struct stringv const *STRINGV_RESTRICT source);
+
+/* Changes the block size of a stringv, either by moving its strings into a
+ * new buffer or by rearranging them within its own.
+ *
+ * Given a buffer, each live string is read once and written once to it, and
+ * only the last block of a string is searched for its end (no block is
+ * searched if the stringv is one-to-one and the block size is growing).
+ * Tombstoned strings are dropped. On success the stringv uses buf, and its
+ * old buffer is no longer referenced. If buf runs out of room, the stringv is
+ * unchanged and progress records the point reached: progress->string_count
+ * is the position of the first live string that didn't fit. The reblock is
+ * resumed by calling again with the same block size and progress, and a
+ * larger buffer starting with the contents of the previous one (as after a
+ * realloc). The stringv must not be modified in between.
+ *
+ * Given a NULL buffer, the strings are rearranged in place, which is possible
+ * only when the stringv is one-to-one and, if the block size is shrinking,
+ * every string fits in a block of the new size. Tombstones are kept.
+ *
+ *      stringv     The stringv to reblock.
+ *      block_size  The new block size.
+ *      buf         The new buffer, which must not overlap the stringv's, or
+ *                  NULL to reblock in place.
+ *      buf_size    The size of buf, as for stringv_init. Ignored if buf is
+ *                  NULL.
+ *      progress    The progress of a reblock into buf, or NULL if it need
+ *                  not be resumable. Ignored if buf is NULL.
+ *      RETURNS     1 when reblocked, 0 when buf ran out of room, and -1 when
+ *                  the arguments are invalid, the stringv has a snapshot, or
+ *                  an in place reblock is impossible or out of room.
+ *
+ *      PRE:        stringv != NULL
+ *                  block_size > 1
+ *                  stringv->snapshot == NULL
+ *                  buf != NULL ==> buf[buf_size] == '\0'
+ *                  buf == NULL ==> stringv->string_count ==
+ *                      stringv->block_used
+ *      POST:       RETURNS 1 ==> stringv->block_size == block_size
+ *                  RETURNS 1 ==> live strings and their order unchanged
+ *                  RETURNS 1 && buf != NULL ==> stringv->buf == buf
+ *                  RETURNS 1 && buf != NULL ==> stringv->dead_count == 0
+ *                  RETURNS != 1 ==> stringv unchanged
+ */
+int stringv_reblock(
+        struct stringv *stringv,
+        int block_size,
+        char *buf,
+        int buf_size,
+        struct stringv_reblock_progress *progress);
+
 /* Appends a string to the stringv, returning a pointer to its location,
  * or NULL on error. The index of the appended string can be recovered
- * immediately through stringv->string_count - 1. The pointer returned
+ * immediately through stringv->string_count - stringv->dead_count - 1, as
+ * indices count live strings only. The pointer returned
  * is const, since overwriting the string's blocks may violate the
  * invariants of stringv. Unsafe insertion operations (that return mutable
  * pointers) are provided. If the function fails, no external state is
- * modified.
+ * modified. The string may not contain NUL, which marks the ends of strings
+ * in the blocks and marks tombstoned strings; this applies to every function
+ * that writes a string.
  *
  *      stringv     The stringv to write to.
  *      string      The string to write to the stringv. string doesn't
@@ -144,9 +360,11 @@ int stringv_copy(
  *      PRE:        stringv != NULL
  *                  string != NULL
  *                  length > 0
+ *                  string[0..length) contains no NUL
  *      POST:       stringv->block_used increased
  *                  stringv->string_count incremented
- *                  return pointer == &(stringv->string_count - 1)th string
+ *                  return pointer == stringv_get(stringv,
+ *                          stringv->string_count - stringv->dead_count - 1)
  *                  Iterators invalidated
  */
 char const *stringv_push_back(
@@ -173,6 +391,7 @@ char const *stringv_push_back(
  *      PRE:        stringv != NULL
  *                  string != NULL
  *                  length > 0
+ *                  string[0..length) contains no NUL
  *      POST:       stringv->block_used increased
  *                  stringv->string_count incremented
  *                  return pointer == &(0th string) == &stringv->buf[0]
@@ -188,7 +407,8 @@ char const *stringv_push_front(
  * the buffer managed by the stringv object such that its index will be the
  * index as given by the corresponding function argument. This function will
  * fail for invalid arguments or insufficient space. If the function fails,
- * no external state is modified.
+ * no external state is modified. As in stringv_get, the index counts live
+ * strings only.
  *
  *      stringv     The stringv to write to.
  *      string      The string to write to the stringv. NUL termination is not
@@ -201,7 +421,9 @@ char const *stringv_push_front(
  *      PRE:        stringv != NULL
  *                  string != NULL
  *                  length > 0
- *                  index >= 0 && index < stringv->string_count
+ *                  string[0..length) contains no NUL
+ *                  index >= 0
+ *                  index <= stringv->string_count - stringv->dead_count
  *      POST:       stringv_get(stringv, index) == string
  *                  Iterators invalidated
  */
@@ -211,6 +433,37 @@ char const *stringv_insert(
         size_t length,
         int index);
 
+/* Replaces the string at the specified index with the given string,
+ * returning a pointer to the new string or NULL on error. If the new string
+ * needs as many blocks as the old one, it is overwritten in place. Otherwise
+ * the blocks to its right are shifted once by the difference in block
+ * counts, which is cheaper than a stringv_remove followed by a stringv_insert.
+ * This function will fail for invalid arguments or insufficient space. If
+ * the function fails, no external state is modified.
+ *
+ *      stringv     The stringv to write to.
+ *      sn          The position of the string to replace. As in stringv_get,
+ *                  it counts live strings only.
+ *      string      The replacement string. NUL termination is not required.
+ *      length      The length of the replacement string, in chars.
+ *      RETURNS     A non-writable pointer to the written string on success,
+ *                  or NULL on failure.
+ *
+ *      PRE:        stringv != NULL
+ *                  string != NULL
+ *                  length > 0
+ *                  string[0..length) contains no NUL
+ *                  sn >= 0 && sn < stringv->string_count - stringv->dead_count
+ *      POST:       stringv_get(stringv, sn) == string
+ *                  stringv->string_count unchanged
+ *                  Iterators invalidated if the block count changed
+ */
+char const *stringv_replace(
+        struct stringv *STRINGV_RESTRICT stringv,
+        string_pos sn,
+        char const *STRINGV_RESTRICT string,
+        size_t length);
+
 /* Inserts into a stringv each substring of the given string, up to length,
  * where each substring is delimited by the given separator character. The
  * string is inserted as if a call to string_push_back was made. If there is
@@ -222,8 +475,8 @@ char const *stringv_insert(
  *      length      The length of the argument string.
  *      separator   The separator (delimiting) character.
  *      RETURNS     The index of the first non-delimiter character that was
- *                  not read into the stringv if there is insufficient space,
- *                  or length otherwise.
+ *                  not read into the stringv if there is insufficient space
+ *                  or a substring contains NUL, or length otherwise.
  *
  *      PRE:        stringv != NULL
  *                  string != NULL
@@ -248,8 +501,8 @@ size_t stringv_split_c(
  *      separator_length    The length of the separator string, in chars.
  *      RETURNS             The index of the first non-delimiter character
  *                          in the argument string that was not read into the
- *                          stringv if there was insufficient space, or length
- *                          otherwise.
+ *                          stringv if there was insufficient space or a
+ *                          substring contains NUL, or length otherwise.
  *
  *      PRE:                stringv != NULL
  *                          string != NULL
@@ -265,22 +518,461 @@ size_t stringv_split_s(
         char const *STRINGV_RESTRICT separator,
         size_t separator_length);
 
+/* Joins the live strings of a stringv into a single string, with the given
+ * separator between each pair of adjacent strings, and writes it to out with
+ * a NUL terminator. The length of the result is computed before anything is
+ * written, so if out is too small (or NULL) nothing is written, and the
+ * return value gives the size needed, as with snprintf. A one-to-one stringv
+ * is joined without scanning past the end of any block, and on SSE2 targets
+ * its terminators are found and its strings copied 16 chars at a time.
+ *
+ *      stringv     The stringv to join.
+ *      separator   The separator. NUL termination is not required. May be
+ *                  NULL if separator_length is 0.
+ *      separator_length
+ *                  The length of the separator, in chars.
+ *      out         The buffer to write the joined string to.
+ *      out_size    The size of out, in chars.
+ *      RETURNS     The length of the joined string, in chars, not including
+ *                  the NUL terminator. It was written to out if and only if
+ *                  the return value is less than out_size. Returns 0 if the
+ *                  arguments are invalid.
+ *
+ *      PRE:        stringv != NULL
+ *                  separator != NULL || separator_length == 0
+ *      POST:       stringv unchanged
+ */
+size_t stringv_join(
+        struct stringv const *STRINGV_RESTRICT stringv,
+        char const *STRINGV_RESTRICT separator,
+        size_t separator_length,
+        char *STRINGV_RESTRICT out,
+        size_t out_size);
+
+/* Begins exporting the live strings of a stringv as a column in the Arrow
+ * layout: a contiguous data buffer holding every string without terminators,
+ * and an offsets array in which string i spans [offsets[i], offsets[i + 1])
+ * of the data. The column is produced in batches by stringv_column_export or
+ * stringv_column_export64. The stringv must not be modified until the export
+ * is finished.
+ *
+ *      cursor      The export cursor to begin.
+ *      stringv     The stringv to export.
+ *      RETURNS     cursor, or NULL if either argument is NULL.
+ *
+ *      PRE:        cursor != NULL
+ *                  stringv != NULL
+ *      POST:       stringv unchanged
+ */
+struct stringv_column_cursor *stringv_column_begin(
+        struct stringv_column_cursor *STRINGV_RESTRICT cursor,
+        struct stringv const *STRINGV_RESTRICT stringv);
+
+/* Exports the next batch of strings of a column export, as many as fit in
+ * both caller buffers. Each batch is a complete column of its own, with
+ * offsets[0] == 0 and offsets[count] the size of its data. A one-to-one
+ * stringv is exported without strlen, as in stringv_join. The chars of data
+ * past offsets[count] are unspecified.
+ *
+ *      cursor      The export cursor.
+ *      offsets     Receives the offsets, an array of max_count + 1 entries.
+ *      data        Receives the strings.
+ *      max_count   The largest number of strings to export.
+ *      data_size   The size of data, in chars.
+ *      RETURNS     The number of strings exported, 0 once every string has
+ *                  been, or -1 if the arguments are invalid or the next
+ *                  string alone is larger than data.
+ *
+ *      PRE:        cursor was begun by stringv_column_begin
+ *                  offsets != NULL
+ *                  data != NULL
+ *                  max_count > 0
+ */
+int stringv_column_export(
+        struct stringv_column_cursor *STRINGV_RESTRICT cursor,
+        int32_t *STRINGV_RESTRICT offsets,
+        char *STRINGV_RESTRICT data,
+        int max_count,
+        size_t data_size);
+
+/* As stringv_column_export, with the 64 bit offsets of the Arrow large
+ * string layout. */
+int stringv_column_export64(
+        struct stringv_column_cursor *STRINGV_RESTRICT cursor,
+        int64_t *STRINGV_RESTRICT offsets,
+        char *STRINGV_RESTRICT data,
+        int max_count,
+        size_t data_size);
+
+/* Appends the strings of a column in the Arrow layout to a stringv, as if
+ * each were passed to stringv_push_back. The column may be a slice, with
+ * offsets[0] != 0. Either every string is appended or none are. Strings that
+ * fit in a block are written (on SSE2 targets) with masked vector stores,
+ * which fill in the zero padding as they go.
+ *
+ *      stringv     The stringv to append to.
+ *      offsets     The offsets, an array of count + 1 entries.
+ *      data        The data buffer the offsets index.
+ *      count       The number of strings in the column.
+ *      RETURNS     The number of strings appended, or -1 if the arguments
+ *                  are invalid, the offsets decrease, a string is empty or
+ *                  contains a NUL (a stringv can store neither) or the
+ *                  stringv is too full.
+ *
+ *      PRE:        stringv != NULL
+ *                  offsets != NULL
+ *                  data != NULL
+ *                  count >= 0
+ *      POST:       The strings previously in stringv are unchanged
+ */
+int stringv_column_import(
+        struct stringv *STRINGV_RESTRICT stringv,
+        int32_t const *STRINGV_RESTRICT offsets,
+        char const *STRINGV_RESTRICT data,
+        int count);
+
+/* As stringv_column_import, with 64 bit offsets. */
+int stringv_column_import64(
+        struct stringv *STRINGV_RESTRICT stringv,
+        int64_t const *STRINGV_RESTRICT offsets,
+        char const *STRINGV_RESTRICT data,
+        int count);
+
 /* Removes the string specified by the index argument from the stringv.
  * Returns 1 on success or 0 on failure, occuring when the arguments are
- * invalid or the index is out of range
+ * invalid or the index is out of range. The index counts live strings only.
+ * For churn-heavy workloads, stringv_tombstone avoids the block shift.
  *
  *      stringv     The stringv to remove from.
  *      sn          The position of the string to remove
  *      RETURNS     1 on success, 0 on failure
  *
  *      PRE:        stringv != NULL
- *                  index >= 0 && index < stringv->string_count
+ *                  index >= 0
+ *                  index < stringv->string_count - stringv->dead_count
  *      POST:       stringv->string_count decremented
  *                  stringv->block_used decreased
  *                  Iterators invalidated
  */
 int stringv_remove(struct stringv *stringv, string_pos sn);
 
+/* Marks the string specified by the index argument as dead without moving
+ * any other string. The string's chars are overwritten with NUL (keeping
+ * only the last char of each of its blocks but the last), and no live string
+ * can start with NUL, so the operation takes time proportional to the
+ * string's length once it has been located. Dead strings are skipped by
+ * stringv_get and iteration and their blocks are reclaimed by
+ * stringv_compact. If more than STRINGV_COMPACT_PERCENT percent of the stored
+ * strings are dead after the call, the stringv is compacted immediately.
+ * Returns 1 on success or 0 on failure, occuring when the arguments are
+ * invalid or the index is out of range.
+ *
+ *      stringv     The stringv to remove from.
+ *      sn          The position of the string to tombstone.
+ *      RETURNS     1 on success, 0 on failure
+ *
+ *      PRE:        stringv != NULL
+ *                  sn >= 0 && sn < stringv->string_count - stringv->dead_count
+ *      POST:       stringv->string_count - stringv->dead_count decremented
+ *                  Iterators to other strings remain valid unless the
+ *                  stringv was compacted
+ */
+int stringv_tombstone(struct stringv *stringv, string_pos sn);
+
+/* Removes every tombstoned string from the stringv in a single pass over the
+ * used blocks, moving each run of live strings left at most once. Returns
+ * the number of blocks reclaimed.
+ *
+ *      stringv     The stringv to compact.
+ *      RETURNS     The number of blocks freed.
+ *
+ *      PRE:        stringv != NULL
+ *      POST:       stringv->dead_count == 0
+ *                  Live strings retain their relative order
+ *                  Iterators invalidated
+ */
+int stringv_compact(struct stringv *stringv);
+
+/* Fills stats with a summary of the stringv's space usage. Counting dead
+ * blocks requires a scan of the used blocks unless the stringv is one-to-
+ * one, so this function should not be called on a hot path.
+ *
+ *      stringv     The stringv to inspect.
+ *      stats       The structure to fill.
+ *      RETURNS     stats, or NULL if either argument is NULL.
+ *
+ *      PRE:        stringv != NULL
+ *                  stats != NULL
+ *      POST:       stringv unchanged
+ */
+struct stringv_stats *stringv_get_stats(
+        struct stringv const *STRINGV_RESTRICT stringv,
+        struct stringv_stats *STRINGV_RESTRICT stats);
+
+/* Analyses the cost of storing strings of the given lengths, in the given
+ * order, with each candidate block size, and recommends the candidate best
+ * suited to them. Each candidate's score is its memory use relative to the
+ * least of any candidate, times memory_weight, plus its lookup cost relative
+ * to the least of any candidate, times latency_weight. The candidate with
+ * the lowest score is recommended, the first listed winning ties. Lengths of
+ * zero are skipped, since a stringv doesn't store empty strings.
+ *
+ *      lengths         The lengths of the strings, excluding terminators.
+ *      count           The number of lengths.
+ *      memory_weight   The weight given to memory use.
+ *      latency_weight  The weight given to lookup cost.
+ *      analyses        The candidates, whose block_size members the caller
+ *                      sets. The other members are filled in.
+ *      analysis_count  The number of candidates.
+ *      RETURNS         The recommended block size, or 0 if the arguments
+ *                      are invalid or there are no nonzero lengths.
+ *
+ *      PRE:            lengths != NULL
+ *                      count > 0
+ *                      memory_weight >= 0 && latency_weight >= 0
+ *                      analyses != NULL
+ *                      analysis_count > 0
+ *                      analyses[i].block_size > 1 for each candidate
+ *      POST:           Each candidate's analysis is filled in
+ */
+int stringv_analyze(
+        size_t const *lengths,
+        int count,
+        double memory_weight,
+        double latency_weight,
+        struct stringv_block_analysis *analyses,
+        int analysis_count);
+
+/* As stringv_analyze, taking the lengths of a stringv's live strings. This
+ * reports how the stringv's contents would be stored with each candidate
+ * block size, whatever the block size it has now.
+ *
+ *      stringv         The stringv to analyse.
+ *      (Other arguments as for stringv_analyze.)
+ *      RETURNS         The recommended block size, or 0 if the arguments
+ *                      are invalid or the stringv has no live strings.
+ *
+ *      PRE:            stringv != NULL
+ *                      (Other preconditions as for stringv_analyze.)
+ *      POST:           stringv unchanged
+ */
+int stringv_analyze_stringv(
+        struct stringv const *stringv,
+        double memory_weight,
+        double latency_weight,
+        struct stringv_block_analysis *analyses,
+        int analysis_count);
+
+/* Copies the calling thread's operation counters into counters, and zeroes
+ * them if reset is nonzero. Unless stringv.c is compiled with
+ * STRINGV_COUNTERS defined, the copied counters are always zero.
+ *
+ *      counters    The structure to fill.
+ *      reset       Nonzero to zero the thread's counters after copying.
+ *      RETURNS     counters, or NULL if counters is NULL.
+ *
+ *      PRE:        counters != NULL
+ *      POST:       reset ==> the thread's counters are zero
+ */
+struct stringv_counters *stringv_get_counters(
+        struct stringv_counters *counters,
+        int reset);
+
+/* Registers a function to be called on entry to and exit from each function
+ * that modifies a stringv (and stringv_split_c, stringv_split_s and
+ * stringv_join), so that the latency and sizes of individual calls can be
+ * recorded. Lookups and iteration are not traced. The hook is only called
+ * when stringv.c is compiled with STRINGV_TRACE defined; otherwise tracing
+ * compiles out entirely and this function does nothing. Compiling with
+ * STRINGV_USDT defined as well adds the USDT probes stringv:entry and
+ * stringv:exit (from <sys/sdt.h>), whose arguments are the event's fields.
+ *
+ * The hook is shared by all threads. When compiled with the GCC/Clang
+ * __atomic builtins, it may be changed while other threads are calling the
+ * traced functions: each event is passed to either the old or the new hook,
+ * always with that hook's own context, so the old context must outlive any
+ * calls still in flight. Only one thread may change the hook at a time.
+ * Without the builtins, the hook must be registered before any stringv is
+ * used by more than one thread.
+ *
+ *      hook        The function to call, or NULL to stop tracing.
+ *      context     Passed to each call of hook.
+ *      RETURNS     The previously registered hook, or NULL if there was
+ *                  none or tracing is compiled out.
+ *
+ *      POST:       STRINGV_TRACE defined ==> hook is called for each event
+ */
+stringv_trace_hook stringv_set_trace_hook(
+        stringv_trace_hook hook,
+        void *context);
+
+/* Exchanges the positions of two strings in the stringv. Strings using the
+ * same number of blocks are swapped block for block; otherwise the blocks
+ * between them are rotated so that no string is copied out of the buffer.
+ * Returns 1 on success or 0 on failure, occuring when the arguments are
+ * invalid or either index is out of range.
+ *
+ *      stringv     The stringv to modify.
+ *      a           The position of the first string. As in stringv_get,
+ *                  positions count live strings only.
+ *      b           The position of the second string.
+ *      RETURNS     1 on success, 0 on failure
+ *
+ *      PRE:        stringv != NULL
+ *                  a >= 0 && a < stringv->string_count - stringv->dead_count
+ *                  b >= 0 && b < stringv->string_count - stringv->dead_count
+ *      POST:       The strings at a and b are exchanged
+ *                  Iterators invalidated
+ */
+int stringv_swap(struct stringv *stringv, string_pos a, string_pos b);
+
+/* Rotates the strings in the stringv so that the string at position middle
+ * becomes the first string, and the strings before it are moved to the end
+ * in their original order. Returns 1 on success or 0 on failure, occuring
+ * when the arguments are invalid or middle is out of range.
+ *
+ *      stringv     The stringv to modify.
+ *      middle      The position of the string to rotate to the front. The
+ *                  rotation is a no-op if middle is 0 or the live string
+ *                  count.
+ *      RETURNS     1 on success, 0 on failure
+ *
+ *      PRE:        stringv != NULL
+ *                  middle >= 0
+ *                  middle <= stringv->string_count - stringv->dead_count
+ *      POST:       Iterators invalidated
+ */
+int stringv_rotate(struct stringv *stringv, string_pos middle);
+
+/* Reverses the order of the strings in the stringv. Returns 1 on success or
+ * 0 if stringv is NULL.
+ *
+ *      stringv     The stringv to modify.
+ *      RETURNS     1 on success, 0 on failure
+ *
+ *      PRE:        stringv != NULL
+ *      POST:       Iterators invalidated
+ */
+int stringv_reverse(struct stringv *stringv);
+
+/* Reorders the strings in the stringv so that every string for which the
+ * predicate returns nonzero precedes every string for which it returns
+ * zero, preserving the relative order of the strings within each group. The
+ * partition is done in place by block rotations, taking O(n log n) block
+ * moves for n strings. Tombstoned strings are not passed to the predicate
+ * and end up in the second group.
+ *
+ *      stringv     The stringv to modify.
+ *      predicate   The function selecting the strings of the first group.
+ *      context     Passed through to each call of predicate.
+ *      RETURNS     The number of strings in the first group, ie. the
+ *                  position of the first string of the second group, or -1
+ *                  if the arguments are invalid.
+ *
+ *      PRE:        stringv != NULL
+ *                  predicate != NULL
+ *      POST:       Iterators invalidated
+ */
+int stringv_stable_partition(
+        struct stringv *stringv,
+        string_predicate predicate,
+        void *context);
+
+/* Takes a copy-on-write snapshot of a stringv in O(chunks) time, without
+ * copying any strings. From then on, each stringv function that modifies the
+ * stringv first preserves the original contents of any snapshotted chunk it
+ * is about to change, so the writer only pays for the chunks it touches.
+ * Appending to a stringv touches no snapshotted chunks at all.
+ *
+ * The snapshot may be read with stringv_snapshot_read or stringv_snapshot_copy
+ * from another thread while the writer continues to modify the stringv (when
+ * compiled with the GCC/Clang __atomic builtins; otherwise, from the writer's
+ * thread only). Only modifications made by the stringv functions are seen; the
+ * buffer must not be written to directly. If the store fills up, chunks that
+ * are modified afterwards are lost, and reads of them fail. A stringv has at
+ * most one snapshot at a time.
+ *
+ *      snapshot    The snapshot to initialise.
+ *      stringv     The stringv to snapshot.
+ *      chunk_size  The size of the chunks, in chars.
+ *      chunk_map   An array of map_size ints, used to track the chunks.
+ *      map_size    The number of elements in chunk_map. It must be at least
+ *                  the number of chunks, ceil(block_used * block_size /
+ *                  chunk_size).
+ *      store       The storage for preserved chunks. May be NULL if
+ *                  store_size is 0.
+ *      store_size  The size of store, in chars.
+ *      RETURNS     snapshot on success, or NULL if the arguments are invalid,
+ *                  chunk_map is too small or stringv already has a snapshot.
+ *
+ *      PRE:        snapshot != NULL
+ *                  stringv != NULL
+ *                  stringv->snapshot == NULL
+ *                  chunk_size > 0
+ *                  chunk_map != NULL
+ *      POST:       stringv->snapshot == snapshot
+ *                  stringv unchanged otherwise
+ */
+struct stringv_snapshot *stringv_snapshot_take(
+        struct stringv_snapshot *STRINGV_RESTRICT snapshot,
+        struct stringv *STRINGV_RESTRICT stringv,
+        int chunk_size,
+        int *STRINGV_RESTRICT chunk_map,
+        int map_size,
+        char *STRINGV_RESTRICT store,
+        int store_size);
+
+/* Detaches a snapshot from its stringv, which then stops preserving chunks.
+ * Must be called by the thread modifying the stringv, once no other thread is
+ * reading the snapshot. Any further reads of the snapshot fail.
+ *
+ *      snapshot    The snapshot to release.
+ *
+ *      PRE:        snapshot != NULL
+ *      POST:       The stringv's snapshot member is NULL
+ */
+void stringv_snapshot_release(struct stringv_snapshot *snapshot);
+
+/* Copies one chunk of a snapshot into out. Chunks which have not been
+ * modified since the snapshot was taken are read from the live buffer, during
+ * which the writer waits to modify them; others are read from the store.
+ *
+ *      snapshot    The snapshot to read.
+ *      chunk       The chunk to read, in [0, snapshot->chunk_count).
+ *      out         The buffer to copy into, of at least chunk_size chars.
+ *      RETURNS     The number of chars copied, which is less than chunk_size
+ *                  only for the last chunk, or -1 if the arguments are
+ *                  invalid, the snapshot has been released or the chunk was
+ *                  lost.
+ *
+ *      PRE:        snapshot != NULL
+ *                  out != NULL
+ */
+int stringv_snapshot_read(
+        struct stringv_snapshot *STRINGV_RESTRICT snapshot,
+        int chunk,
+        char *STRINGV_RESTRICT out);
+
+/* Copies the contents of a snapshot into dest, which then holds the strings
+ * of the stringv as they were when the snapshot was taken. The copy is made
+ * chunk by chunk as in stringv_snapshot_read, directly into dest's buffer.
+ *
+ *      dest        The stringv to copy into. It is cleared first.
+ *      snapshot    The snapshot to copy.
+ *      RETURNS     The number of live strings copied, or -1 if the arguments
+ *                  are invalid, dest has a different block size or too few
+ *                  blocks, or a chunk could not be read (in which case dest
+ *                  is left empty).
+ *
+ *      PRE:        dest != NULL
+ *                  snapshot != NULL
+ *                  dest is not the snapshotted stringv
+ *                  dest->block_size == snapshot->state.block_size
+ */
+int stringv_snapshot_copy(
+        struct stringv *STRINGV_RESTRICT dest,
+        struct stringv_snapshot *STRINGV_RESTRICT snapshot);
+
 /* Returns the address of the first string in the stringv suitable for
  * iteration.
  *
@@ -313,7 +1005,8 @@ char const *stringv_end(struct stringv const *stringv);
  * the pointer returned by stringv_next is undefined behaviour if the
  * address lies beyond the stringv's buffer. When calling stringv_next in an
  * iterative context, a comparison with stringv_end should be made at each
- * iteration in order to avoid invoking undefined behaviour.
+ * iteration in order to avoid invoking undefined behaviour. Tombstoned
+ * strings are skipped.
  *
  *      stringv     The stringv to iterate upon.
  *      iter        The iterator to return the next iterator to.
@@ -0,0 +1,393 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stringv_concurrent.h"
+
+#include <assert.h>
+#include <sched.h>
+#include <string.h>
+
+/* The atomic operations are written with the GCC/Clang __atomic builtins,
+ * which are available in C99 mode (unlike <stdatomic.h>). */
+#if !defined(__GNUC__)
+#   error "stringv_concurrent requires the GCC/Clang __atomic builtins"
+#endif /* !defined(__GNUC__) */
+
+/* The number of times a waiting writer polls before yielding its time slice.
+ * Publishing a string takes a handful of stores, so a writer is usually
+ * waiting on a predecessor that is running; yielding immediately would only
+ * help when the predecessor has been preempted. */
+#define SPIN_LIMIT  64
+
+/* Determines how many blocks of the given size would be required to store a
+ * string of the given length (NOT including the NUL terminator). */
+static int blocks_required(int block_size, size_t length);
+
+/* Waits until every string whose blocks were reserved before the given block
+ * position has been published, and no other writer is publishing. */
+static void wait_for_turn(struct stringv_concurrent *cs, int first);
+
+/* Ends a write to the published state, making the sequence counter even.
+ * Unlike stringv_concurrent_write_end, the reservation counter is left alone,
+ * since other writers may have reserved blocks past the published ones. */
+static void write_end(struct stringv_concurrent *cs);
+
+/* Reads the sequence counter at the start of a read, waiting for any write in
+ * progress to end. */
+static unsigned read_begin(struct stringv_concurrent const *cs);
+
+/* Checks at the end of a read that no write overlapped it. */
+static int read_end(struct stringv_concurrent const *cs, unsigned sequence);
+
+/* Reads the published counts of a concurrent stringv into view. Only
+ * meaningful if validated by read_end. */
+static void read_counts(
+        struct stringv_concurrent const *cs,
+        struct stringv *view);
+
+/* Copies the string at the nth live position of the given view into out,
+ * returning its length, or 0 if it couldn't be found. The buffer may be
+ * modified during the read, so unlike stringv_get, the search never leaves
+ * the used blocks or trusts the data it reads to be consistent. */
+static size_t copy_string(
+        struct stringv const *view,
+        string_pos n,
+        char *out,
+        size_t out_size);
+
+struct stringv_concurrent *stringv_concurrent_init(
+        struct stringv_concurrent *cs,
+        char *buf,
+        int buf_size,
+        int block_size)
+{
+    if (!cs || !stringv_init(&cs->stringv, buf, buf_size, block_size)) {
+        return NULL;
+    }
+
+    cs->block_reserved = 0;
+    cs->sequence = 0;
+    return cs;
+}
+
+char const *stringv_concurrent_push_back(
+        struct stringv_concurrent *cs,
+        char const *string,
+        size_t length)
+{
+    char *write_ptr = NULL;
+    int block_size = 0, blocks_req = 0, first = 0, strings = 0;
+
+    if (!cs || !string || length == 0 || memchr(string, '\0', length)) {
+        return NULL;
+    }
+
+    /* The block size and total never change after initialisation, so they
+     * can be read without synchronisation. */
+    block_size = cs->stringv.block_size;
+    if (length >= (size_t)cs->stringv.block_total * (size_t)block_size) {
+        return NULL;
+    }
+
+    /* Reserve the blocks. A plain fetch-and-add could overshoot the block
+     * total, and the reservation couldn't then be undone once a later writer
+     * had reserved past it, so the capacity check is part of the CAS loop. */
+    blocks_req = blocks_required(block_size, length);
+    first = __atomic_load_n(&cs->block_reserved, __ATOMIC_RELAXED);
+    do {
+        if (first + blocks_req > cs->stringv.block_total) {
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(
+                &cs->block_reserved,
+                &first,
+                first + blocks_req,
+                1,
+                __ATOMIC_RELAXED,
+                __ATOMIC_RELAXED));
+
+    /* The reserved blocks belong to this writer alone, and are zero since
+     * every block beyond the used blocks is. */
+    write_ptr = memcpy(
+            cs->stringv.buf + (size_t)first * (size_t)block_size,
+            string,
+            length);
+
+    /* Publish in reservation order, so that the used blocks are always a
+     * prefix of fully written strings. */
+    wait_for_turn(cs, first);
+
+    stringv_concurrent_write_begin(cs);
+    strings = __atomic_load_n(&cs->stringv.string_count, __ATOMIC_RELAXED);
+    __atomic_store_n(&cs->stringv.string_count, strings + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(
+            &cs->stringv.block_used,
+            first + blocks_req,
+            __ATOMIC_RELEASE);
+    write_end(cs);
+
+    return write_ptr;
+}
+
+struct stringv *stringv_concurrent_view(
+        struct stringv_concurrent const *cs,
+        struct stringv *view)
+{
+    unsigned sequence = 0;
+
+    if (!cs || !view) {
+        return NULL;
+    }
+
+    do {
+        sequence = read_begin(cs);
+        read_counts(cs, view);
+    } while (!read_end(cs, sequence));
+
+    return view;
+}
+
+void stringv_concurrent_write_begin(struct stringv_concurrent *cs)
+{
+    unsigned sequence = 0;
+
+    assert(cs);
+
+    sequence = __atomic_load_n(&cs->sequence, __ATOMIC_RELAXED);
+    assert(!(sequence & 1u));
+
+    /* The fence keeps the stores made during the write from becoming
+     * visible before the counter is odd. */
+    __atomic_store_n(&cs->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void stringv_concurrent_write_end(struct stringv_concurrent *cs)
+{
+    assert(cs);
+
+    /* Keep the reservation counter in step with the used blocks, so that
+     * appends may resume after the stringv has been modified. */
+    __atomic_store_n(
+            &cs->block_reserved,
+            cs->stringv.block_used,
+            __ATOMIC_RELAXED);
+    write_end(cs);
+}
+
+size_t stringv_concurrent_get(
+        struct stringv_concurrent const *cs,
+        string_pos n,
+        char *out,
+        size_t out_size)
+{
+    struct stringv view;
+    unsigned sequence = 0;
+    size_t length = 0;
+
+    if (!cs || !out || out_size == 0 || n < 0) {
+        return 0;
+    }
+
+    do {
+        sequence = read_begin(cs);
+        read_counts(cs, &view);
+        length = n < view.string_count - view.dead_count
+            ? copy_string(&view, n, out, out_size)
+            : 0;
+    } while (!read_end(cs, sequence));
+
+    if (length == 0) {
+        *out = '\0';
+    }
+
+    return length;
+}
+
+int stringv_concurrent_read(
+        struct stringv_concurrent const *cs,
+        struct stringv *dest)
+{
+    struct stringv view;
+    unsigned sequence = 0;
+    int copied = 0, fits = 0, kept = 0;
+
+    if (!cs || !dest || dest->block_size != cs->stringv.block_size) {
+        return -1;
+    }
+
+    (void)stringv_clear(dest);
+
+    /* Blocks copied by a read that has to be retried may lie beyond the
+     * final snapshot's used blocks, so keep track of how far we wrote. */
+    do {
+        sequence = read_begin(cs);
+        read_counts(cs, &view);
+
+        fits = view.block_used <= dest->block_total;
+        if (fits) {
+            memcpy(dest->buf,
+                    view.buf,
+                    (size_t)view.block_used * (size_t)view.block_size);
+            if (view.block_used > copied) {
+                copied = view.block_used;
+            }
+        }
+    } while (!read_end(cs, sequence));
+
+    kept = fits ? view.block_used : 0;
+    memset(dest->buf + (size_t)kept * (size_t)view.block_size,
+            0,
+            (size_t)(copied - kept) * (size_t)view.block_size);
+
+    if (!fits) {
+        return -1;
+    }
+
+    dest->block_used = view.block_used;
+    dest->string_count = view.string_count;
+    dest->dead_count = view.dead_count;
+    return dest->string_count - dest->dead_count;
+}
+
+int blocks_required(int block_size, size_t length)
+{
+    assert(block_size > 1);
+    assert(length != 0);
+
+    /* Increment the length to accomodate the NUL character */
+    ++length;
+
+    return (int)((length / (size_t)block_size) +
+        (length % (size_t)block_size != 0));
+}
+
+void wait_for_turn(struct stringv_concurrent *cs, int first)
+{
+    int spins = 0;
+
+    assert(cs);
+
+    /* The previous writer stores block_used before it makes the sequence
+     * counter even again, so once block_used reaches first we must also
+     * wait for the sequence counter, or this writer's write_begin could
+     * read a stale odd value. */
+    while (__atomic_load_n(&cs->stringv.block_used, __ATOMIC_ACQUIRE) != first
+            || (__atomic_load_n(&cs->sequence, __ATOMIC_ACQUIRE) & 1u)) {
+        if (++spins == SPIN_LIMIT) {
+            spins = 0;
+            (void)sched_yield();
+        }
+    }
+}
+
+void write_end(struct stringv_concurrent *cs)
+{
+    unsigned const sequence =
+        __atomic_load_n(&cs->sequence, __ATOMIC_RELAXED);
+
+    assert(sequence & 1u);
+    __atomic_store_n(&cs->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+unsigned read_begin(struct stringv_concurrent const *cs)
+{
+    unsigned sequence = 0;
+    int spins = 0;
+
+    assert(cs);
+
+    while ((sequence = __atomic_load_n(&cs->sequence, __ATOMIC_ACQUIRE))
+            & 1u) {
+        if (++spins == SPIN_LIMIT) {
+            spins = 0;
+            (void)sched_yield();
+        }
+    }
+
+    return sequence;
+}
+
+int read_end(struct stringv_concurrent const *cs, unsigned sequence)
+{
+    assert(cs);
+
+    /* The fence keeps the reads made since read_begin from being satisfied
+     * after the counter is read again. */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&cs->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+void read_counts(struct stringv_concurrent const *cs, struct stringv *view)
+{
+    assert(cs && view);
+
+    /* The buffer, block size and block total never change after
+     * initialisation. */
+    view->buf = cs->stringv.buf;
+    view->block_total = cs->stringv.block_total;
+    view->block_size = cs->stringv.block_size;
+    view->block_used = __atomic_load_n(
+            &cs->stringv.block_used,
+            __ATOMIC_RELAXED);
+    view->string_count = __atomic_load_n(
+            &cs->stringv.string_count,
+            __ATOMIC_RELAXED);
+    view->dead_count = __atomic_load_n(
+            &cs->stringv.dead_count,
+            __ATOMIC_RELAXED);
+    view->snapshot = NULL;
+}
+
+size_t copy_string(
+        struct stringv const *view,
+        string_pos n,
+        char *out,
+        size_t out_size)
+{
+    size_t const block_size = (size_t)view->block_size;
+    char const *const end = view->buf + (size_t)view->block_used * block_size;
+    char const *string = NULL, *nul = NULL;
+    size_t length = 0;
+    int bn = 0;
+
+    assert(view && out && out_size > 0);
+
+    if (view->block_used > view->block_total
+            || view->string_count > view->block_used) {
+        return 0;
+    }
+
+    if (view->dead_count == 0 && view->string_count == view->block_used) {
+        /* One-to-one, so the string_pos is the block_pos */
+        bn = n;
+    } else {
+        /* Count strings as stringv_get would, skipping tombstones. A block
+         * ends a string if its last char is NUL. */
+        for (;;) {
+            if (bn >= view->block_used) {
+                return 0;
+            }
+
+            if (view->buf[(size_t)bn * block_size] != '\0') {
+                if (n == 0) {
+                    break;
+                }
+                --n;
+            }
+
+            while (bn < view->block_used
+                    && view->buf[((size_t)bn + 1) * block_size - 1] != '\0') {
+                ++bn;
+            }
+            ++bn;
+        }
+    }
+
+    string = view->buf + (size_t)bn * block_size;
+    nul = memchr(string, '\0', (size_t)(end - string));
+    length = nul ? (size_t)(nul - string) : (size_t)(end - string);
+
+    memcpy(out, string, length < out_size ? length : out_size - 1);
+    out[length < out_size ? length : out_size - 1] = '\0';
+    return length;
+}
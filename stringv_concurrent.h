@@ -0,0 +1,178 @@
+#ifndef STRINGV_CONCURRENT_H_
+#define STRINGV_CONCURRENT_H_
+
+#include <stddef.h>
+
+#include "stringv.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/* A stringv shared between threads. The wrapped stringv must only be
+ * accessed through the functions declared here while other threads may be
+ * using it.
+ *
+ * In append-only mode, any number of threads may call
+ * stringv_concurrent_push_back at once. Each writer reserves its blocks with
+ * an atomic update of block_reserved and copies its string without holding a
+ * lock. Writers then publish their strings in reservation order by advancing
+ * stringv.block_used and stringv.string_count, so a reader never sees a
+ * string that is still being written. Since strings are never moved in this
+ * mode, pointers obtained from a view remain valid for as long as the buffer
+ * does.
+ *
+ * In single-writer mode, one thread may modify the stringv with any of the
+ * stringv functions, provided each modification is bracketed by
+ * stringv_concurrent_write_begin and stringv_concurrent_write_end. Since a
+ * modification may move strings, readers must copy strings out with
+ * stringv_concurrent_get or stringv_concurrent_read rather than hold pointers
+ * into the buffer. Views are not safe in this mode.
+ *
+ * The published state is guarded by a sequence counter, which is odd while
+ * it is being updated. Readers take no locks and never block a writer: they
+ * retry until they see the same even value before and after reading, so a
+ * read only repeats when it overlapped a write. The two modes must not be
+ * mixed at the same time, but a concurrent stringv may switch between them
+ * while no writer is active. */
+struct stringv_concurrent {
+    struct stringv stringv;
+    int block_reserved;
+    unsigned sequence;
+};
+
+/* Initialises a concurrent stringv, as stringv_init does for a stringv. The
+ * function is not thread safe: the concurrent stringv must not be shared
+ * until it returns.
+ *
+ *      cs          A pointer to an uninitialised concurrent stringv.
+ *      buf         The storage for the stringv. See stringv_init.
+ *      buf_size    The size of buf, in chars.
+ *      block_size  The desired size of the blocks, in chars.
+ *      RETURNS     cs on success, NULL on failure.
+ *
+ *      PRE:        cs != NULL
+ *                  The remaining arguments satisfy stringv_init
+ *      POST:       cs->stringv is empty
+ */
+struct stringv_concurrent *stringv_concurrent_init(
+        struct stringv_concurrent *cs,
+        char *buf,
+        int buf_size,
+        int block_size);
+
+/* Appends a string to a concurrent stringv. May be called from any number of
+ * threads at once. The function returns once the string, and every string
+ * whose blocks were reserved before it, is visible to readers. If the
+ * function fails, no external state is modified.
+ *
+ *      cs          The concurrent stringv to write to.
+ *      string      The string to append. NUL termination is not required.
+ *      length      The length of the string, in chars.
+ *      RETURNS     A non-writable pointer to the appended string, or NULL if
+ *                  the arguments are invalid or there is insufficient space.
+ *
+ *      PRE:        cs != NULL
+ *                  string != NULL
+ *                  length > 0
+ *                  string[0..length) contains no NUL
+ *      POST:       The string is visible to subsequent views
+ */
+char const *stringv_concurrent_push_back(
+        struct stringv_concurrent *STRINGV_RESTRICT cs,
+        char const *STRINGV_RESTRICT string,
+        size_t length);
+
+/* Takes a consistent snapshot of the published state of a concurrent stringv
+ * and stores it in view. The view is an ordinary stringv, which may be read
+ * with stringv_get and the iteration functions but must not be modified. It
+ * contains only strings that were completely written when it was taken. May
+ * be called from any number of threads at once.
+ *
+ *      cs          The concurrent stringv to read.
+ *      view        The stringv to store the snapshot in.
+ *      RETURNS     view, or NULL if either argument is NULL.
+ *
+ *      PRE:        cs != NULL
+ *                  view != NULL
+ *      POST:       cs unchanged
+ */
+struct stringv *stringv_concurrent_view(
+        struct stringv_concurrent const *STRINGV_RESTRICT cs,
+        struct stringv *STRINGV_RESTRICT view);
+
+/* Begins a modification of a concurrent stringv in single-writer mode. The
+ * caller may then modify cs->stringv with the stringv functions until it
+ * calls stringv_concurrent_write_end. Readers that overlap the modification
+ * retry once it has ended, so modifications should be short. Only one thread
+ * may be writing at a time, and no thread may be appending with
+ * stringv_concurrent_push_back.
+ *
+ *      cs          The concurrent stringv about to be modified.
+ *
+ *      PRE:        cs != NULL
+ *                  No write is in progress
+ */
+void stringv_concurrent_write_begin(struct stringv_concurrent *cs);
+
+/* Ends a modification begun by stringv_concurrent_write_begin, publishing the
+ * new state of the stringv to readers.
+ *
+ *      cs          The concurrent stringv that was modified.
+ *
+ *      PRE:        cs != NULL
+ *                  A write is in progress
+ *      POST:       cs->stringv may be read (and appended to) concurrently
+ */
+void stringv_concurrent_write_end(struct stringv_concurrent *cs);
+
+/* Copies the string at the nth position of a concurrent stringv into out,
+ * retrying if a write overlaps the read. The copy is truncated to fit and is
+ * always NUL terminated. May be called from any number of threads at once,
+ * in either mode.
+ *
+ *      cs          The concurrent stringv to read.
+ *      n           The position of the string, counting live strings only.
+ *      out         The buffer to copy the string into.
+ *      out_size    The size of out, in chars.
+ *      RETURNS     The length of the string (which may be greater than the
+ *                  number of chars copied), or 0 if n is out of range or the
+ *                  arguments are invalid.
+ *
+ *      PRE:        cs != NULL
+ *                  out != NULL
+ *                  out_size > 0
+ *      POST:       cs unchanged
+ */
+size_t stringv_concurrent_get(
+        struct stringv_concurrent const *STRINGV_RESTRICT cs,
+        string_pos n,
+        char *STRINGV_RESTRICT out,
+        size_t out_size);
+
+/* Copies a consistent snapshot of a concurrent stringv into dest, retrying if
+ * a write overlaps the copy. The snapshot is copied blockwise, so dest must
+ * have the same block size as cs->stringv. The caller may then iterate over
+ * dest at leisure. May be called from any number of threads at once, in
+ * either mode.
+ *
+ *      cs          The concurrent stringv to read.
+ *      dest        The stringv to copy into. It is cleared first.
+ *      RETURNS     The number of live strings copied, or -1 if the arguments
+ *                  are invalid or dest is too small for the snapshot (in
+ *                  which case dest is left empty).
+ *
+ *      PRE:        cs != NULL
+ *                  dest != NULL
+ *                  dest->block_size == cs->stringv.block_size
+ *      POST:       cs unchanged
+ */
+int stringv_concurrent_read(
+        struct stringv_concurrent const *STRINGV_RESTRICT cs,
+        struct stringv *STRINGV_RESTRICT dest);
+
+#if defined(__cplusplus)
+}
+#endif /* defined(__cplusplus) */
+
+#endif /* STRINGV_CONCURRENT_H_ */
@@ -0,0 +1,192 @@
+#ifndef STRINGV_FIXED_H_
+#define STRINGV_FIXED_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "stringv.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/* STRINGV_FIXED(name, size) defines a family of inline functions for
+ * stringvs whose block size is the constant size, which must be greater than
+ * 1. With the block size known at compile time, block addresses and
+ * block counts are computed with shifts (or, for other sizes, multiplies)
+ * instead of divisions, and the fixed-size compares in name_find become
+ * vector compares. The functions operate on an ordinary struct stringv, so
+ * any of the stringv functions may be used alongside them, and each has the
+ * semantics of the stringv function of the same name:
+ *
+ *      name_init(stringv, buf, buf_size)
+ *      name_get(stringv, sn)
+ *      name_push_back(stringv, string, length)
+ *      name_begin(stringv)
+ *      name_end(stringv)
+ *      name_next(stringv, iter)
+ *
+ * as well as
+ *
+ *      name_find(stringv, string, length)
+ *
+ * which returns the position of the first live string equal to the given
+ * string, or -1 if there is none.
+ *
+ * The fast paths assume a stringv without tombstones (and, for name_get and
+ * name_find, one-to-one); otherwise, and whenever a snapshot is active or a
+ * push_back fails, they defer to the stringv functions. The fast paths are
+ * not seen by STRINGV_COUNTERS or STRINGV_TRACE.
+ *
+ *      PRE:        stringv->block_size == size for each function
+ *                  but name_init
+ */
+#define STRINGV_FIXED(name, size)                                           \
+                                                                            \
+static inline struct stringv *name##_init(                                  \
+        struct stringv *stringv,                                            \
+        char *buf,                                                          \
+        int buf_size)                                                       \
+{                                                                           \
+    return stringv_init(stringv, buf, buf_size, (size));                    \
+}                                                                           \
+                                                                            \
+static inline char const *name##_get(                                       \
+        struct stringv const *stringv,                                      \
+        string_pos sn)                                                      \
+{                                                                           \
+    if (stringv                                                             \
+            && stringv->string_count == stringv->block_used                 \
+            && stringv->dead_count == 0                                     \
+            && sn >= 0                                                      \
+            && sn < stringv->string_count) {                                \
+        assert(stringv->block_size == (size));                              \
+        return stringv->buf + (size_t)sn * (size_t)(size);                  \
+    }                                                                       \
+                                                                            \
+    return stringv_get(stringv, sn);                                        \
+}                                                                           \
+                                                                            \
+static inline char const *name##_push_back(                                 \
+        struct stringv *stringv,                                            \
+        char const *string,                                                 \
+        size_t length)                                                      \
+{                                                                           \
+    char *block = NULL;                                                     \
+    size_t blocks = 0;                                                      \
+                                                                            \
+    /* The blocks needed hold length + 1 chars, rounded up. A string with  \
+     * a NUL in it is left to stringv_push_back to reject. */               \
+    if (stringv && string && length > 0 && !stringv->snapshot               \
+            && !memchr(string, '\0', length)) {                             \
+        assert(stringv->block_size == (size));                              \
+        blocks = (length + (size_t)(size)) / (size_t)(size);                \
+        if (blocks                                                          \
+                <= (size_t)(stringv->block_total - stringv->block_used)) {  \
+            block = stringv->buf                                            \
+                + (size_t)stringv->block_used * (size_t)(size);             \
+            memcpy(block, string, length);                                  \
+            stringv->block_used += (int)blocks;                             \
+            ++stringv->string_count;                                        \
+            return block;                                                   \
+        }                                                                   \
+    }                                                                       \
+                                                                            \
+    return stringv_push_back(stringv, string, length);                      \
+}                                                                           \
+                                                                            \
+static inline char const *name##_begin(struct stringv const *stringv)       \
+{                                                                           \
+    assert(stringv);                                                        \
+    assert(stringv->block_size == (size));                                  \
+    return stringv->dead_count == 0                                         \
+        ? stringv->buf                                                      \
+        : stringv_begin(stringv);                                           \
+}                                                                           \
+                                                                            \
+static inline char const *name##_end(struct stringv const *stringv)         \
+{                                                                           \
+    assert(stringv);                                                        \
+    assert(stringv->block_size == (size));                                  \
+    return stringv->buf                                                     \
+        + (size_t)stringv->block_used * (size_t)(size);                     \
+}                                                                           \
+                                                                            \
+static inline char const *name##_next(                                      \
+        struct stringv const *stringv,                                      \
+        char const *iter)                                                   \
+{                                                                           \
+    assert(stringv);                                                        \
+    assert(stringv->block_size == (size));                                  \
+    assert(iter);                                                           \
+                                                                            \
+    if (stringv->dead_count > 0) {                                          \
+        return stringv_next(stringv, iter);                                 \
+    }                                                                       \
+                                                                            \
+    /* A string ends in the first block whose last char is NUL */           \
+    do {                                                                    \
+        iter += (size);                                                     \
+    } while (*(iter - 1) != '\0');                                          \
+                                                                            \
+    return iter;                                                            \
+}                                                                           \
+                                                                            \
+static inline int name##_find(                                              \
+        struct stringv const *stringv,                                      \
+        char const *string,                                                 \
+        size_t length)                                                      \
+{                                                                           \
+    char key[(size)] = {0};                                                 \
+    char const *iter = NULL;                                                \
+    int sn = 0;                                                             \
+                                                                            \
+    if (!stringv || !string) {                                              \
+        return -1;                                                          \
+    }                                                                       \
+                                                                            \
+    assert(stringv->block_size == (size));                                  \
+                                                                            \
+    /* In a one-to-one stringv, each block holds one string padded with     \
+     * zeros, so it can be compared whole with the string padded the same   \
+     * way. A longer string can't be found there at all. */                 \
+    if (stringv->string_count == stringv->block_used                        \
+            && stringv->dead_count == 0) {                                  \
+        if (length == 0 || length >= (size_t)(size)) {                      \
+            return -1;                                                      \
+        }                                                                   \
+                                                                            \
+        memcpy(key, string, length);                                        \
+        for (sn = 0; sn < stringv->string_count; ++sn) {                    \
+            if (memcmp(stringv->buf + (size_t)sn * (size_t)(size),          \
+                        key,                                                \
+                        (size)) == 0) {                                     \
+                return sn;                                                  \
+            }                                                               \
+        }                                                                   \
+                                                                            \
+        return -1;                                                          \
+    }                                                                       \
+                                                                            \
+    for (iter = name##_begin(stringv);                                      \
+            iter != name##_end(stringv);                                    \
+            iter = name##_next(stringv, iter), ++sn) {                      \
+        if (strncmp(iter, string, length) == 0                              \
+                && iter[length] == '\0') {                                  \
+            return sn;                                                      \
+        }                                                                   \
+    }                                                                       \
+                                                                            \
+    return -1;                                                              \
+}
+
+STRINGV_FIXED(stringv16, 16)
+STRINGV_FIXED(stringv32, 32)
+STRINGV_FIXED(stringv64, 64)
+
+#if defined(__cplusplus)
+}
+#endif /* defined(__cplusplus) */
+
+#endif /* STRINGV_FIXED_H_ */
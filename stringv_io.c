@@ -0,0 +1,874 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stringv_io.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* The magic number at the start of every saved stringv */
+static char const file_magic[8] = {'S', 'T', 'R', 'I', 'N', 'G', 'V', '\0'};
+
+/* Written as-is, this reads back as a different value on a machine of the
+ * other byte order */
+#define FILE_BYTE_ORDER     0x01020304u
+
+/* The alignment of the tables within a saved stringv */
+#define TABLE_ALIGNMENT     8
+
+/* The number of table entries buffered before each write */
+#define TABLE_BATCH         1024
+
+/* The number of iovecs gathered into each writev call by stringv_write_fd */
+#if defined(IOV_MAX) && IOV_MAX < 1024
+#   define WRITE_BATCH      IOV_MAX
+#else
+#   define WRITE_BATCH      1024
+#endif /* defined(IOV_MAX) && ... */
+
+/* A chunk of a file being loaded by stringv_load. A chunk is full from when
+ * the reader has filled it until the splitter has finished with it. */
+struct load_chunk {
+    char *buf;
+    size_t length;
+    int full;
+};
+
+/* The state shared by the two threads of stringv_load. The reader fills the
+ * chunks in turn, then sets done; the splitter empties them in the same
+ * order, and sets stop if it gives up early. */
+struct loader {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    struct load_chunk chunks[STRINGV_LOAD_BUFFERS];
+    size_t chunk_size;
+    int fd;
+    int done;
+    int stop;
+    int error;
+};
+
+/* The carry area of stringv_load, holding a substring that spans chunks */
+struct load_carry {
+    char *buf;
+    size_t length;
+    size_t size;
+};
+
+/* Fills in the header of the image of a stringv, computing the offsets of
+ * each of its parts. */
+static void layout_image(
+        struct stringv const *STRINGV_RESTRICT stringv,
+        int flags,
+        struct stringv_file_header *STRINGV_RESTRICT header);
+
+/* Writes the image of a stringv, as laid out by layout_image, to a file.
+ * Returns 1 on success, 0 on failure. */
+static int write_image(
+        int fd,
+        struct stringv const *STRINGV_RESTRICT stringv,
+        struct stringv_file_header const *STRINGV_RESTRICT header);
+
+/* Writes either the index table (if lengths is zero) or the length table of
+ * a stringv. Returns 1 on success, 0 on failure. */
+static int write_table(int fd, struct stringv const *stringv, int lengths);
+
+/* Writes size chars to a file, retrying after partial writes and signals.
+ * Returns 1 on success, 0 on failure. */
+static int write_all(int fd, void const *data, size_t size);
+
+/* Writes every iovec of a batch to a file, retrying after partial writes and
+ * signals. The iovecs are modified. Returns 1 on success, 0 on failure. */
+static int writev_all(int fd, struct iovec *iov, int count);
+
+/* Converts a non-writable pointer for use in an iovec, which is only read
+ * from when writing */
+static void *iov_pointer(void const *p);
+
+/* Writes size zero chars to a file. Returns 1 on success, 0 on failure. */
+static int write_zeros(int fd, size_t size);
+
+/* Maps the whole of an open file with the given protection and flags and
+ * checks the image of the stringv in it. Returns file, or NULL if the file
+ * can't be mapped or the image is invalid. */
+static struct stringv_file *map_fd(
+        struct stringv_file *file,
+        int fd,
+        int prot,
+        int flags);
+
+/* Checks the image of a stringv at the given address and, if it is valid,
+ * points file at its contents. The image isn't copied. Returns file, or NULL
+ * if the image is invalid. */
+static struct stringv_file *map_image(
+        struct stringv_file *STRINGV_RESTRICT file,
+        void *STRINGV_RESTRICT map,
+        size_t map_size);
+
+/* Checks that each entry of the index and length tables of an image locates
+ * a non-empty string, and its terminator, within the image's used blocks.
+ * Returns 1 if they all do, 0 otherwise. */
+static int valid_tables(
+        struct stringv_file_header const *STRINGV_RESTRICT header,
+        int32_t const *STRINGV_RESTRICT index,
+        int32_t const *STRINGV_RESTRICT lengths);
+
+/* The body of the reader thread of stringv_load */
+static void *load_chunks(void *arg);
+
+/* Splits a chunk of a file into a stringv, appending to the carry area the
+ * trailing substring that the next chunk continues. Returns 1 on success, 0
+ * on failure, with errno set. */
+static int split_chunk(
+        struct stringv *STRINGV_RESTRICT stringv,
+        struct load_carry *STRINGV_RESTRICT carry,
+        char const *STRINGV_RESTRICT chunk,
+        size_t length,
+        int separator);
+
+/* Appends chars to the carry area. Returns 1 on success, 0 if the carry area
+ * is too small, with errno set. */
+static int carry_append(
+        struct load_carry *STRINGV_RESTRICT carry,
+        char const *STRINGV_RESTRICT chars,
+        size_t length);
+
+/* Appends a substring to a stringv, skipping it if it is empty, as
+ * stringv_split_c does. Returns 1 on success, 0 if the substring contains NUL
+ * or the stringv is full, with errno set. */
+static int load_string(
+        struct stringv *STRINGV_RESTRICT stringv,
+        char const *STRINGV_RESTRICT string,
+        size_t length);
+
+/* Rounds a size up to the next multiple of TABLE_ALIGNMENT */
+static uint64_t align_table(uint64_t size);
+
+void *load_chunks(void *arg)
+{
+    struct loader *const loader = arg;
+    struct load_chunk *chunk = NULL;
+    ssize_t got = 0;
+    int k = 0;
+
+    for (k = 0; ; k = (k + 1) % STRINGV_LOAD_BUFFERS) {
+        chunk = &loader->chunks[k];
+
+        pthread_mutex_lock(&loader->lock);
+        while (chunk->full && !loader->stop) {
+            pthread_cond_wait(&loader->changed, &loader->lock);
+        }
+
+        if (loader->stop) {
+            pthread_mutex_unlock(&loader->lock);
+            break;
+        }
+        pthread_mutex_unlock(&loader->lock);
+
+        /* The chunk is empty, so the splitter won't touch it until it is
+         * marked full again */
+        do {
+            got = read(loader->fd, chunk->buf, loader->chunk_size);
+        } while (got < 0 && errno == EINTR);
+
+        pthread_mutex_lock(&loader->lock);
+        if (got > 0) {
+            chunk->length = (size_t)got;
+            chunk->full = 1;
+        } else {
+            loader->error = got < 0 ? errno : 0;
+            loader->done = 1;
+        }
+        pthread_cond_broadcast(&loader->changed);
+        pthread_mutex_unlock(&loader->lock);
+
+        if (got <= 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+int split_chunk(
+        struct stringv *stringv,
+        struct load_carry *carry,
+        char const *chunk,
+        size_t length,
+        int separator)
+{
+    char const *first = chunk, *last = NULL;
+    char const *const end = chunk + length;
+
+    assert(stringv && carry && chunk);
+
+    while ((last = memchr(first, separator, (size_t)(end - first)))) {
+        /* The first substring may continue one from the previous chunk */
+        if (carry->length > 0) {
+            if (!carry_append(carry, first, (size_t)(last - first))
+                    || !load_string(stringv, carry->buf, carry->length)) {
+                return 0;
+            }
+            carry->length = 0;
+        } else if (!load_string(stringv, first, (size_t)(last - first))) {
+            return 0;
+        }
+
+        first = last + 1;
+    }
+
+    return carry_append(carry, first, (size_t)(end - first));
+}
+
+int carry_append(struct load_carry *carry, char const *chars, size_t length)
+{
+    assert(carry && chars);
+
+    if (length > carry->size - carry->length) {
+        errno = EOVERFLOW;
+        return 0;
+    }
+
+    memcpy(carry->buf + carry->length, chars, length);
+    carry->length += length;
+    return 1;
+}
+
+int load_string(struct stringv *stringv, char const *string, size_t length)
+{
+    assert(stringv && string);
+
+    if (length > 0 && memchr(string, '\0', length)) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (length > 0 && !stringv_push_back(stringv, string, length)) {
+        errno = ENOSPC;
+        return 0;
+    }
+
+    return 1;
+}
+
+int stringv_save(
+        struct stringv const *stringv,
+        char const *path,
+        int flags)
+{
+    int fd = -1, saved = 0, error = 0;
+
+    if (!stringv || !path) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+
+    saved = stringv_save_fd(stringv, fd, flags);
+
+    /* Report the first error, rather than any from close */
+    error = errno;
+    if (close(fd) != 0 && saved) {
+        return 0;
+    }
+
+    errno = error;
+    return saved;
+}
+
+int stringv_save_fd(struct stringv const *stringv, int fd, int flags)
+{
+    struct stringv_file_header header;
+
+    if (!stringv || fd < 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    layout_image(stringv, flags, &header);
+    return write_image(fd, stringv, &header);
+}
+
+int stringv_share(
+        struct stringv const *stringv,
+        char const *name,
+        int flags)
+{
+    int fd = -1, shared = 0, error = 0;
+
+    if (!stringv || !name) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    /* Shared memory objects can be written like files, which avoids mapping
+     * the object writable just to fill it */
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+
+    shared = stringv_save_fd(stringv, fd, flags);
+    error = errno;
+    (void)close(fd);
+
+    if (!shared) {
+        (void)shm_unlink(name);
+    }
+
+    errno = error;
+    return shared;
+}
+
+int stringv_write_fd(
+        struct stringv const *stringv,
+        int fd,
+        char const *separator)
+{
+    struct iovec iov[WRITE_BATCH];
+    char const *iter = NULL;
+    size_t const separator_length = separator ? strlen(separator) : 0;
+    int count = 0;
+
+    if (!stringv || fd < 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    for (iter = stringv_begin(stringv);
+            iter != stringv_end(stringv);
+            iter = stringv_next(stringv, iter)) {
+        /* Flush before the batch can't hold a string and its separator */
+        if (count > WRITE_BATCH - 2) {
+            if (!writev_all(fd, iov, count)) {
+                return 0;
+            }
+            count = 0;
+        }
+
+        iov[count].iov_base = iov_pointer(iter);
+        iov[count++].iov_len = strlen(iter);
+
+        if (separator_length > 0) {
+            iov[count].iov_base = iov_pointer(separator);
+            iov[count++].iov_len = separator_length;
+        }
+    }
+
+    return writev_all(fd, iov, count);
+}
+
+int stringv_load(
+        struct stringv *stringv,
+        char const *path,
+        int separator,
+        char *scratch,
+        size_t scratch_size)
+{
+    struct loader loader;
+    struct load_carry carry;
+    struct load_chunk *chunk = NULL;
+    pthread_t reader;
+    int loaded = 1, error = 0, full = 0, k = 0, i = 0;
+
+    if (!stringv
+            || !path
+            || !scratch
+            || scratch_size < STRINGV_LOAD_BUFFERS + 1) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    loader.fd = open(path, O_RDONLY);
+    if (loader.fd < 0) {
+        return 0;
+    }
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+    (void)posix_fadvise(loader.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif /* defined(POSIX_FADV_SEQUENTIAL) */
+
+    loader.chunk_size = scratch_size / (STRINGV_LOAD_BUFFERS + 1);
+    for (i = 0; i < STRINGV_LOAD_BUFFERS; ++i) {
+        loader.chunks[i].buf = scratch + (size_t)i * loader.chunk_size;
+        loader.chunks[i].length = 0;
+        loader.chunks[i].full = 0;
+    }
+
+    carry.buf = scratch + STRINGV_LOAD_BUFFERS * loader.chunk_size;
+    carry.length = 0;
+    carry.size = loader.chunk_size;
+    loader.done = loader.stop = loader.error = 0;
+
+    if ((error = pthread_mutex_init(&loader.lock, NULL)) != 0) {
+        (void)close(loader.fd);
+        errno = error;
+        return 0;
+    }
+
+    if ((error = pthread_cond_init(&loader.changed, NULL)) != 0) {
+        (void)pthread_mutex_destroy(&loader.lock);
+        (void)close(loader.fd);
+        errno = error;
+        return 0;
+    }
+
+    if ((error = pthread_create(&reader, NULL, load_chunks, &loader)) != 0) {
+        (void)pthread_cond_destroy(&loader.changed);
+        (void)pthread_mutex_destroy(&loader.lock);
+        (void)close(loader.fd);
+        errno = error;
+        return 0;
+    }
+
+    /* Split each chunk as soon as it is full, while the reader fills the
+     * next */
+    for (k = 0; ; k = (k + 1) % STRINGV_LOAD_BUFFERS) {
+        chunk = &loader.chunks[k];
+
+        pthread_mutex_lock(&loader.lock);
+        while (!chunk->full && !loader.done) {
+            pthread_cond_wait(&loader.changed, &loader.lock);
+        }
+        full = chunk->full;
+        pthread_mutex_unlock(&loader.lock);
+
+        /* The chunks are filled in order, so once the reader is done, an
+         * empty chunk means the whole file has been read */
+        if (!full) {
+            break;
+        }
+
+        if (!split_chunk(stringv, &carry, chunk->buf, chunk->length,
+                    separator)) {
+            error = errno;
+            loaded = 0;
+            break;
+        }
+
+        pthread_mutex_lock(&loader.lock);
+        chunk->full = 0;
+        pthread_cond_broadcast(&loader.changed);
+        pthread_mutex_unlock(&loader.lock);
+    }
+
+    pthread_mutex_lock(&loader.lock);
+    loader.stop = 1;
+    pthread_cond_broadcast(&loader.changed);
+    pthread_mutex_unlock(&loader.lock);
+    (void)pthread_join(reader, NULL);
+
+    if (loaded && loader.error) {
+        error = loader.error;
+        loaded = 0;
+    }
+
+    /* The last substring needn't be followed by a separator */
+    if (loaded && !load_string(stringv, carry.buf, carry.length)) {
+        error = errno;
+        loaded = 0;
+    }
+
+    (void)pthread_cond_destroy(&loader.changed);
+    (void)pthread_mutex_destroy(&loader.lock);
+    (void)close(loader.fd);
+
+    errno = error;
+    return loaded;
+}
+
+struct stringv_file *stringv_map_shared(struct stringv_file *file, int fd)
+{
+    if (!file || fd < 0) {
+        return NULL;
+    }
+
+    return map_fd(file, fd, PROT_READ, MAP_SHARED);
+}
+
+struct stringv_file *stringv_open_shared(
+        struct stringv_file *file,
+        char const *name)
+{
+    struct stringv_file *mapped = NULL;
+    int fd = -1;
+
+    if (!file || !name) {
+        return NULL;
+    }
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    mapped = map_fd(file, fd, PROT_READ, MAP_SHARED);
+    (void)close(fd);
+    return mapped;
+}
+
+struct stringv_file *stringv_open_mapped(
+        struct stringv_file *file,
+        char const *path)
+{
+    struct stringv_file *mapped = NULL;
+    int fd = -1;
+
+    if (!file || !path) {
+        return NULL;
+    }
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    /* A private writable mapping lets the stringv be modified like any other
+     * without writing to the file, and only copies the pages that are. */
+    mapped = map_fd(file, fd, PROT_READ | PROT_WRITE, MAP_PRIVATE);
+    (void)close(fd);
+    return mapped;
+}
+
+int stringv_close_mapped(struct stringv_file *file)
+{
+    int unmapped = 0;
+
+    if (!file || !file->map) {
+        return 0;
+    }
+
+    unmapped = munmap(file->map, file->map_size) == 0;
+    memset(&file->stringv, 0, sizeof(file->stringv));
+    file->stringv.buf = NULL;
+    file->stringv.snapshot = NULL;
+    file->index = file->lengths = NULL;
+    file->map = NULL;
+    file->map_size = 0;
+    return unmapped;
+}
+
+void layout_image(
+        struct stringv const *stringv,
+        int flags,
+        struct stringv_file_header *header)
+{
+    uint64_t offset = 0;
+
+    assert(stringv && header);
+
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, file_magic, sizeof(file_magic));
+    header->byte_order = FILE_BYTE_ORDER;
+    header->version = STRINGV_FILE_VERSION;
+    header->flags = (uint32_t)(flags & STRINGV_SAVE_INDEX);
+    header->block_size = stringv->block_size;
+    header->block_used = stringv->block_used;
+    header->string_count = stringv->string_count;
+    header->dead_count = stringv->dead_count;
+    header->live_count = stringv->string_count - stringv->dead_count;
+
+    /* A stringv must have at least one block, even if it is empty */
+    header->block_total = stringv->block_used > 0 ? stringv->block_used : 1;
+
+    header->blocks_offset = sizeof(*header);
+    offset = header->blocks_offset
+        + (uint64_t)header->block_total * (uint64_t)header->block_size + 1;
+
+    if (header->flags & STRINGV_SAVE_INDEX) {
+        header->index_offset = align_table(offset);
+        header->lengths_offset = header->index_offset
+            + (uint64_t)header->live_count * sizeof(int32_t);
+        offset = header->lengths_offset
+            + (uint64_t)header->live_count * sizeof(int32_t);
+    }
+
+    header->size = offset;
+}
+
+int write_image(
+        int fd,
+        struct stringv const *stringv,
+        struct stringv_file_header const *header)
+{
+    size_t const used = (size_t)stringv->block_used
+        * (size_t)stringv->block_size;
+    size_t const total = (size_t)header->block_total
+        * (size_t)header->block_size;
+
+    assert(stringv && header);
+
+    /* The blocks are followed by the NUL that terminates the buffer */
+    if (!write_all(fd, header, sizeof(*header))
+            || !write_all(fd, stringv->buf, used)
+            || !write_zeros(fd, total - used + 1)) {
+        return 0;
+    }
+
+    if (header->flags & STRINGV_SAVE_INDEX) {
+        if (!write_zeros(fd, (size_t)(header->index_offset
+                        - (header->blocks_offset + total + 1)))
+                || !write_table(fd, stringv, 0)
+                || !write_table(fd, stringv, 1)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int write_table(int fd, struct stringv const *stringv, int lengths)
+{
+    int32_t batch[TABLE_BATCH];
+    char const *iter = NULL;
+    int count = 0;
+
+    assert(stringv);
+
+    for (iter = stringv_begin(stringv);
+            iter != stringv_end(stringv);
+            iter = stringv_next(stringv, iter)) {
+        batch[count++] = lengths
+            ? (int32_t)strlen(iter)
+            : (int32_t)((iter - stringv->buf) / stringv->block_size);
+
+        if (count == TABLE_BATCH) {
+            if (!write_all(fd, batch, sizeof(batch))) {
+                return 0;
+            }
+            count = 0;
+        }
+    }
+
+    return write_all(fd, batch, (size_t)count * sizeof(batch[0]));
+}
+
+int write_all(int fd, void const *data, size_t size)
+{
+    char const *p = data;
+    ssize_t written = 0;
+
+    while (size > 0) {
+        written = write(fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+
+        p += written;
+        size -= (size_t)written;
+    }
+
+    return 1;
+}
+
+int writev_all(int fd, struct iovec *iov, int count)
+{
+    ssize_t written = 0;
+    size_t left = 0;
+
+    while (count > 0) {
+        written = writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+
+        /* Skip the iovecs that were written in full and trim the next */
+        left = (size_t)written;
+        while (count > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+
+    return 1;
+}
+
+void *iov_pointer(void const *p)
+{
+    union {
+        void const *in;
+        void *out;
+    } pun;
+
+    pun.in = p;
+    return pun.out;
+}
+
+int write_zeros(int fd, size_t size)
+{
+    static char const zeros[512] = {0};
+    size_t chunk = 0;
+
+    while (size > 0) {
+        chunk = size < sizeof(zeros) ? size : sizeof(zeros);
+        if (!write_all(fd, zeros, chunk)) {
+            return 0;
+        }
+        size -= chunk;
+    }
+
+    return 1;
+}
+
+struct stringv_file *map_fd(
+        struct stringv_file *file,
+        int fd,
+        int prot,
+        int flags)
+{
+    struct stat st;
+    void *map = NULL;
+
+    assert(file && fd >= 0);
+
+    if (fstat(fd, &st) != 0
+            || st.st_size < (off_t)sizeof(struct stringv_file_header)) {
+        return NULL;
+    }
+
+    map = mmap(NULL, (size_t)st.st_size, prot, flags, fd, 0);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    if (!map_image(file, map, (size_t)st.st_size)) {
+        (void)munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+
+    return file;
+}
+
+struct stringv_file *map_image(
+        struct stringv_file *file,
+        void *map,
+        size_t map_size)
+{
+    struct stringv_file_header const *const header = map;
+    char *const base = map;
+    uint64_t blocks_size = 0, blocks_end = 0, table_size = 0;
+    int32_t const *index = NULL, *lengths = NULL;
+
+    assert(file && map);
+
+    if (map_size < sizeof(*header)
+            || memcmp(header->magic, file_magic, sizeof(file_magic)) != 0
+            || header->byte_order != FILE_BYTE_ORDER
+            || header->version != STRINGV_FILE_VERSION
+            || header->size > map_size) {
+        return NULL;
+    }
+
+    /* Check the counts and offsets, so that a corrupt file can't make the
+     * stringv point outside the mapping */
+    if (header->block_size <= 1
+            || header->block_total <= 0
+            || header->block_used < 0
+            || header->block_used > header->block_total
+            || header->string_count < 0
+            || header->string_count > header->block_used
+            || header->dead_count < 0
+            || header->dead_count > header->string_count
+            || header->live_count != header->string_count - header->dead_count
+            || header->blocks_offset < sizeof(*header)) {
+        return NULL;
+    }
+
+    /* The sizes are products of ints and can't overflow, but an offset can be
+     * anything, so each part is checked against the room left after its
+     * offset rather than by adding the two */
+    blocks_size = (uint64_t)header->block_total * (uint64_t)header->block_size;
+    if (header->blocks_offset > header->size
+            || blocks_size + 1 > header->size - header->blocks_offset
+            || base[header->blocks_offset + blocks_size] != '\0') {
+        return NULL;
+    }
+
+    /* The tables follow the blocks and the NUL after them */
+    blocks_end = header->blocks_offset + blocks_size + 1;
+    if (header->flags & STRINGV_SAVE_INDEX) {
+        table_size = (uint64_t)header->live_count * sizeof(int32_t);
+        if (header->index_offset % sizeof(int32_t) != 0
+                || header->lengths_offset % sizeof(int32_t) != 0
+                || header->index_offset < blocks_end
+                || header->lengths_offset < blocks_end
+                || header->index_offset > header->size
+                || table_size > header->size - header->index_offset
+                || header->lengths_offset > header->size
+                || table_size > header->size - header->lengths_offset) {
+            return NULL;
+        }
+
+        index = (int32_t const *)(void *)(base + header->index_offset);
+        lengths = (int32_t const *)(void *)(base + header->lengths_offset);
+        if (!valid_tables(header, index, lengths)) {
+            return NULL;
+        }
+    }
+
+    file->index = index;
+    file->lengths = lengths;
+
+    file->stringv.buf = base + header->blocks_offset;
+    file->stringv.block_total = header->block_total;
+    file->stringv.block_size = header->block_size;
+    file->stringv.block_used = header->block_used;
+    file->stringv.string_count = header->string_count;
+    file->stringv.dead_count = header->dead_count;
+    file->stringv.snapshot = NULL;
+    file->map = map;
+    file->map_size = map_size;
+    return file;
+}
+
+int valid_tables(
+        struct stringv_file_header const *header,
+        int32_t const *index,
+        int32_t const *lengths)
+{
+    uint64_t const used =
+        (uint64_t)header->block_used * (uint64_t)header->block_size;
+    int i = 0;
+
+    assert(header && index && lengths);
+
+    for (i = 0; i < header->live_count; ++i) {
+        if (index[i] < 0
+                || index[i] >= header->block_used
+                || lengths[i] <= 0
+                || (uint64_t)index[i] * (uint64_t)header->block_size
+                    + (uint64_t)lengths[i] >= used) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+uint64_t align_table(uint64_t size)
+{
+    return (size + TABLE_ALIGNMENT - 1) / TABLE_ALIGNMENT * TABLE_ALIGNMENT;
+}
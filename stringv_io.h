@@ -0,0 +1,248 @@
+#ifndef STRINGV_IO_H_
+#define STRINGV_IO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "stringv.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/* The version of the file format written by stringv_save. Files of any other
+ * version are rejected by stringv_open_mapped. */
+#define STRINGV_FILE_VERSION    1
+
+/* The number of chunks stringv_load reads ahead into */
+#define STRINGV_LOAD_BUFFERS    2
+
+/* Flags for stringv_save */
+#define STRINGV_SAVE_INDEX      0x1     /* Write the index and length tables */
+
+/* The header of a saved stringv. Every position in the file is stored as an
+ * offset from the start of the header, so the image is position independent
+ * and can be mapped at any address. The header is followed by the used blocks
+ * of the stringv (or a single empty block, if there are none) and a NUL, then
+ * (if STRINGV_SAVE_INDEX was given) a table of the block position of each
+ * live string and a table of their lengths. The fields are stored in the byte
+ * order of the machine that wrote them, which byte_order identifies. */
+struct stringv_file_header {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+    uint32_t flags;
+    int32_t block_size;
+    int32_t block_total;
+    int32_t block_used;
+    int32_t string_count;
+    int32_t dead_count;
+    int32_t live_count;
+    int32_t reserved;
+    uint64_t blocks_offset;
+    uint64_t index_offset;
+    uint64_t lengths_offset;
+    uint64_t size;
+};
+
+/* A stringv loaded by stringv_open_mapped. The stringv's buffer lies inside
+ * the mapping, as do the tables, which are NULL if the file has none. Both
+ * tables have stringv.string_count - stringv.dead_count entries: index holds
+ * the block position of each live string, and lengths its length. */
+struct stringv_file {
+    struct stringv stringv;
+    int32_t const *index;
+    int32_t const *lengths;
+    void *map;
+    size_t map_size;
+};
+
+/* Saves a stringv to a file, which is created or truncated. The used blocks
+ * are written as they are, so the file is only as large as the strings need
+ * and can be loaded without parsing. If the function fails, the contents of
+ * the file are unspecified.
+ *
+ *      stringv     The stringv to save.
+ *      path        The path of the file to write.
+ *      flags       Zero or more of the STRINGV_SAVE_ flags, or-ed together.
+ *      RETURNS     1 on success, 0 on failure (with errno set by the failing
+ *                  call).
+ *
+ *      PRE:        stringv != NULL
+ *                  path != NULL
+ *      POST:       stringv unchanged
+ */
+int stringv_save(
+        struct stringv const *STRINGV_RESTRICT stringv,
+        char const *STRINGV_RESTRICT path,
+        int flags);
+
+/* Writes the image of a stringv, in the format of stringv_save, to an open
+ * file descriptor at its current offset. The descriptor may refer to a file,
+ * a POSIX shared memory object or an anonymous memory file (memfd), which can
+ * then be mapped with stringv_map_shared. If the function fails, the contents
+ * written are unspecified.
+ *
+ *      stringv     The stringv to save.
+ *      fd          The descriptor to write to, open for writing.
+ *      flags       As stringv_save.
+ *      RETURNS     As stringv_save.
+ *
+ *      PRE:        stringv != NULL
+ *                  fd >= 0
+ *      POST:       stringv unchanged
+ */
+int stringv_save_fd(struct stringv const *stringv, int fd, int flags);
+
+/* Places the image of a stringv in a new POSIX shared memory object, so that
+ * any number of processes can map one physical copy of it with
+ * stringv_open_shared. The object persists until it is removed with
+ * shm_unlink. If the function fails, no object is left behind.
+ *
+ *      stringv     The stringv to share.
+ *      name        The name of the shared memory object, as for shm_open.
+ *      flags       As stringv_save.
+ *      RETURNS     1 on success, 0 on failure (including when an object with
+ *                  the same name already exists), with errno set.
+ *
+ *      PRE:        stringv != NULL
+ *                  name != NULL
+ *      POST:       stringv unchanged
+ */
+int stringv_share(
+        struct stringv const *STRINGV_RESTRICT stringv,
+        char const *STRINGV_RESTRICT name,
+        int flags);
+
+/* Maps the image of a stringv from an open file descriptor (of a file, a
+ * shared memory object or a memfd) read-only and shared, so every process
+ * mapping the same object uses the same pages. The image is position
+ * independent and may be mapped at a different address in each process.
+ * The stringv must not be modified: its buffer is not writable. The
+ * descriptor may be closed once the function returns. If the function fails,
+ * no external state is modified.
+ *
+ *      file        The mapped image, to be closed with stringv_close_mapped.
+ *      fd          The descriptor to map, open for reading.
+ *      RETURNS     As stringv_open_mapped.
+ *
+ *      PRE:        file != NULL
+ *                  fd >= 0
+ *      POST:       file->stringv is valid for reading until the file is
+ *                  closed
+ */
+struct stringv_file *stringv_map_shared(struct stringv_file *file, int fd);
+
+/* Maps a stringv placed in shared memory by stringv_share, as
+ * stringv_map_shared.
+ *
+ *      file        The mapped image, to be closed with stringv_close_mapped.
+ *      name        The name of the shared memory object.
+ *      RETURNS     As stringv_open_mapped.
+ *
+ *      PRE:        file != NULL
+ *                  name != NULL
+ *      POST:       file->stringv is valid for reading until the file is
+ *                  closed
+ */
+struct stringv_file *stringv_open_shared(
+        struct stringv_file *STRINGV_RESTRICT file,
+        char const *STRINGV_RESTRICT name);
+
+/* Loads a stringv saved by stringv_save by mapping the file into memory. No
+ * strings are read or copied, so the time taken doesn't depend on the size
+ * of the strings; pages are read in as they are first accessed. (If the file
+ * has index and length tables, they are read through once, to check that
+ * each entry locates a string within the used blocks.) The mapping is
+ * private, so the stringv may be modified without changing the file, but it
+ * is full: its block total is its block count. If the function fails, no
+ * external state is modified.
+ *
+ *      file        The loaded file, to be closed with stringv_close_mapped.
+ *      path        The path of the file to load.
+ *      RETURNS     file on success, or NULL on failure (including when the
+ *                  file is not a valid stringv file of this version and byte
+ *                  order).
+ *
+ *      PRE:        file != NULL
+ *                  path != NULL
+ *      POST:       file->stringv is valid until the file is closed
+ */
+struct stringv_file *stringv_open_mapped(
+        struct stringv_file *STRINGV_RESTRICT file,
+        char const *STRINGV_RESTRICT path);
+
+/* Writes the live strings of a stringv to an open file descriptor as text,
+ * each followed by the separator. The strings are written straight from the
+ * buffer, without copying, by gathering batches of them (and the separator)
+ * into a single writev call. If the function fails, an unspecified prefix of
+ * the text has been written.
+ *
+ *      stringv     The stringv to write.
+ *      fd          The descriptor to write to, open for writing.
+ *      separator   The string to write after each string, such as "\n", or
+ *                  NULL for none.
+ *      RETURNS     1 on success, 0 on failure (with errno set by the failing
+ *                  call).
+ *
+ *      PRE:        stringv != NULL
+ *                  fd >= 0
+ *      POST:       stringv unchanged
+ */
+int stringv_write_fd(
+        struct stringv const *STRINGV_RESTRICT stringv,
+        int fd,
+        char const *STRINGV_RESTRICT separator);
+
+/* Appends to a stringv each substring of a file delimited by the separator,
+ * as stringv_split_c would for the whole file, without holding the whole
+ * file in memory. The file is read in fixed chunks by a second thread while
+ * the calling thread splits the previous chunk, so reading and splitting
+ * overlap. The scratch buffer is divided into STRINGV_LOAD_BUFFERS chunks
+ * and a carry area, each of scratch_size / (STRINGV_LOAD_BUFFERS + 1) chars;
+ * a substring that spans chunks is joined in the carry area, so no substring
+ * may be longer than that. If the function fails, the substrings already
+ * appended are kept, as in stringv_split_c.
+ *
+ *      stringv     The stringv to append to.
+ *      path        The path of the file to load.
+ *      separator   The separator character, such as '\n'.
+ *      scratch     The buffer to read the file through.
+ *      scratch_size
+ *                  The size of scratch, in chars.
+ *      RETURNS     1 if the whole file was loaded, 0 otherwise, with errno
+ *                  set: ENOSPC if the stringv is full, EOVERFLOW if a
+ *                  substring is longer than the carry area, EINVAL if a
+ *                  substring contains NUL, or as set by the failing call.
+ *
+ *      PRE:        stringv != NULL
+ *                  path != NULL
+ *                  scratch != NULL
+ *                  scratch_size >= STRINGV_LOAD_BUFFERS + 1
+ *      POST:       The strings previously in stringv are unchanged
+ */
+int stringv_load(
+        struct stringv *STRINGV_RESTRICT stringv,
+        char const *STRINGV_RESTRICT path,
+        int separator,
+        char *STRINGV_RESTRICT scratch,
+        size_t scratch_size);
+
+/* Unmaps a file loaded by stringv_open_mapped, stringv_map_shared or
+ * stringv_open_shared. Pointers into the stringv and the tables become
+ * invalid.
+ *
+ *      file        The file to close.
+ *      RETURNS     1 on success, 0 on failure.
+ *
+ *      PRE:        file != NULL
+ *                  file was loaded by one of the functions above
+ *      POST:       file->stringv is empty and has no buffer
+ */
+int stringv_close_mapped(struct stringv_file *file);
+
+#if defined(__cplusplus)
+}
+#endif /* defined(__cplusplus) */
+
+#endif /* STRINGV_IO_H_ */
@@ -0,0 +1,319 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stringv_shard.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+/* The largest number of threads used by stringv_shard_merge */
+#define MAX_MERGE_THREADS   64
+
+/* Arguments for a merge thread, which copies the blocks of the shards in
+ * [first, last) to dest, starting at the given block position. */
+struct merge_task {
+    struct stringv *dest;
+    struct stringv_shard const *ss;
+    int first;
+    int last;
+    int block_pos;
+};
+
+/* Hashes a string with 32-bit FNV-1a */
+static unsigned hash_string(char const *string, size_t length);
+
+/* Advances an iteration from the start of the given view to the first string
+ * of the first non-empty shard, returning NULL if there is none. */
+static char const *skip_empty_shards(
+        struct stringv_shard const *ss,
+        struct stringv_shard_iter *it,
+        char const *iter);
+
+/* Copies the blocks of a run of shards, as described by a merge_task. */
+static void *merge_shards(void *arg);
+
+struct stringv_shard *stringv_shard_init(
+        struct stringv_shard *ss,
+        union stringv_shard_slot *slots,
+        int shard_count,
+        char *buf,
+        int buf_size,
+        int block_size)
+{
+    int i = 0, blocks = 0, stride = 0;
+
+    if (!ss || !slots || !buf || shard_count <= 0 || block_size <= 1) {
+        return NULL;
+    }
+
+    /* Each slice is followed by a NUL which is never written, so that every
+     * shard's buffer is NUL terminated as stringv_init requires. */
+    blocks = (buf_size / shard_count - 1) / block_size;
+    if (blocks <= 0) {
+        return NULL;
+    }
+
+    stride = blocks * block_size + 1;
+    for (i = 0; i < shard_count; ++i) {
+        buf[i * stride + blocks * block_size] = '\0';
+        if (!stringv_concurrent_init(
+                    &slots[i].cs,
+                    buf + i * stride,
+                    blocks * block_size,
+                    block_size)) {
+            return NULL;
+        }
+    }
+
+    ss->slots = slots;
+    ss->shard_count = shard_count;
+    return ss;
+}
+
+char const *stringv_shard_push_back(
+        struct stringv_shard *ss,
+        int shard,
+        char const *string,
+        size_t length)
+{
+    if (!ss || shard < 0 || shard >= ss->shard_count) {
+        return NULL;
+    }
+
+    return stringv_concurrent_push_back(
+            &ss->slots[shard].cs,
+            string,
+            length);
+}
+
+char const *stringv_shard_push_hashed(
+        struct stringv_shard *ss,
+        char const *string,
+        size_t length)
+{
+    if (!ss || !string) {
+        return NULL;
+    }
+
+    return stringv_shard_push_back(
+            ss,
+            (int)(hash_string(string, length) % (unsigned)ss->shard_count),
+            string,
+            length);
+}
+
+int stringv_shard_count(struct stringv_shard const *ss)
+{
+    struct stringv view;
+    int i = 0, count = 0;
+
+    assert(ss);
+
+    for (i = 0; i < ss->shard_count; ++i) {
+        count += stringv_concurrent_view(&ss->slots[i].cs, &view)
+            ->string_count;
+    }
+
+    return count;
+}
+
+struct stringv_shard_pos *stringv_shard_locate(
+        struct stringv_shard const *ss,
+        string_pos n,
+        struct stringv_shard_pos *pos)
+{
+    struct stringv view;
+    int i = 0;
+
+    if (!ss || !pos || n < 0) {
+        return NULL;
+    }
+
+    for (i = 0; i < ss->shard_count; ++i) {
+        (void)stringv_concurrent_view(&ss->slots[i].cs, &view);
+        if (n < view.string_count) {
+            pos->shard = i;
+            pos->pos = n;
+            return pos;
+        }
+        n -= view.string_count;
+    }
+
+    return NULL;
+}
+
+char const *stringv_shard_get(
+        struct stringv_shard const *ss,
+        struct stringv_shard_pos pos)
+{
+    struct stringv view;
+
+    if (!ss || pos.shard < 0 || pos.shard >= ss->shard_count) {
+        return NULL;
+    }
+
+    return stringv_get(
+            stringv_concurrent_view(&ss->slots[pos.shard].cs, &view),
+            pos.pos);
+}
+
+char const *stringv_shard_begin(
+        struct stringv_shard const *ss,
+        struct stringv_shard_iter *it)
+{
+    if (!ss || !it) {
+        return NULL;
+    }
+
+    it->shard = 0;
+    (void)stringv_concurrent_view(&ss->slots[0].cs, &it->view);
+    return skip_empty_shards(ss, it, stringv_begin(&it->view));
+}
+
+char const *stringv_shard_next(
+        struct stringv_shard const *ss,
+        struct stringv_shard_iter *it,
+        char const *iter)
+{
+    if (!ss || !it || !iter) {
+        return NULL;
+    }
+
+    return skip_empty_shards(ss, it, stringv_next(&it->view, iter));
+}
+
+int stringv_shard_merge(
+        struct stringv *dest,
+        struct stringv_shard const *ss,
+        int threads)
+{
+    struct stringv view;
+    struct merge_task tasks[MAX_MERGE_THREADS];
+    pthread_t ids[MAX_MERGE_THREADS];
+    int started[MAX_MERGE_THREADS] = {0};
+    int i = 0, t = 0, blocks = 0, strings = 0;
+
+    if (!dest || !ss) {
+        return -1;
+    }
+
+    for (i = 0; i < ss->shard_count; ++i) {
+        (void)stringv_concurrent_view(&ss->slots[i].cs, &view);
+        blocks += view.block_used;
+        strings += view.string_count;
+    }
+
+    /* The block size of every shard is the same and never changes. The
+     * threads write dest's buffer directly, so a dest with a snapshot goes
+     * through stringv_append, which preserves the blocks it overwrites. */
+    if (dest->block_size != ss->slots[0].cs.stringv.block_size
+            || dest->block_total - dest->block_used < blocks
+            || dest->snapshot) {
+        for (i = 0, strings = 0; i < ss->shard_count; ++i) {
+            strings += stringv_append(
+                    dest,
+                    stringv_concurrent_view(&ss->slots[i].cs, &view));
+        }
+        return strings;
+    }
+
+    if (threads > MAX_MERGE_THREADS) {
+        threads = MAX_MERGE_THREADS;
+    }
+    if (threads > ss->shard_count) {
+        threads = ss->shard_count;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    /* Give each thread a contiguous run of shards and the block position its
+     * run starts at. The shards aren't written during the merge, so the
+     * threads' own views will agree with the ones taken here. */
+    for (t = 0, blocks = dest->block_used; t < threads; ++t) {
+        tasks[t].dest = dest;
+        tasks[t].ss = ss;
+        tasks[t].first = (int)((long)ss->shard_count * t / threads);
+        tasks[t].last = (int)((long)ss->shard_count * (t + 1) / threads);
+        tasks[t].block_pos = blocks;
+
+        for (i = tasks[t].first; i < tasks[t].last; ++i) {
+            blocks += stringv_concurrent_view(&ss->slots[i].cs, &view)
+                ->block_used;
+        }
+    }
+
+    /* The calling thread takes the first run. A thread that cannot be
+     * started has its run copied by the calling thread instead. */
+    for (t = 1; t < threads; ++t) {
+        started[t] = !pthread_create(&ids[t], NULL, merge_shards, &tasks[t]);
+    }
+    (void)merge_shards(&tasks[0]);
+    for (t = 1; t < threads; ++t) {
+        if (started[t]) {
+            (void)pthread_join(ids[t], NULL);
+        } else {
+            (void)merge_shards(&tasks[t]);
+        }
+    }
+
+    dest->block_used = blocks;
+    dest->string_count += strings;
+    return strings;
+}
+
+unsigned hash_string(char const *string, size_t length)
+{
+    unsigned long hash = 2166136261ul;
+    size_t i = 0;
+
+    assert(string);
+
+    for (i = 0; i < length; ++i) {
+        hash ^= (unsigned char)string[i];
+        hash = (hash * 16777619ul) & 0xFFFFFFFFul;
+    }
+
+    return (unsigned)hash;
+}
+
+char const *skip_empty_shards(
+        struct stringv_shard const *ss,
+        struct stringv_shard_iter *it,
+        char const *iter)
+{
+    assert(ss && it && iter);
+
+    while (iter == stringv_end(&it->view)) {
+        if (++it->shard >= ss->shard_count) {
+            return NULL;
+        }
+
+        (void)stringv_concurrent_view(&ss->slots[it->shard].cs, &it->view);
+        iter = stringv_begin(&it->view);
+    }
+
+    return iter;
+}
+
+void *merge_shards(void *arg)
+{
+    struct merge_task *task = arg;
+    struct stringv view;
+    size_t size = 0;
+    char *write_ptr = NULL;
+    int i = 0;
+
+    assert(task);
+
+    write_ptr = task->dest->buf
+        + (size_t)task->block_pos * (size_t)task->dest->block_size;
+    for (i = task->first; i < task->last; ++i) {
+        (void)stringv_concurrent_view(&task->ss->slots[i].cs, &view);
+        size = (size_t)view.block_used * (size_t)view.block_size;
+        memcpy(write_ptr, view.buf, size);
+        write_ptr += size;
+    }
+
+    return NULL;
+}
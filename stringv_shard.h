@@ -0,0 +1,234 @@
+#ifndef STRINGV_SHARD_H_
+#define STRINGV_SHARD_H_
+
+#include <stddef.h>
+
+#include "stringv.h"
+#include "stringv_concurrent.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/* The assumed size of a cache line, in bytes */
+#ifndef STRINGV_CACHE_LINE
+#   define STRINGV_CACHE_LINE 64
+#endif /* STRINGV_CACHE_LINE */
+
+/* A shard of a sharded stringv, padded to a whole number of cache lines so
+ * that writers to neighbouring shards do not contend for the same line. */
+union stringv_shard_slot {
+    struct stringv_concurrent cs;
+    char pad[(sizeof(struct stringv_concurrent) + STRINGV_CACHE_LINE - 1)
+        / STRINGV_CACHE_LINE * STRINGV_CACHE_LINE];
+}
+#if defined(__GNUC__)
+__attribute__((aligned(STRINGV_CACHE_LINE)))
+#endif /* defined(__GNUC__) */
+;
+
+/* A stringv split into a number of independent shards, each a concurrent
+ * stringv in append-only mode (see stringv_concurrent.h) with its own slice
+ * of the caller's buffer. Spreading writers over the shards spreads the
+ * updates to the block counters, which would otherwise all land on one
+ * cache line. Writers may pick a shard themselves (typically one per thread,
+ * in which case pushes are uncontended) or have strings routed to a shard by
+ * hash.
+ *
+ * Strings are ordered shard by shard: the global position of a string is its
+ * position within its shard plus the number of strings in the shards before
+ * it. Global positions therefore shift as strings are pushed to earlier
+ * shards. */
+struct stringv_shard {
+    union stringv_shard_slot *slots;
+    int shard_count;
+};
+
+/* The location of a string in a sharded stringv */
+struct stringv_shard_pos {
+    int shard;
+    string_pos pos;
+};
+
+/* The state of an iteration over a sharded stringv */
+struct stringv_shard_iter {
+    int shard;
+    struct stringv view;
+};
+
+/* Initialises a sharded stringv. The buffer is split into shard_count equal
+ * slices, each holding a whole number of blocks and separated by a NUL. The
+ * function is not thread safe: the sharded stringv must not be shared until
+ * it returns. If the function fails, no external state is modified.
+ *
+ *      ss          A pointer to an uninitialised sharded stringv.
+ *      slots       The storage for the shards, an array of shard_count slots.
+ *      shard_count The number of shards.
+ *      buf         The storage for the strings. See stringv_init.
+ *      buf_size    The size of buf, in chars, including the terminating
+ *                  character.
+ *      block_size  The desired size of the blocks, in chars.
+ *      RETURNS     ss on success, NULL on failure (including when buf is too
+ *                  small to give each shard a block).
+ *
+ *      PRE:        ss != NULL
+ *                  slots != NULL
+ *                  shard_count > 0
+ *                  The remaining arguments satisfy stringv_init
+ *      POST:       Every shard is empty
+ */
+struct stringv_shard *stringv_shard_init(
+        struct stringv_shard *STRINGV_RESTRICT ss,
+        union stringv_shard_slot *STRINGV_RESTRICT slots,
+        int shard_count,
+        char *STRINGV_RESTRICT buf,
+        int buf_size,
+        int block_size);
+
+/* Appends a string to the given shard of a sharded stringv. May be called
+ * from any number of threads at once. If the function fails, no external
+ * state is modified.
+ *
+ *      ss          The sharded stringv to write to.
+ *      shard       The shard to append to, in [0, ss->shard_count).
+ *      string      The string to append. NUL termination is not required.
+ *      length      The length of the string, in chars.
+ *      RETURNS     A non-writable pointer to the appended string, or NULL if
+ *                  the arguments are invalid or the shard is full.
+ *
+ *      PRE:        ss != NULL
+ *                  0 <= shard < ss->shard_count
+ *                  string != NULL
+ *                  length > 0
+ */
+char const *stringv_shard_push_back(
+        struct stringv_shard *STRINGV_RESTRICT ss,
+        int shard,
+        char const *STRINGV_RESTRICT string,
+        size_t length);
+
+/* Appends a string to the shard selected by a hash of its contents, so equal
+ * strings always land in the same shard. May be called from any number of
+ * threads at once. If the function fails, no external state is modified.
+ *
+ *      ss          The sharded stringv to write to.
+ *      string      The string to append. NUL termination is not required.
+ *      length      The length of the string, in chars.
+ *      RETURNS     As stringv_shard_push_back.
+ *
+ *      PRE:        ss != NULL
+ *                  string != NULL
+ *                  length > 0
+ */
+char const *stringv_shard_push_hashed(
+        struct stringv_shard *STRINGV_RESTRICT ss,
+        char const *STRINGV_RESTRICT string,
+        size_t length);
+
+/* Returns the number of strings published in a sharded stringv.
+ *
+ *      ss          The sharded stringv.
+ *      RETURNS     The total number of strings in every shard.
+ *
+ *      PRE:        ss != NULL
+ *      POST:       ss unchanged
+ */
+int stringv_shard_count(struct stringv_shard const *ss);
+
+/* Converts a global position in a sharded stringv to a shard and a position
+ * within that shard.
+ *
+ *      ss          The sharded stringv.
+ *      n           The global position of the string.
+ *      pos         Receives the shard and local position.
+ *      RETURNS     pos, or NULL if n is out of range or an argument is NULL.
+ *
+ *      PRE:        ss != NULL
+ *                  pos != NULL
+ *                  0 <= n < stringv_shard_count(ss)
+ *      POST:       ss unchanged
+ */
+struct stringv_shard_pos *stringv_shard_locate(
+        struct stringv_shard const *STRINGV_RESTRICT ss,
+        string_pos n,
+        struct stringv_shard_pos *STRINGV_RESTRICT pos);
+
+/* Gets the string at the given shard and local position. The pointer remains
+ * valid for as long as the buffer does, since shards are append-only.
+ *
+ *      ss          The sharded stringv.
+ *      pos         The location of the string.
+ *      RETURNS     A non-writable pointer to the string, or NULL if pos is
+ *                  out of range.
+ *
+ *      PRE:        ss != NULL
+ *      POST:       ss unchanged
+ */
+char const *stringv_shard_get(
+        struct stringv_shard const *ss,
+        struct stringv_shard_pos pos);
+
+/* Begins an iteration over every string of a sharded stringv, in global
+ * order. Each shard is viewed as the iteration reaches it, so the iteration
+ * sees strings pushed to a shard before it was reached.
+ *
+ *      ss          The sharded stringv.
+ *      it          The iteration state.
+ *      RETURNS     The first string, or NULL if there are none.
+ *
+ *      PRE:        ss != NULL
+ *                  it != NULL
+ *      POST:       ss unchanged
+ */
+char const *stringv_shard_begin(
+        struct stringv_shard const *STRINGV_RESTRICT ss,
+        struct stringv_shard_iter *STRINGV_RESTRICT it);
+
+/* Advances an iteration over a sharded stringv.
+ *
+ *      ss          The sharded stringv.
+ *      it          The iteration state, as left by the previous call.
+ *      iter        The string returned by the previous call.
+ *      RETURNS     The next string, or NULL if there are no more.
+ *
+ *      PRE:        ss != NULL
+ *                  it != NULL
+ *                  iter was returned by the previous call with it
+ *      POST:       ss unchanged
+ */
+char const *stringv_shard_next(
+        struct stringv_shard const *STRINGV_RESTRICT ss,
+        struct stringv_shard_iter *STRINGV_RESTRICT it,
+        char const *iter);
+
+/* Appends the strings of every shard, in global order, to a flat stringv, as
+ * many as will fit. When the block sizes match and there is room for every
+ * shard, and dest has no active snapshot, the shards are copied blockwise by
+ * the given number of threads, each copying a contiguous run of shards to its
+ * precomputed offset in dest; otherwise the shards are appended one at a time
+ * with stringv_append. The
+ * shards must not be written to during the merge.
+ *
+ *      dest        The stringv to append to.
+ *      ss          The sharded stringv to read from.
+ *      threads     The largest number of threads to copy with. Values less
+ *                  than 2 copy on the calling thread.
+ *      RETURNS     The number of strings appended, or -1 if either
+ *                  argument is NULL. A thread that cannot be started has its
+ *                  shards copied by the calling thread instead.
+ *
+ *      PRE:        dest != NULL
+ *                  ss != NULL
+ *      POST:       ss unchanged
+ *                  Strings previously stored in dest are unchanged
+ */
+int stringv_shard_merge(
+        struct stringv *STRINGV_RESTRICT dest,
+        struct stringv_shard const *STRINGV_RESTRICT ss,
+        int threads);
+
+#if defined(__cplusplus)
+}
+#endif /* defined(__cplusplus) */
+
+#endif /* STRINGV_SHARD_H_ */
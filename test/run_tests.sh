@@ -3,7 +3,12 @@
 # The tests to run
 TESTS=(test_init test_clear test_copy test_push_back \
     test_push_front test_get test_insert test_remove \
-    test_iteration test_split_c test_split_s)
+    test_iteration test_split_c test_split_s test_tombstone \
+    test_replace test_swap test_rotate test_reverse \
+    test_stable_partition test_append test_concurrent test_shard \
+    test_snapshot test_save test_shared \
+    test_write_fd test_join test_column test_load test_analyze \
+    test_reblock test_fixed test_counters test_trace)
 
 # The number of succeeded tests
 SUCCEEDED=0
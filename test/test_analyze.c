@@ -0,0 +1,186 @@
+#include <assert.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+/* Sets the candidate block sizes of an array of three analyses */
+static void set_candidates(
+        struct stringv_block_analysis *analyses,
+        int a,
+        int b,
+        int c);
+
+static int test_analyze_params_bad(void);
+static int test_analyze_exact_fit(void);
+static int test_analyze_multi_block(void);
+static int test_analyze_weights(void);
+static int test_analyze_zero_lengths(void);
+static int test_analyze_stringv(void);
+static int test_analyze_tombstones(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_analyze_params_bad),
+    TEST_CASE(test_analyze_exact_fit),
+    TEST_CASE(test_analyze_multi_block),
+    TEST_CASE(test_analyze_weights),
+    TEST_CASE(test_analyze_zero_lengths),
+    TEST_CASE(test_analyze_stringv),
+    TEST_CASE(test_analyze_tombstones)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+void set_candidates(
+        struct stringv_block_analysis *analyses,
+        int a,
+        int b,
+        int c)
+{
+    analyses[0].block_size = a;
+    analyses[1].block_size = b;
+    analyses[2].block_size = c;
+}
+
+int test_analyze_params_bad(void)
+{
+    struct stringv_block_analysis a[3];
+    size_t const lengths[] = {3, 3};
+
+    set_candidates(a, 2, 4, 8);
+    if (stringv_analyze(NULL, 2, 1., 1., a, 3)
+            || stringv_analyze(lengths, 0, 1., 1., a, 3)
+            || stringv_analyze(lengths, 2, -1., 1., a, 3)
+            || stringv_analyze(lengths, 2, 1., -1., a, 3)
+            || stringv_analyze(lengths, 2, 1., 1., NULL, 3)
+            || stringv_analyze(lengths, 2, 1., 1., a, 0)
+            || stringv_analyze_stringv(NULL, 1., 1., a, 3)) {
+        return 0;
+    }
+
+    set_candidates(a, 2, 1, 8);
+    return !stringv_analyze(lengths, 2, 1., 1., a, 3);
+}
+
+/* Strings that exactly fill a block are best stored in blocks of that size,
+ * once lookup cost carries any weight */
+int test_analyze_exact_fit(void)
+{
+    struct stringv_block_analysis a[3];
+    size_t const lengths[] = {3, 3, 3, 3};
+
+    set_candidates(a, 2, 4, 8);
+    if (stringv_analyze(lengths, 4, 1., .01, a, 3) != 4
+            || stringv_analyze(lengths, 4, 0., 1., a, 3) != 4
+            || stringv_analyze(lengths, 4, 1., 1., a, 3) != 4) {
+        return 0;
+    }
+
+    return a[1].block_count == 4
+        && a[1].padding == 0.
+        && a[1].multi_block == 0.
+        && a[1].lookup_cost == 1.
+        && a[2].block_count == 4
+        && a[2].padding == .5
+        && a[2].lookup_cost == 1.;
+}
+
+/* Strings spanning blocks make lookups walk the blocks before them */
+int test_analyze_multi_block(void)
+{
+    struct stringv_block_analysis a[3];
+    size_t const lengths[] = {3, 3, 3, 3};
+
+    set_candidates(a, 2, 4, 8);
+    assert(stringv_analyze(lengths, 4, 1., 1., a, 3) == 4);
+
+    /* Each string takes two blocks, so the strings start at blocks 0, 2, 4
+     * and 6, and a lookup visits 1 + 3 blocks on average */
+    return a[0].block_count == 8
+        && a[0].padding == 0.
+        && a[0].multi_block == 1.
+        && a[0].lookup_cost == 4.;
+}
+
+/* The weights trade padding against lookup cost */
+int test_analyze_weights(void)
+{
+    struct stringv_block_analysis a[3];
+    size_t const lengths[] = {1, 1, 1, 1, 9};
+
+    set_candidates(a, 2, 4, 16);
+    return stringv_analyze(lengths, 5, 1., 0., a, 3) == 2
+        && stringv_analyze(lengths, 5, 0., 1., a, 3) == 16
+        && a[2].lookup_cost == 1.
+        && a[0].lookup_cost == 3.;
+}
+
+int test_analyze_zero_lengths(void)
+{
+    struct stringv_block_analysis a[3];
+    size_t const lengths[] = {0, 3, 0, 3};
+    size_t const empty[] = {0, 0};
+
+    set_candidates(a, 2, 4, 8);
+    return stringv_analyze(empty, 2, 1., 1., a, 3) == 0
+        && stringv_analyze(lengths, 4, 1., 1., a, 3) == 4
+        && a[1].block_count == 2
+        && a[0].lookup_cost == 2.;
+}
+
+/* Analysing a stringv gives the same results as analysing the lengths of its
+ * strings, whatever its own block size */
+int test_analyze_stringv(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_block_analysis a[3], b[3];
+    size_t const lengths[] = {1, 1, 1, 1, 9};
+    char buf[64] = {0};
+    int i = 0;
+
+    assert(stringv_init(&s, buf, 64, 8));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_push_back(&s, "C", 1));
+    assert(stringv_push_back(&s, "D", 1));
+    assert(stringv_push_back(&s, "EEEEEEEEE", 9));
+
+    set_candidates(a, 2, 4, 16);
+    set_candidates(b, 2, 4, 16);
+    if (stringv_analyze_stringv(&s, 1., 1., a, 3)
+            != stringv_analyze(lengths, 5, 1., 1., b, 3)) {
+        return 0;
+    }
+
+    for (i = 0; i < 3; ++i) {
+        if (a[i].block_count != b[i].block_count
+                || a[i].padding != b[i].padding
+                || a[i].multi_block != b[i].multi_block
+                || a[i].lookup_cost != b[i].lookup_cost
+                || a[i].score != b[i].score) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int test_analyze_tombstones(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_block_analysis a[3];
+    char buf[64] = {0};
+
+    assert(stringv_init(&s, buf, 64, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBBBBBBBBBBB", 12));
+    assert(stringv_push_back(&s, "CCC", 3));
+    assert(stringv_tombstone(&s, 1));
+
+    set_candidates(a, 2, 4, 8);
+    return stringv_analyze_stringv(&s, 1., 1., a, 3) == 4
+        && a[1].block_count == 2
+        && a[1].lookup_cost == 1.;
+}
@@ -0,0 +1,143 @@
+#include <assert.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+static int test_append_params_bad(void);
+static int test_append_empty(void);
+static int test_append_blockwise(void);
+static int test_append_wider(void);
+static int test_append_stringwise(void);
+static int test_append_partial(void);
+static int test_append_tombstones(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_append_params_bad),
+    TEST_CASE(test_append_empty),
+    TEST_CASE(test_append_blockwise),
+    TEST_CASE(test_append_wider),
+    TEST_CASE(test_append_stringwise),
+    TEST_CASE(test_append_partial),
+    TEST_CASE(test_append_tombstones)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int test_append_params_bad(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char b1[12] = {0}, b2[12] = {0};
+
+    assert(stringv_init(&s1, b1, 12, 4));
+    assert(stringv_init(&s2, b2, 12, 4));
+
+    return !stringv_append(NULL, &s2)
+        && !stringv_append(&s1, NULL);
+}
+
+int test_append_empty(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char b1[12] = {0}, b2[12] = {0};
+
+    assert(stringv_init(&s1, b1, 12, 4));
+    assert(stringv_init(&s2, b2, 12, 4));
+    assert(stringv_push_back(&s1, "AAA", 3));
+
+    return stringv_append(&s1, &s2) == 0
+        && s1.string_count == 1
+        && s1.block_used == 1;
+}
+
+/* Matching block sizes append the source blocks verbatim, multi-block
+ * strings included */
+int test_append_blockwise(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char b1[24] = {0}, b2[16] = {0};
+
+    assert(stringv_init(&s1, b1, 24, 4));
+    assert(stringv_init(&s2, b2, 16, 4));
+    assert(stringv_push_back(&s1, "AAA", 3));
+    assert(stringv_push_back(&s2, "BBB", 3));
+    assert(stringv_push_back(&s2, "CCCCCC", 6));
+
+    return stringv_append(&s1, &s2) == 2
+        && s1.string_count == 3
+        && s1.block_used == 4
+        && memcmp(b1, "AAA\0BBB\0CCCCCC\0\0\0\0\0\0\0\0\0", 24) == 0;
+}
+
+int test_append_wider(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char b1[18] = {0}, b2[9] = {0};
+
+    assert(stringv_init(&s1, b1, 18, 6));
+    assert(stringv_init(&s2, b2, 9, 3));
+    assert(stringv_push_back(&s1, "AAAAA", 5));
+    assert(stringv_push_back(&s2, "BB", 2));
+    assert(stringv_push_back(&s2, "C", 1));
+
+    return stringv_append(&s1, &s2) == 2
+        && s1.string_count == 3
+        && s1.block_used == 3
+        && memcmp(b1, "AAAAA\0BB\0\0\0\0C\0\0\0\0\0", 18) == 0;
+}
+
+int test_append_stringwise(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char b1[16] = {0}, b2[12] = {0};
+
+    assert(stringv_init(&s1, b1, 16, 8));
+    assert(stringv_init(&s2, b2, 12, 3));
+    assert(stringv_push_back(&s2, "BBBBB", 5));
+    assert(stringv_push_back(&s2, "C", 1));
+
+    return stringv_append(&s1, &s2) == 2
+        && s1.block_used == 2
+        && strcmp(stringv_get(&s1, 0), "BBBBB") == 0
+        && strcmp(stringv_get(&s1, 1), "C") == 0;
+}
+
+/* Only the strings that fit are appended */
+int test_append_partial(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char b1[12] = {0}, b2[12] = {0};
+
+    assert(stringv_init(&s1, b1, 12, 4));
+    assert(stringv_init(&s2, b2, 12, 4));
+    assert(stringv_push_back(&s1, "AAA", 3));
+    assert(stringv_push_back(&s2, "BBB", 3));
+    assert(stringv_push_back(&s2, "CCC", 3));
+    assert(stringv_push_back(&s2, "DDD", 3));
+
+    return stringv_append(&s1, &s2) == 2
+        && s1.string_count == 3
+        && s1.block_used == 3
+        && strcmp(stringv_get(&s1, 2), "CCC") == 0;
+}
+
+int test_append_tombstones(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char b1[24] = {0}, b2[24] = {0};
+
+    assert(stringv_init(&s1, b1, 24, 4));
+    assert(stringv_init(&s2, b2, 24, 4));
+    assert(stringv_push_back(&s2, "AAA", 3));
+    assert(stringv_push_back(&s2, "BBB", 3));
+    assert(stringv_push_back(&s2, "CCC", 3));
+    assert(stringv_tombstone(&s2, 0));
+
+    return stringv_append(&s1, &s2) == 2
+        && s1.dead_count == 1
+        && strcmp(stringv_get(&s1, 0), "BBB") == 0
+        && strcmp(stringv_get(&s1, 1), "CCC") == 0;
+}
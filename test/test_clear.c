@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "test.h"
@@ -6,10 +7,12 @@
 
 static int test_clear_consistent(void);
 static int test_clear_zero_buf(void);
+static int test_clear_zero_buf_large(void);
 
 static const test_case tests[] = {
     TEST_CASE(test_clear_consistent),
-    TEST_CASE(test_clear_zero_buf)
+    TEST_CASE(test_clear_zero_buf),
+    TEST_CASE(test_clear_zero_buf_large)
 };
 
 int main(void)
@@ -74,3 +77,33 @@ int test_clear_zero_buf(void)
     return 1;
 }
 
+/* Checks that stringv_clear zeroes a buffer large enough to take the
+ * streaming store path. The buffer is deliberately misaligned and its size is
+ * not a multiple of the store width so that the head and tail are exercised
+ * too. */
+int test_clear_zero_buf_large(void)
+{
+    struct stringv sv = STRINGV_ZERO;
+    int const size = 9 * 1024 * 1024 + 7;
+    char *buf = NULL;
+    int i, result = 1;
+
+    buf = malloc((size_t)size + 1);
+    assert(buf);
+
+    assert(stringv_init(&sv, buf + 1, size, 5));
+    memset(sv.buf, 'x', (size_t)size);
+
+    (void)stringv_clear(&sv);
+
+    /* Only the blocks are cleared, not the trailing partial block */
+    for (i = 0; i < sv.block_total * sv.block_size; ++i) {
+        if (sv.buf[i]) {
+            result = 0;
+            break;
+        }
+    }
+
+    free(buf);
+    return result;
+}
@@ -0,0 +1,316 @@
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+static int test_column_params_bad(void);
+static int test_column_export(void);
+static int test_column_export_batches(void);
+static int test_column_export_multi_block(void);
+static int test_column_export_tombstones(void);
+static int test_column_export_too_large(void);
+static int test_column_export64(void);
+static int test_column_import(void);
+static int test_column_import_slice(void);
+static int test_column_import_multi_block(void);
+static int test_column_import_invalid(void);
+static int test_column_import64(void);
+static int test_column_roundtrip(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_column_params_bad),
+    TEST_CASE(test_column_export),
+    TEST_CASE(test_column_export_batches),
+    TEST_CASE(test_column_export_multi_block),
+    TEST_CASE(test_column_export_tombstones),
+    TEST_CASE(test_column_export_too_large),
+    TEST_CASE(test_column_export64),
+    TEST_CASE(test_column_import),
+    TEST_CASE(test_column_import_slice),
+    TEST_CASE(test_column_import_multi_block),
+    TEST_CASE(test_column_import_invalid),
+    TEST_CASE(test_column_import64),
+    TEST_CASE(test_column_roundtrip)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int test_column_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_column_cursor cursor;
+    int32_t offsets[4] = {0, 1, 2, 3};
+    char b[16] = {0};
+    char data[16] = {0};
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_column_begin(&cursor, &s));
+
+    return !stringv_column_begin(NULL, &s)
+        && !stringv_column_begin(&cursor, NULL)
+        && stringv_column_export(NULL, offsets, data, 3, 16) == -1
+        && stringv_column_export(&cursor, NULL, data, 3, 16) == -1
+        && stringv_column_export(&cursor, offsets, NULL, 3, 16) == -1
+        && stringv_column_export(&cursor, offsets, data, 0, 16) == -1
+        && stringv_column_import(NULL, offsets, "ABC", 3) == -1
+        && stringv_column_import(&s, NULL, "ABC", 3) == -1
+        && stringv_column_import(&s, offsets, NULL, 3) == -1
+        && stringv_column_import(&s, offsets, "ABC", -1) == -1;
+}
+
+int test_column_export(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_column_cursor cursor;
+    int32_t offsets[4];
+    char b[32] = {0};
+    char data[16];
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CC", 2));
+    assert(stringv_column_begin(&cursor, &s));
+
+    return stringv_column_export(&cursor, offsets, data, 3, 16) == 3
+        && offsets[0] == 0
+        && offsets[1] == 1
+        && offsets[2] == 4
+        && offsets[3] == 6
+        && memcmp(data, "ABBBCC", 6) == 0
+        && stringv_column_export(&cursor, offsets, data, 3, 16) == 0;
+}
+
+/* Each batch stops when either buffer is full, and starts its offsets at 0 */
+int test_column_export_batches(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_column_cursor cursor;
+    int32_t offsets[3];
+    char b[32] = {0};
+    char data[3];
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_push_back(&s, "CCC", 3));
+    assert(stringv_push_back(&s, "D", 1));
+    assert(stringv_column_begin(&cursor, &s));
+
+    if (stringv_column_export(&cursor, offsets, data, 2, 3) != 2
+            || offsets[2] != 2
+            || memcmp(data, "AB", 2) != 0) {
+        return 0;
+    }
+
+    if (stringv_column_export(&cursor, offsets, data, 2, 3) != 1
+            || offsets[0] != 0
+            || offsets[1] != 3
+            || memcmp(data, "CCC", 3) != 0) {
+        return 0;
+    }
+
+    return stringv_column_export(&cursor, offsets, data, 2, 3) == 1
+        && offsets[1] == 1
+        && data[0] == 'D'
+        && stringv_column_export(&cursor, offsets, data, 2, 3) == 0;
+}
+
+int test_column_export_multi_block(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_column_cursor cursor;
+    int32_t offsets[3];
+    char b[32] = {0};
+    char data[16];
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "AAAAAAA", 7));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_column_begin(&cursor, &s));
+
+    return stringv_column_export(&cursor, offsets, data, 2, 16) == 2
+        && offsets[1] == 7
+        && offsets[2] == 8
+        && memcmp(data, "AAAAAAAB", 8) == 0;
+}
+
+int test_column_export_tombstones(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_column_cursor cursor;
+    int32_t offsets[4];
+    char b[32] = {0};
+    char data[16];
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_push_back(&s, "C", 1));
+    assert(stringv_tombstone(&s, 1));
+    assert(stringv_column_begin(&cursor, &s));
+
+    return stringv_column_export(&cursor, offsets, data, 3, 16) == 2
+        && offsets[2] == 2
+        && memcmp(data, "AC", 2) == 0;
+}
+
+/* A string larger than the whole data buffer can't be exported */
+int test_column_export_too_large(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_column_cursor cursor;
+    int32_t offsets[2];
+    char b[32] = {0};
+    char data[4];
+
+    assert(stringv_init(&s, b, 32, 8));
+    assert(stringv_push_back(&s, "AAAAA", 5));
+    assert(stringv_column_begin(&cursor, &s));
+
+    return stringv_column_export(&cursor, offsets, data, 1, 4) == -1
+        && stringv_column_export(&cursor, offsets, data, 1, 4) == -1;
+}
+
+int test_column_export64(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_column_cursor cursor;
+    int64_t offsets[3];
+    char b[32] = {0};
+    char data[16];
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "AA", 2));
+    assert(stringv_push_back(&s, "BBBBB", 5));
+    assert(stringv_column_begin(&cursor, &s));
+
+    return stringv_column_export64(&cursor, offsets, data, 2, 16) == 2
+        && offsets[0] == 0
+        && offsets[1] == 2
+        && offsets[2] == 7
+        && memcmp(data, "AABBBBB", 7) == 0;
+}
+
+int test_column_import(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    int32_t const offsets[] = {0, 1, 4, 6};
+    char b[32] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "Z", 1));
+
+    return stringv_column_import(&s, offsets, "ABBBCC", 3) == 3
+        && s.string_count == 4
+        && s.block_used == 4
+        && strcmp(stringv_get(&s, 0), "Z") == 0
+        && strcmp(stringv_get(&s, 1), "A") == 0
+        && strcmp(stringv_get(&s, 2), "BBB") == 0
+        && strcmp(stringv_get(&s, 3), "CC") == 0
+        && memcmp(b + 4, "A\0\0\0BBB\0CC\0\0", 12) == 0;
+}
+
+/* The column may be a slice of a larger one, and strings may span vectors
+ * and run up to the end of the data */
+int test_column_import_slice(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    int32_t const offsets[] = {3, 5, 25};
+    char const data[] = "XXXAB0123456789ABCDEFGHIJ";
+    char b[97] = {0};
+
+    assert(stringv_init(&s, b, 97, 32));
+
+    return stringv_column_import(&s, offsets, data, 2) == 2
+        && strcmp(stringv_get(&s, 0), "AB") == 0
+        && strcmp(stringv_get(&s, 1), "0123456789ABCDEFGHIJ") == 0
+        && b[2] == '\0'
+        && b[31] == '\0'
+        && b[32 + 20] == '\0';
+}
+
+int test_column_import_multi_block(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    int32_t const offsets[] = {0, 9, 10};
+    char b[32] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+
+    return stringv_column_import(&s, offsets, "AAAAAAAAAB", 2) == 2
+        && s.block_used == 4
+        && strcmp(stringv_get(&s, 0), "AAAAAAAAA") == 0
+        && strcmp(stringv_get(&s, 1), "B") == 0;
+}
+
+/* Invalid columns, or columns that don't fit, import nothing. A string with
+ * a NUL in it would be stored shorter than the column says (or as a
+ * tombstone), so that makes a column invalid too. */
+int test_column_import_invalid(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    int32_t const decreasing[] = {0, 2, 1};
+    int32_t const empty[] = {0, 1, 1, 2};
+    int32_t const pairs[] = {0, 2, 4};
+    int32_t const too_many[] = {0, 1, 2, 3, 4};
+    char b[13] = {0};
+
+    assert(stringv_init(&s, b, 13, 4));
+
+    return stringv_column_import(&s, decreasing, "AB", 2) == -1
+        && stringv_column_import(&s, empty, "AB", 3) == -1
+        && stringv_column_import(&s, pairs, "ABC\0", 2) == -1
+        && stringv_column_import(&s, pairs, "AB\0C", 2) == -1
+        && stringv_column_import(&s, too_many, "ABCD", 4) == -1
+        && s.string_count == 0
+        && s.block_used == 0
+        && stringv_column_import(&s, too_many, "ABCD", 3) == 3;
+}
+
+int test_column_import64(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    int64_t const offsets[] = {0, 2, 7};
+    char b[32] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+
+    return stringv_column_import64(&s, offsets, "AABBBBB", 2) == 2
+        && strcmp(stringv_get(&s, 0), "AA") == 0
+        && strcmp(stringv_get(&s, 1), "BBBBB") == 0;
+}
+
+int test_column_roundtrip(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    struct stringv_column_cursor cursor;
+    int32_t offsets[9];
+    char b1[257] = {0}, b2[257] = {0};
+    char data[128];
+    char string[24];
+    int i = 0, count = 0;
+
+    assert(stringv_init(&s1, b1, 257, 32));
+    assert(stringv_init(&s2, b2, 257, 32));
+
+    for (i = 0; i < 8; ++i) {
+        memset(string, 'a' + i, sizeof(string));
+        assert(stringv_push_back(&s1, string, (size_t)(3 * i + 1)));
+    }
+
+    assert(stringv_column_begin(&cursor, &s1));
+    while ((count = stringv_column_export(&cursor, offsets, data, 8, 128))
+            > 0) {
+        assert(stringv_column_import(&s2, offsets, data, count) == count);
+    }
+
+    return count == 0
+        && s2.string_count == 8
+        && memcmp(b1, b2, sizeof(b1)) == 0;
+}
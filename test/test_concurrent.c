@@ -0,0 +1,472 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv_concurrent.h"
+
+#define WRITERS             4
+#define STRINGS_PER_WRITER  500
+#define READERS             3
+#define MUTATIONS           2000
+#define MUTATED_STRINGS     64
+
+/* Arguments for a writer thread */
+struct writer {
+    struct stringv_concurrent *cs;
+    int id;
+    int failed;
+};
+
+/* Arguments for a reader thread */
+struct reader {
+    struct stringv_concurrent *cs;
+    char *buf;
+    int failed;
+};
+
+static void *write_strings(void *arg);
+static void *read_views(void *arg);
+static void *mutate_strings(void *arg);
+static void *read_copies(void *arg);
+static int parse_string(char const *string, int *id, int *n);
+static int make_uniform(char *string, int length);
+static int is_uniform(char const *string, size_t length);
+
+static int test_concurrent_params_bad(void);
+static int test_concurrent_single_thread(void);
+static int test_concurrent_full(void);
+static int test_concurrent_many_writers(void);
+static int test_concurrent_get(void);
+static int test_concurrent_read(void);
+static int test_concurrent_read_too_small(void);
+static int test_concurrent_write_append(void);
+static int test_concurrent_single_writer(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_concurrent_params_bad),
+    TEST_CASE(test_concurrent_single_thread),
+    TEST_CASE(test_concurrent_full),
+    TEST_CASE(test_concurrent_many_writers),
+    TEST_CASE(test_concurrent_get),
+    TEST_CASE(test_concurrent_read),
+    TEST_CASE(test_concurrent_read_too_small),
+    TEST_CASE(test_concurrent_write_append),
+    TEST_CASE(test_concurrent_single_writer)
+};
+
+static char many_buf[WRITERS * STRINGS_PER_WRITER * 16];
+static char mutated_buf[MUTATED_STRINGS * 64];
+static char copy_bufs[READERS][sizeof(mutated_buf)];
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+/* Pushes strings of the form "<id>:<n>", padding every third string so that
+ * some strings span several blocks */
+void *write_strings(void *arg)
+{
+    struct writer *w = arg;
+    char string[32];
+    int i = 0, length = 0;
+
+    for (i = 0; i < STRINGS_PER_WRITER; ++i) {
+        length = sprintf(string, i % 3 ? "%d:%d" : "%d:%d......", w->id, i);
+        if (!stringv_concurrent_push_back(w->cs, string, (size_t)length)) {
+            w->failed = 1;
+        }
+    }
+
+    return NULL;
+}
+
+/* Repeatedly takes views while the writers are running, checking that every
+ * visible string is completely written */
+void *read_views(void *arg)
+{
+    struct reader *r = arg;
+    struct stringv view;
+    char const *it = NULL;
+    int i = 0, count = 0, id = 0, n = 0;
+
+    do {
+        assert(stringv_concurrent_view(r->cs, &view));
+
+        for (count = 0, it = stringv_begin(&view);
+                it != stringv_end(&view);
+                ++count, it = stringv_next(&view, it)) {
+            if (!parse_string(it, &id, &n)) {
+                r->failed = 1;
+            }
+        }
+
+        if (count != view.string_count) {
+            r->failed = 1;
+        }
+    } while (++i < 1000 && view.string_count < WRITERS * STRINGS_PER_WRITER);
+
+    return NULL;
+}
+
+/* Replaces, inserts and removes strings in single-writer mode, keeping every
+ * string uniform */
+void *mutate_strings(void *arg)
+{
+    struct writer *w = arg;
+    char string[32];
+    int i = 0, n = 0, length = 0;
+
+    for (i = 0; i < MUTATIONS; ++i) {
+        n = (i * 7) % MUTATED_STRINGS;
+        length = make_uniform(string, 1 + (i * 13) % 30);
+
+        stringv_concurrent_write_begin(w->cs);
+        if (i % 4 == 3) {
+            /* Keep the string count fixed, so readers can pick any position
+             * below MUTATED_STRINGS - 1 */
+            if (!stringv_insert(&w->cs->stringv, string, (size_t)length, n)
+                    || !stringv_remove(&w->cs->stringv, n + 1)) {
+                w->failed = 1;
+            }
+        } else if (!stringv_replace(
+                    &w->cs->stringv, n, string, (size_t)length)) {
+            w->failed = 1;
+        }
+        stringv_concurrent_write_end(w->cs);
+    }
+
+    return NULL;
+}
+
+/* Reads strings while mutate_strings is running, checking that every copy is
+ * a uniform string */
+void *read_copies(void *arg)
+{
+    struct reader *r = arg;
+    struct stringv copy;
+    char string[32];
+    char const *it = NULL;
+    size_t length = 0;
+    int i = 0, count = 0;
+
+    assert(stringv_init(&copy, r->buf, (int)sizeof(mutated_buf), 8));
+
+    for (i = 0; i < MUTATIONS; ++i) {
+        length = stringv_concurrent_get(
+                r->cs, i % (MUTATED_STRINGS - 1), string, sizeof(string));
+        if (length == 0 || !is_uniform(string, length)) {
+            r->failed = 1;
+        }
+
+        if (i % 64 == 0) {
+            if (stringv_concurrent_read(r->cs, &copy) != MUTATED_STRINGS) {
+                r->failed = 1;
+            }
+
+            for (count = 0, it = stringv_begin(&copy);
+                    it != stringv_end(&copy);
+                    ++count, it = stringv_next(&copy, it)) {
+                if (!is_uniform(it, strlen(it))) {
+                    r->failed = 1;
+                }
+            }
+
+            r->failed = r->failed || count != MUTATED_STRINGS;
+        }
+    }
+
+    return NULL;
+}
+
+/* Parses a string written by write_strings, returning 0 if it is malformed */
+int parse_string(char const *string, int *id, int *n)
+{
+    char tail[16] = {0};
+    int fields = sscanf(string, "%d:%d%15s", id, n, tail);
+
+    if (fields < 2 || *id < 0 || *id >= WRITERS
+            || *n < 0 || *n >= STRINGS_PER_WRITER) {
+        return 0;
+    }
+
+    return *n % 3 ? fields == 2 : strcmp(tail, "......") == 0;
+}
+
+/* Writes a string of the given length whose chars are all determined by the
+ * length, returning the length */
+int make_uniform(char *string, int length)
+{
+    memset(string, 'a' + length % 26, (size_t)length);
+    string[length] = '\0';
+    return length;
+}
+
+/* Checks that a string was written by make_uniform */
+int is_uniform(char const *string, size_t length)
+{
+    size_t i = 0;
+
+    for (i = 0; i < length; ++i) {
+        if (string[i] != 'a' + (int)(length % 26)) {
+            return 0;
+        }
+    }
+
+    return string[length] == '\0';
+}
+
+int test_concurrent_params_bad(void)
+{
+    struct stringv_concurrent cs;
+    struct stringv view;
+    char b[16] = {0};
+
+    assert(stringv_concurrent_init(&cs, b, 16, 4));
+
+    return !stringv_concurrent_init(NULL, b, 16, 4)
+        && !stringv_concurrent_init(&cs, b, 16, 1)
+        && !stringv_concurrent_push_back(NULL, "A", 1)
+        && !stringv_concurrent_push_back(&cs, NULL, 1)
+        && !stringv_concurrent_push_back(&cs, "A", 0)
+        && !stringv_concurrent_view(NULL, &view)
+        && !stringv_concurrent_view(&cs, NULL);
+}
+
+int test_concurrent_single_thread(void)
+{
+    struct stringv_concurrent cs;
+    struct stringv view;
+    char b[16] = {0};
+    char const *p = NULL;
+
+    assert(stringv_concurrent_init(&cs, b, 16, 4));
+    assert(stringv_concurrent_push_back(&cs, "AAA", 3));
+    p = stringv_concurrent_push_back(&cs, "BBBBB", 5);
+
+    return p == b + 4
+        && stringv_concurrent_view(&cs, &view) == &view
+        && view.string_count == 2
+        && view.block_used == 3
+        && strcmp(stringv_get(&view, 0), "AAA") == 0
+        && stringv_get(&view, 1) == p;
+}
+
+/* A failed reservation leaves the published state unchanged */
+int test_concurrent_full(void)
+{
+    struct stringv_concurrent cs;
+    struct stringv view;
+    char b[12] = {0};
+
+    assert(stringv_concurrent_init(&cs, b, 12, 4));
+    assert(stringv_concurrent_push_back(&cs, "AAAAAA", 6));
+
+    return !stringv_concurrent_push_back(&cs, "BBBBBB", 6)
+        && !stringv_concurrent_push_back(&cs, "CCCCCCCCCCCCCCCC", 16)
+        && stringv_concurrent_push_back(&cs, "DDD", 3)
+        && stringv_concurrent_view(&cs, &view)
+        && view.string_count == 2
+        && view.block_used == 3;
+}
+
+int test_concurrent_many_writers(void)
+{
+    struct stringv_concurrent cs;
+    struct stringv view;
+    struct writer writers[WRITERS];
+    struct reader reader;
+    pthread_t writer_threads[WRITERS], reader_thread;
+    static char seen[WRITERS][STRINGS_PER_WRITER];
+    char const *it = NULL;
+    int i = 0, id = 0, n = 0, result = 1;
+
+    assert(stringv_concurrent_init(
+                &cs, many_buf, (int)sizeof(many_buf), 8));
+
+    reader.cs = &cs;
+    reader.buf = NULL;
+    reader.failed = 0;
+    assert(pthread_create(&reader_thread, NULL, read_views, &reader) == 0);
+
+    for (i = 0; i < WRITERS; ++i) {
+        writers[i].cs = &cs;
+        writers[i].id = i;
+        writers[i].failed = 0;
+        assert(pthread_create(
+                    &writer_threads[i], NULL, write_strings, &writers[i]) == 0);
+    }
+
+    for (i = 0; i < WRITERS; ++i) {
+        assert(pthread_join(writer_threads[i], NULL) == 0);
+        result = result && !writers[i].failed;
+    }
+
+    assert(pthread_join(reader_thread, NULL) == 0);
+    result = result && !reader.failed;
+
+    /* Every string must be present exactly once */
+    assert(stringv_concurrent_view(&cs, &view));
+    for (it = stringv_begin(&view);
+            it != stringv_end(&view);
+            it = stringv_next(&view, it)) {
+        if (!parse_string(it, &id, &n) || seen[id][n]) {
+            return 0;
+        }
+        seen[id][n] = 1;
+    }
+
+    return result
+        && view.string_count == WRITERS * STRINGS_PER_WRITER
+        && view.block_used == cs.block_reserved;
+}
+
+int test_concurrent_get(void)
+{
+    struct stringv_concurrent cs;
+    char b[32] = {0};
+    char out[4] = {0};
+    size_t results[5] = {0};
+
+    assert(stringv_concurrent_init(&cs, b, 32, 4));
+    assert(stringv_concurrent_push_back(&cs, "AAA", 3));
+    assert(stringv_concurrent_push_back(&cs, "BBBBBB", 6));
+    assert(stringv_concurrent_push_back(&cs, "CC", 2));
+
+    stringv_concurrent_write_begin(&cs);
+    assert(stringv_tombstone(&cs.stringv, 0));
+    stringv_concurrent_write_end(&cs);
+
+    /* Truncated copies report the full length */
+    results[0] = stringv_concurrent_get(&cs, 0, out, sizeof(out));
+    if (results[0] != 6 || strcmp(out, "BBB") != 0) {
+        return 0;
+    }
+
+    results[1] = stringv_concurrent_get(&cs, 1, out, sizeof(out));
+    if (results[1] != 2 || strcmp(out, "CC") != 0) {
+        return 0;
+    }
+
+    results[2] = stringv_concurrent_get(&cs, 2, out, sizeof(out));
+    results[3] = stringv_concurrent_get(&cs, -1, out, sizeof(out));
+    results[4] = stringv_concurrent_get(NULL, 0, out, sizeof(out));
+
+    return results[2] == 0
+        && results[3] == 0
+        && results[4] == 0
+        && *out == '\0'
+        && stringv_concurrent_get(&cs, 0, NULL, 4) == 0
+        && stringv_concurrent_get(&cs, 0, out, 0) == 0;
+}
+
+int test_concurrent_read(void)
+{
+    struct stringv_concurrent cs;
+    struct stringv copy;
+    char b[32] = {0};
+    char c[32] = {0};
+
+    assert(stringv_concurrent_init(&cs, b, 32, 4));
+    assert(stringv_init(&copy, c, 32, 4));
+    assert(stringv_push_back(&copy, "ZZZZZZZZZZZZZZZZZZZZZZZ", 23));
+    assert(stringv_concurrent_push_back(&cs, "AAA", 3));
+    assert(stringv_concurrent_push_back(&cs, "BBBBBB", 6));
+
+    return stringv_concurrent_read(&cs, &copy) == 2
+        && copy.block_used == 3
+        && strcmp(stringv_get(&copy, 0), "AAA") == 0
+        && strcmp(stringv_get(&copy, 1), "BBBBBB") == 0
+        && c[12] == '\0'
+        && c[23] == '\0';
+}
+
+/* A snapshot that doesn't fit leaves the destination empty */
+int test_concurrent_read_too_small(void)
+{
+    struct stringv_concurrent cs;
+    struct stringv copy, wrong;
+    char b[32] = {0};
+    char c[8] = {0};
+    char d[32] = {0};
+
+    assert(stringv_concurrent_init(&cs, b, 32, 4));
+    assert(stringv_init(&copy, c, 8, 4));
+    assert(stringv_init(&wrong, d, 32, 8));
+    assert(stringv_push_back(&copy, "ZZZ", 3));
+    assert(stringv_concurrent_push_back(&cs, "AAA", 3));
+    assert(stringv_concurrent_push_back(&cs, "BBBBBB", 6));
+
+    return stringv_concurrent_read(&cs, &copy) == -1
+        && copy.string_count == 0
+        && c[0] == '\0'
+        && stringv_concurrent_read(&cs, &wrong) == -1
+        && stringv_concurrent_read(NULL, &copy) == -1
+        && stringv_concurrent_read(&cs, NULL) == -1;
+}
+
+/* Appends may resume after a single-writer modification */
+int test_concurrent_write_append(void)
+{
+    struct stringv_concurrent cs;
+    struct stringv view;
+    char b[32] = {0};
+
+    assert(stringv_concurrent_init(&cs, b, 32, 4));
+    assert(stringv_concurrent_push_back(&cs, "AAAAAA", 6));
+    assert(stringv_concurrent_push_back(&cs, "BBB", 3));
+
+    stringv_concurrent_write_begin(&cs);
+    assert(stringv_remove(&cs.stringv, 0));
+    stringv_concurrent_write_end(&cs);
+
+    return stringv_concurrent_push_back(&cs, "CCC", 3) == b + 4
+        && cs.block_reserved == 2
+        && stringv_concurrent_view(&cs, &view)
+        && view.string_count == 2
+        && strcmp(stringv_get(&view, 0), "BBB") == 0
+        && strcmp(stringv_get(&view, 1), "CCC") == 0;
+}
+
+int test_concurrent_single_writer(void)
+{
+    struct stringv_concurrent cs;
+    struct writer writer;
+    struct reader readers[READERS];
+    pthread_t writer_thread, reader_threads[READERS];
+    char string[32];
+    int i = 0, length = 0, result = 1;
+
+    assert(stringv_concurrent_init(
+                &cs, mutated_buf, (int)sizeof(mutated_buf), 8));
+    for (i = 0; i < MUTATED_STRINGS; ++i) {
+        length = make_uniform(string, 1 + i % 20);
+        assert(stringv_concurrent_push_back(&cs, string, (size_t)length));
+    }
+
+    for (i = 0; i < READERS; ++i) {
+        readers[i].cs = &cs;
+        readers[i].buf = copy_bufs[i];
+        readers[i].failed = 0;
+        assert(pthread_create(
+                    &reader_threads[i], NULL, read_copies, &readers[i]) == 0);
+    }
+
+    writer.cs = &cs;
+    writer.id = 0;
+    writer.failed = 0;
+    assert(pthread_create(&writer_thread, NULL, mutate_strings, &writer) == 0);
+
+    assert(pthread_join(writer_thread, NULL) == 0);
+    for (i = 0; i < READERS; ++i) {
+        assert(pthread_join(reader_threads[i], NULL) == 0);
+        result = result && !readers[i].failed;
+    }
+
+    return result
+        && !writer.failed
+        && cs.stringv.string_count == MUTATED_STRINGS
+        && cs.block_reserved == cs.stringv.block_used;
+}
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "test.h"
@@ -12,6 +13,7 @@ static int test_copy_succeeds_one_to_one(void);
 static int test_copy_succeeds_overfull(void);
 static int test_copy_succeeds_underfull(void);
 static int test_copy_partial(void);
+static int test_copy_large(void);
 
 static const test_case tests[] = {
     TEST_CASE(test_copy_params_bad),
@@ -21,7 +23,8 @@ static const test_case tests[] = {
     TEST_CASE(test_copy_succeeds_one_to_one),
     TEST_CASE(test_copy_succeeds_overfull),
     TEST_CASE(test_copy_succeeds_underfull),
-    TEST_CASE(test_copy_partial)
+    TEST_CASE(test_copy_partial),
+    TEST_CASE(test_copy_large)
 };
 
 int main(void)
@@ -170,3 +173,34 @@ int test_copy_partial(void)
         && s2.block_used == 2
         && s2.string_count == 1;
 }
+
+/* Tests a one-to-one copy large enough to take the streaming store path */
+int test_copy_large(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    int const size = 6 * 1024 * 1024 + 3;
+    char *b1 = NULL, *b2 = NULL;
+    char string[8];
+    int i, result = 0;
+
+    b1 = malloc((size_t)size);
+    b2 = malloc((size_t)size + 3);
+    assert(b1 && b2);
+
+    assert(stringv_init(&s1, b1, size, 8));
+    assert(stringv_init(&s2, b2 + 3, size, 8));
+
+    for (i = 0; i < s1.block_total; ++i) {
+        string[0] = (char)('a' + i % 26);
+        string[1] = (char)('a' + (i / 26) % 26);
+        assert(stringv_push_back(&s1, string, 2));
+    }
+
+    result = stringv_copy(&s2, &s1) == s1.string_count
+        && s2.block_used == s1.block_used
+        && memcmp(s2.buf, s1.buf, (size_t)(s1.block_used * 8)) == 0;
+
+    free(b1);
+    free(b2);
+    return result;
+}
@@ -0,0 +1,207 @@
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+/* These tests are linked with a stringv module compiled with
+ * STRINGV_COUNTERS defined */
+
+/* Zeroes the calling thread's counters */
+static void reset_counters(void);
+
+/* Pushes strings onto a stringv on another thread */
+static void *push_strings(void *arg);
+
+static int test_counters_params_bad(void);
+static int test_counters_reset(void);
+static int test_counters_fast_lookups(void);
+static int test_counters_slow_lookups(void);
+static int test_counters_moved_zeroed(void);
+static int test_counters_copies(void);
+static int test_counters_capacity(void);
+static int test_counters_per_thread(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_counters_params_bad),
+    TEST_CASE(test_counters_reset),
+    TEST_CASE(test_counters_fast_lookups),
+    TEST_CASE(test_counters_slow_lookups),
+    TEST_CASE(test_counters_moved_zeroed),
+    TEST_CASE(test_counters_copies),
+    TEST_CASE(test_counters_capacity),
+    TEST_CASE(test_counters_per_thread)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+void reset_counters(void)
+{
+    struct stringv_counters c;
+
+    assert(stringv_get_counters(&c, 1));
+}
+
+void *push_strings(void *arg)
+{
+    struct stringv *s = arg;
+
+    while (stringv_push_back(s, "AAAAA", 5)) {
+        /* Fill the stringv */
+    }
+
+    return NULL;
+}
+
+int test_counters_params_bad(void)
+{
+    return stringv_get_counters(NULL, 0) == NULL
+        && stringv_get_counters(NULL, 1) == NULL;
+}
+
+int test_counters_reset(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_counters c1, c2;
+    char b[16] = {0};
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_get(&s, 0));
+
+    return stringv_get_counters(&c1, 1) == &c1
+        && c1.fast_lookups > 0
+        && stringv_get_counters(&c2, 0) == &c2
+        && c2.fast_lookups == 0
+        && c2.bytes_zeroed == 0;
+}
+
+/* Lookups in a one-to-one stringv don't walk the blocks */
+int test_counters_fast_lookups(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_counters c;
+    char b[16] = {0};
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_push_back(&s, "C", 1));
+    reset_counters();
+
+    assert(stringv_get(&s, 2));
+    assert(stringv_get(&s, 1));
+    stringv_get_counters(&c, 0);
+
+    return c.fast_lookups == 2
+        && c.slow_lookups == 0
+        && c.blocks_scanned == 0;
+}
+
+/* Once a string spans blocks, lookups walk to the string */
+int test_counters_slow_lookups(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_counters c;
+    char b[32] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "AAAAAA", 6));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_push_back(&s, "C", 1));
+    reset_counters();
+
+    assert(strcmp(stringv_get(&s, 2), "C") == 0);
+    stringv_get_counters(&c, 0);
+
+    return c.fast_lookups == 0
+        && c.slow_lookups == 1
+        && c.blocks_scanned == 3;
+}
+
+int test_counters_moved_zeroed(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_counters c;
+    char b[32] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+    reset_counters();
+
+    /* Inserting at the front moves both strings right by one block, and
+     * clears the block opened */
+    assert(stringv_push_front(&s, "C", 1));
+    stringv_get_counters(&c, 1);
+    if (c.bytes_moved != 8 || c.bytes_zeroed != 4) {
+        return 0;
+    }
+
+    /* Removing from the front moves both back, and clears the block
+     * vacated */
+    assert(stringv_remove(&s, 0));
+    stringv_get_counters(&c, 0);
+    return c.bytes_moved == 8 && c.bytes_zeroed == 4;
+}
+
+int test_counters_copies(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO, s3 = STRINGV_ZERO;
+    struct stringv_counters c;
+    char b1[16] = {0}, b2[16] = {0}, b3[16] = {0};
+
+    assert(stringv_init(&s1, b1, 16, 4));
+    assert(stringv_init(&s2, b2, 16, 4));
+    assert(stringv_init(&s3, b3, 16, 2));
+    assert(stringv_push_back(&s1, "AB", 2));
+    reset_counters();
+
+    assert(stringv_copy(&s2, &s1) == 1);
+    assert(stringv_copy(&s3, &s1) == 1);
+    stringv_get_counters(&c, 0);
+
+    return c.blockwise_copies == 1 && c.stringwise_copies == 1;
+}
+
+int test_counters_capacity(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_counters c;
+    char b[8] = {0};
+
+    assert(stringv_init(&s, b, 8, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    reset_counters();
+
+    if (stringv_push_back(&s, "BBBB", 4)
+            || stringv_insert(&s, "CCCC", 4, 0)
+            || stringv_replace(&s, 0, "DDDDDDDDDD", 10)) {
+        return 0;
+    }
+
+    stringv_get_counters(&c, 0);
+    return c.capacity_failures == 3;
+}
+
+/* Work done on another thread isn't counted on this one */
+int test_counters_per_thread(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_counters c;
+    pthread_t thread;
+    char b[64] = {0};
+
+    assert(stringv_init(&s, b, 64, 8));
+    reset_counters();
+
+    assert(pthread_create(&thread, NULL, push_strings, &s) == 0);
+    assert(pthread_join(thread, NULL) == 0);
+    stringv_get_counters(&c, 0);
+
+    return s.string_count == 8 && c.capacity_failures == 0;
+}
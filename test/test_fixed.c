@@ -0,0 +1,239 @@
+#include <assert.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+#include "../stringv_fixed.h"
+
+/* A block size that isn't a power of two */
+STRINGV_FIXED(stringv24, 24)
+
+static int test_fixed_init(void);
+static int test_fixed_push_back_matches(void);
+static int test_fixed_push_back_full(void);
+static int test_fixed_get(void);
+static int test_fixed_iteration(void);
+static int test_fixed_find(void);
+static int test_fixed_find_slow(void);
+static int test_fixed_snapshot(void);
+static int test_fixed_other_size(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_fixed_init),
+    TEST_CASE(test_fixed_push_back_matches),
+    TEST_CASE(test_fixed_push_back_full),
+    TEST_CASE(test_fixed_get),
+    TEST_CASE(test_fixed_iteration),
+    TEST_CASE(test_fixed_find),
+    TEST_CASE(test_fixed_find_slow),
+    TEST_CASE(test_fixed_snapshot),
+    TEST_CASE(test_fixed_other_size)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int test_fixed_init(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[129] = {0};
+
+    return stringv32_init(&s, b, 128) == &s
+        && s.block_size == 32
+        && s.block_total == 4
+        && stringv16_init(NULL, b, 128) == NULL;
+}
+
+/* Pushing strings with the fixed functions gives exactly the stringv that the
+ * stringv functions give */
+int test_fixed_push_back_matches(void)
+{
+    static char const *const strings[] = {
+        "A", "BBBBBBBBBBBBBBB", "CCCCCCCCCCCCCCCC", "DD",
+        "EEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEEE"
+    };
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char b1[257] = {0}, b2[257] = {0};
+    char const *p1 = NULL, *p2 = NULL;
+    int i = 0;
+
+    assert(stringv_init(&s1, b1, 256, 16));
+    assert(stringv16_init(&s2, b2, 256));
+
+    for (i = 0; i < 5; ++i) {
+        p1 = stringv_push_back(&s1, strings[i], strlen(strings[i]));
+        p2 = stringv16_push_back(&s2, strings[i], strlen(strings[i]));
+        if (!p1 || p1 - b1 != p2 - b2) {
+            return 0;
+        }
+    }
+
+    return s1.block_used == s2.block_used
+        && s1.string_count == s2.string_count
+        && memcmp(b1, b2, sizeof(b1)) == 0
+        && !stringv16_push_back(&s2, NULL, 1)
+        && !stringv16_push_back(&s2, "A", 0)
+        && !stringv16_push_back(&s2, "A\0B", 3);
+}
+
+int test_fixed_push_back_full(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[33] = {0};
+
+    assert(stringv16_init(&s, b, 32));
+    assert(stringv16_push_back(&s, "AAAAAAAAAAAAAAA", 15));
+
+    return !stringv16_push_back(&s, "BBBBBBBBBBBBBBBB", 16)
+        && stringv16_push_back(&s, "CCCCCCCCCCCCCCC", 15)
+        && !stringv16_push_back(&s, "D", 1)
+        && s.block_used == 2
+        && s.string_count == 2;
+}
+
+/* Lookups in a one-to-one stringv take the fast path; others defer */
+int test_fixed_get(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[129] = {0};
+
+    assert(stringv32_init(&s, b, 128));
+    assert(stringv32_push_back(&s, "AAA", 3));
+    assert(stringv32_push_back(&s, "BBB", 3));
+
+    if (stringv32_get(&s, 1) != b + 32
+            || stringv32_get(&s, 2) != NULL
+            || stringv32_get(&s, -1) != NULL
+            || stringv32_get(NULL, 0) != NULL) {
+        return 0;
+    }
+
+    /* Now with a string spanning two blocks, and a tombstone */
+    assert(stringv32_push_back(&s, "CCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCC", 34));
+    assert(stringv_tombstone(&s, 0));
+
+    return strcmp(stringv32_get(&s, 0), "BBB") == 0
+        && stringv32_get(&s, 1) == b + 64
+        && stringv32_get(&s, 2) == NULL;
+}
+
+int test_fixed_iteration(void)
+{
+    static char const *const strings[] = {
+        "AAAAAAAAAAAAAAAAAAAA", "B", "CC", "DDD"
+    };
+    struct stringv s = STRINGV_ZERO;
+    char const *iter = NULL;
+    char b[129] = {0};
+    int i = 0;
+
+    assert(stringv16_init(&s, b, 128));
+    for (i = 0; i < 4; ++i) {
+        assert(stringv16_push_back(&s, strings[i], strlen(strings[i])));
+    }
+
+    for (iter = stringv16_begin(&s), i = 0;
+            iter != stringv16_end(&s);
+            iter = stringv16_next(&s, iter), ++i) {
+        if (iter != stringv_get(&s, i) || strcmp(iter, strings[i]) != 0) {
+            return 0;
+        }
+    }
+
+    if (i != 4) {
+        return 0;
+    }
+
+    /* Tombstones are skipped, as by stringv_next */
+    assert(stringv_tombstone(&s, 0));
+    assert(stringv_tombstone(&s, 0));
+    iter = stringv16_begin(&s);
+    return strcmp(iter, "CC") == 0
+        && strcmp(iter = stringv16_next(&s, iter), "DDD") == 0
+        && stringv16_next(&s, iter) == stringv16_end(&s);
+}
+
+int test_fixed_find(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[257] = {0};
+
+    assert(stringv64_init(&s, b, 256));
+    assert(stringv64_push_back(&s, "AAA", 3));
+    assert(stringv64_push_back(&s, "AAAB", 4));
+    assert(stringv64_push_back(&s, "AA", 2));
+
+    return stringv64_find(&s, "AA", 2) == 2
+        && stringv64_find(&s, "AAAB", 4) == 1
+        && stringv64_find(&s, "AAA", 3) == 0
+        && stringv64_find(&s, "A", 1) == -1
+        && stringv64_find(&s, "AAAAB", 3) == 0
+        && stringv64_find(&s, "", 0) == -1
+        && stringv64_find(NULL, "A", 1) == -1
+        && stringv64_find(&s, NULL, 1) == -1;
+}
+
+/* Without a one-to-one stringv, find walks the live strings */
+int test_fixed_find_slow(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[129] = {0};
+
+    assert(stringv16_init(&s, b, 128));
+    assert(stringv16_push_back(&s, "AAAAAAAAAAAAAAAAAAAA", 20));
+    assert(stringv16_push_back(&s, "B", 1));
+    assert(stringv16_push_back(&s, "CC", 2));
+    assert(stringv16_push_back(&s, "B", 1));
+    assert(stringv_tombstone(&s, 1));
+
+    return stringv16_find(&s, "AAAAAAAAAAAAAAAAAAAA", 20) == 0
+        && stringv16_find(&s, "AAAAAAAAAAAAAAA", 15) == -1
+        && stringv16_find(&s, "CC", 2) == 1
+        && stringv16_find(&s, "B", 1) == 2
+        && stringv16_find(&s, "C", 1) == -1;
+}
+
+/* With a snapshot active, pushes defer so that the snapshot is preserved */
+int test_fixed_snapshot(void)
+{
+    struct stringv s = STRINGV_ZERO, t = STRINGV_ZERO;
+    struct stringv_snapshot snapshot;
+    int chunk_map[4];
+    char b1[65] = {0}, b2[65] = {0}, store[64];
+
+    assert(stringv16_init(&s, b1, 64));
+    assert(stringv16_init(&t, b2, 64));
+    assert(stringv16_push_back(&s, "AAA", 3));
+    assert(stringv16_push_back(&s, "BBB", 3));
+    assert(stringv_snapshot_take(&snapshot, &s, 16, chunk_map, 4, store, 64));
+
+    assert(stringv_remove(&s, 1));
+    assert(stringv16_push_back(&s, "CCC", 3));
+
+    if (stringv_snapshot_copy(&t, &snapshot) != 2
+            || strcmp(stringv16_get(&t, 1), "BBB") != 0
+            || strcmp(stringv16_get(&s, 1), "CCC") != 0) {
+        return 0;
+    }
+
+    stringv_snapshot_release(&snapshot);
+    return 1;
+}
+
+int test_fixed_other_size(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[97] = {0};
+
+    assert(stringv24_init(&s, b, 96));
+    assert(stringv24_push_back(&s, "AAAAAAAAAAAAAAAAAAAAAAA", 23));
+    assert(stringv24_push_back(&s, "BBBBBBBBBBBBBBBBBBBBBBBB", 24));
+
+    return s.block_used == 3
+        && stringv24_get(&s, 1) == b + 24
+        && stringv24_find(&s, "BBBBBBBBBBBBBBBBBBBBBBBB", 24) == 1
+        && stringv24_next(&s, stringv24_begin(&s)) == b + 24
+        && stringv24_next(&s, b + 24) == stringv24_end(&s);
+}
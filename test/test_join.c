@@ -0,0 +1,202 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+static int test_join_params_bad(void);
+static int test_join_empty(void);
+static int test_join_one_to_one(void);
+static int test_join_multi_block(void);
+static int test_join_separators(void);
+static int test_join_tombstones(void);
+static int test_join_too_small(void);
+static int test_join_wide_blocks(void);
+static int test_join_split_roundtrip(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_join_params_bad),
+    TEST_CASE(test_join_empty),
+    TEST_CASE(test_join_one_to_one),
+    TEST_CASE(test_join_multi_block),
+    TEST_CASE(test_join_separators),
+    TEST_CASE(test_join_tombstones),
+    TEST_CASE(test_join_too_small),
+    TEST_CASE(test_join_wide_blocks),
+    TEST_CASE(test_join_split_roundtrip)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int test_join_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+    char out[16] = "X";
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+
+    return stringv_join(NULL, ",", 1, out, 16) == 0
+        && stringv_join(&s, NULL, 1, out, 16) == 0
+        && strcmp(out, "X") == 0;
+}
+
+int test_join_empty(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+    char out[4] = "X";
+
+    assert(stringv_init(&s, b, 16, 4));
+
+    return stringv_join(&s, ",", 1, out, 4) == 0
+        && out[0] == '\0';
+}
+
+int test_join_one_to_one(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[32] = {0};
+    char out[32];
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CC", 2));
+
+    return stringv_join(&s, ",", 1, out, 32) == 8
+        && strcmp(out, "A,BBB,CC") == 0;
+}
+
+int test_join_multi_block(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[32] = {0};
+    char out[32];
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "BBBBBBBBB", 9));
+    assert(stringv_push_back(&s, "CC", 2));
+
+    return stringv_join(&s, ",", 1, out, 32) == 14
+        && strcmp(out, "A,BBBBBBBBB,CC") == 0;
+}
+
+/* Separators may be empty or longer than one char, and need not be NUL
+ * terminated */
+int test_join_separators(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[32] = {0};
+    char out[32];
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+
+    if (stringv_join(&s, NULL, 0, out, 32) != 2 || strcmp(out, "AB") != 0) {
+        return 0;
+    }
+
+    if (stringv_join(&s, " - XYZ", 3, out, 32) != 5
+            || strcmp(out, "A - B") != 0) {
+        return 0;
+    }
+
+    /* And with a string spanning blocks */
+    assert(stringv_push_back(&s, "CCCCC", 5));
+    return stringv_join(&s, NULL, 0, out, 32) == 7
+        && strcmp(out, "ABCCCCC") == 0;
+}
+
+int test_join_tombstones(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char out[32];
+
+    assert(stringv_init(&s, b, 64, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_push_back(&s, "C", 1));
+    assert(stringv_tombstone(&s, 0));
+
+    if (stringv_join(&s, ",", 1, out, 32) != 3 || strcmp(out, "B,C") != 0) {
+        return 0;
+    }
+
+    /* The same, in a stringv that is not one-to-one */
+    assert(stringv_push_back(&s, "DDDDD", 5));
+    assert(stringv_tombstone(&s, 1));
+
+    return stringv_join(&s, ",", 1, out, 32) == 7
+        && strcmp(out, "B,DDDDD") == 0;
+}
+
+/* Nothing is written unless the result fits, but the size is returned */
+int test_join_too_small(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[32] = {0};
+    char out[8] = "XXXXXXX";
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+
+    return stringv_join(&s, ",", 1, NULL, 0) == 7
+        && stringv_join(&s, ",", 1, out, 7) == 7
+        && strcmp(out, "XXXXXXX") == 0
+        && stringv_join(&s, ",", 1, out, 8) == 7
+        && strcmp(out, "AAA,BBB") == 0;
+}
+
+/* Blocks wider than a vector, with strings either side of a vector's width */
+int test_join_wide_blocks(void)
+{
+    static char const *const strings[] = {
+        "A",
+        "0123456789ABCDE",
+        "0123456789ABCDEF",
+        "0123456789ABCDEF0123456789",
+        "0123456789ABCDEF0123456789ABCDEF0123456"
+    };
+    struct stringv s = STRINGV_ZERO;
+    char b[5 * 40 + 1] = {0};
+    char out[256], expected[256];
+    size_t i = 0, length = 0;
+
+    assert(stringv_init(&s, b, (int)sizeof(b), 40));
+
+    for (i = 0; i < 5; ++i) {
+        assert(stringv_push_back(&s, strings[i], strlen(strings[i])));
+        length += (size_t)sprintf(
+                expected + length, i > 0 ? "|%s" : "%s", strings[i]);
+    }
+
+    return stringv_join(&s, "|", 1, out, sizeof(out)) == length
+        && strcmp(out, expected) == 0;
+}
+
+int test_join_split_roundtrip(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char b1[64] = {0}, b2[64] = {0};
+    char const text[] = "one two three four";
+    char out[32];
+
+    assert(stringv_init(&s1, b1, 64, 8));
+    assert(stringv_init(&s2, b2, 64, 8));
+    assert(stringv_split_c(&s1, text, strlen(text), ' ') == strlen(text));
+
+    return stringv_join(&s1, " ", 1, out, 32) == strlen(text)
+        && strcmp(out, text) == 0
+        && stringv_split_c(&s2, out, strlen(out), ' ') == strlen(out)
+        && s2.string_count == 4;
+}
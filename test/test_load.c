@@ -0,0 +1,265 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "../stringv_io.h"
+
+#define MANY_LINES  2000
+
+/* Writes text to a new temporary file, whose name is written to path */
+static void write_temp(char *path, char const *text, size_t length);
+
+/* Loads text through a temporary file into s, and returns the result of
+ * stringv_load */
+static int load_text(
+        struct stringv *s,
+        char const *text,
+        char *scratch,
+        size_t scratch_size);
+
+/* Checks that two stringvs hold the same strings */
+static int same_strings(struct stringv const *a, struct stringv const *b);
+
+static int test_load_params_bad(void);
+static int test_load_basic(void);
+static int test_load_spanning(void);
+static int test_load_empty_lines(void);
+static int test_load_no_final_separator(void);
+static int test_load_empty_file(void);
+static int test_load_too_long(void);
+static int test_load_full(void);
+static int test_load_nul(void);
+static int test_load_many(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_load_params_bad),
+    TEST_CASE(test_load_basic),
+    TEST_CASE(test_load_spanning),
+    TEST_CASE(test_load_empty_lines),
+    TEST_CASE(test_load_no_final_separator),
+    TEST_CASE(test_load_empty_file),
+    TEST_CASE(test_load_too_long),
+    TEST_CASE(test_load_full),
+    TEST_CASE(test_load_nul),
+    TEST_CASE(test_load_many)
+};
+
+static char many_text[MANY_LINES * 8];
+static char many_buf1[MANY_LINES * 8 + 1];
+static char many_buf2[MANY_LINES * 8 + 1];
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+void write_temp(char *path, char const *text, size_t length)
+{
+    int fd = -1;
+
+    strcpy(path, "/tmp/test_load_XXXXXX");
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    assert(write(fd, text, length) == (ssize_t)length);
+    assert(close(fd) == 0);
+}
+
+int load_text(
+        struct stringv *s,
+        char const *text,
+        char *scratch,
+        size_t scratch_size)
+{
+    char path[32];
+    int loaded = 0, error = 0;
+
+    write_temp(path, text, strlen(text));
+    loaded = stringv_load(s, path, '\n', scratch, scratch_size);
+    error = errno;
+    assert(unlink(path) == 0);
+    errno = error;
+    return loaded;
+}
+
+int same_strings(struct stringv const *a, struct stringv const *b)
+{
+    int i = 0;
+
+    if (a->string_count != b->string_count) {
+        return 0;
+    }
+
+    for (i = 0; i < a->string_count; ++i) {
+        if (strcmp(stringv_get(a, i), stringv_get(b, i)) != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int test_load_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+    char scratch[16];
+
+    assert(stringv_init(&s, b, 16, 4));
+
+    return !stringv_load(NULL, "/tmp", '\n', scratch, 16)
+        && !stringv_load(&s, NULL, '\n', scratch, 16)
+        && !stringv_load(&s, "/tmp", '\n', NULL, 16)
+        && !stringv_load(&s, "/tmp", '\n', scratch, 2)
+        && errno == EINVAL
+        && !stringv_load(&s, "/nonexistent/file", '\n', scratch, 16)
+        && errno == ENOENT;
+}
+
+int test_load_basic(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char scratch[96];
+
+    assert(stringv_init(&s, b, 64, 4));
+
+    return load_text(&s, "A\nBBBBBB\nCC\n", scratch, sizeof(scratch))
+        && s.string_count == 3
+        && strcmp(stringv_get(&s, 0), "A") == 0
+        && strcmp(stringv_get(&s, 1), "BBBBBB") == 0
+        && strcmp(stringv_get(&s, 2), "CC") == 0;
+}
+
+/* With 4 char chunks, most lines span two or three chunks */
+int test_load_spanning(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char scratch[12];
+
+    assert(stringv_init(&s, b, 64, 4));
+
+    return load_text(&s, "AB\nCDEF\nG\nHIJ\n", scratch, sizeof(scratch))
+        && s.string_count == 4
+        && strcmp(stringv_get(&s, 0), "AB") == 0
+        && strcmp(stringv_get(&s, 1), "CDEF") == 0
+        && strcmp(stringv_get(&s, 2), "G") == 0
+        && strcmp(stringv_get(&s, 3), "HIJ") == 0;
+}
+
+int test_load_empty_lines(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char scratch[12];
+
+    assert(stringv_init(&s, b, 64, 4));
+
+    return load_text(&s, "\n\nA\n\n\n\nB\n\n", scratch, sizeof(scratch))
+        && s.string_count == 2
+        && strcmp(stringv_get(&s, 1), "B") == 0;
+}
+
+int test_load_no_final_separator(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char scratch[12];
+
+    assert(stringv_init(&s, b, 64, 4));
+
+    return load_text(&s, "A\nBCD", scratch, sizeof(scratch))
+        && s.string_count == 2
+        && strcmp(stringv_get(&s, 1), "BCD") == 0;
+}
+
+int test_load_empty_file(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+    char scratch[12];
+
+    assert(stringv_init(&s, b, 16, 4));
+
+    return load_text(&s, "", scratch, sizeof(scratch))
+        && s.string_count == 0;
+}
+
+/* A line longer than the carry area can't be joined */
+int test_load_too_long(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char scratch[12];
+
+    assert(stringv_init(&s, b, 64, 8));
+
+    return !load_text(&s, "A\nBCDEFG\nH\n", scratch, sizeof(scratch))
+        && errno == EOVERFLOW
+        && s.string_count == 1;
+}
+
+/* Loading stops when the stringv is full, keeping what was loaded */
+int test_load_full(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[9] = {0};
+    char scratch[12];
+
+    assert(stringv_init(&s, b, 9, 4));
+
+    return !load_text(&s, "A\nB\nC\nD\n", scratch, sizeof(scratch))
+        && errno == ENOSPC
+        && s.string_count == 2
+        && strcmp(stringv_get(&s, 1), "B") == 0;
+}
+
+/* A line containing NUL can't be stored, so loading stops before it */
+int test_load_nul(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char scratch[32];
+    char path[32];
+    int loaded = 0, error = 0;
+
+    assert(stringv_init(&s, b, 64, 8));
+    write_temp(path, "A\n\0B\nC\n", 7);
+    loaded = stringv_load(&s, path, '\n', scratch, sizeof(scratch));
+    error = errno;
+    assert(unlink(path) == 0);
+
+    return !loaded
+        && error == EINVAL
+        && s.string_count == 1
+        && strcmp(stringv_get(&s, 0), "A") == 0;
+}
+
+/* Loading gives the same stringv as splitting the whole text */
+int test_load_many(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    char scratch[3 * 64];
+    size_t length = 0;
+    int i = 0;
+
+    srand(0);
+    for (i = 0; i < MANY_LINES; ++i) {
+        length += (size_t)sprintf(many_text + length, "%d%s\n",
+                rand() % 100000, i % 7 == 0 ? "\n" : "");
+    }
+
+    assert(stringv_init(&s1, many_buf1, (int)sizeof(many_buf1), 8));
+    assert(stringv_init(&s2, many_buf2, (int)sizeof(many_buf2), 8));
+    assert(stringv_split_c(&s1, many_text, length, '\n') == length);
+
+    return load_text(&s2, many_text, scratch, sizeof(scratch))
+        && s2.string_count == MANY_LINES
+        && same_strings(&s1, &s2);
+}
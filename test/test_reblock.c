@@ -0,0 +1,346 @@
+#include <assert.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+/* Checks that the live strings of a stringv are exactly those given */
+static int has_strings(
+        struct stringv const *s,
+        char const *const *strings,
+        int count);
+
+/* Checks that every char of the stringv's used blocks after the string in
+ * each block, and every char of its unused blocks, is zero */
+static int has_zero_padding(struct stringv const *s);
+
+/* Pushes the given strings onto a stringv */
+static void push_strings(
+        struct stringv *s,
+        char const *const *strings,
+        int count);
+
+static int test_reblock_params_bad(void);
+static int test_reblock_grow(void);
+static int test_reblock_shrink(void);
+static int test_reblock_tombstones(void);
+static int test_reblock_resume(void);
+static int test_reblock_in_place_grow(void);
+static int test_reblock_in_place_shrink(void);
+static int test_reblock_in_place_dead(void);
+static int test_reblock_in_place_bad(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_reblock_params_bad),
+    TEST_CASE(test_reblock_grow),
+    TEST_CASE(test_reblock_shrink),
+    TEST_CASE(test_reblock_tombstones),
+    TEST_CASE(test_reblock_resume),
+    TEST_CASE(test_reblock_in_place_grow),
+    TEST_CASE(test_reblock_in_place_shrink),
+    TEST_CASE(test_reblock_in_place_dead),
+    TEST_CASE(test_reblock_in_place_bad)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int has_strings(
+        struct stringv const *s,
+        char const *const *strings,
+        int count)
+{
+    char const *string = NULL;
+    int i = 0;
+
+    for (i = 0; i < count; ++i) {
+        string = stringv_get(s, i);
+        if (!string || strcmp(string, strings[i]) != 0) {
+            return 0;
+        }
+    }
+
+    return stringv_get(s, count) == NULL;
+}
+
+int has_zero_padding(struct stringv const *s)
+{
+    char const *p = s->buf;
+    char const *const end = s->buf + s->block_total * s->block_size;
+
+    /* Skip each string and its terminator, then expect zeros up to the next
+     * block boundary */
+    while (p < s->buf + s->block_used * s->block_size) {
+        p += strlen(p) + 1;
+        while ((p - s->buf) % s->block_size != 0) {
+            if (*p++ != '\0') {
+                return 0;
+            }
+        }
+    }
+
+    while (p < end) {
+        if (*p++ != '\0') {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void push_strings(
+        struct stringv *s,
+        char const *const *strings,
+        int count)
+{
+    int i = 0;
+
+    for (i = 0; i < count; ++i) {
+        assert(stringv_push_back(s, strings[i], strlen(strings[i])));
+    }
+}
+
+int test_reblock_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_snapshot snapshot;
+    struct stringv_reblock_progress progress = {0, 0, 0};
+    int chunk_map[4];
+    char b1[16] = {0}, b2[16] = {0};
+
+    assert(stringv_init(&s, b1, 16, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+
+    if (stringv_reblock(NULL, 8, b2, 16, NULL) != -1
+            || stringv_reblock(&s, 1, b2, 16, NULL) != -1
+            || stringv_reblock(&s, 8, b1, 16, NULL) != -1
+            || stringv_reblock(&s, 8, b2, 4, NULL) != -1) {
+        return 0;
+    }
+
+    progress.next_block = 2;
+    if (stringv_reblock(&s, 8, b2, 16, &progress) != -1) {
+        return 0;
+    }
+
+    assert(stringv_snapshot_take(&snapshot, &s, 4, chunk_map, 4, NULL, 0));
+    if (stringv_reblock(&s, 8, b2, 16, NULL) != -1
+            || stringv_reblock(&s, 8, NULL, 0, NULL) != -1) {
+        return 0;
+    }
+
+    stringv_snapshot_release(&snapshot);
+    return s.buf == b1 && s.block_size == 4;
+}
+
+/* A one-to-one stringv moved to larger blocks is copied block by block */
+int test_reblock_grow(void)
+{
+    static char const *const strings[] = {"AB", "CDE", "F"};
+    struct stringv s = STRINGV_ZERO;
+    char b1[16] = {0}, b2[48];
+
+    memset(b2, 'X', sizeof(b2));
+    b2[40] = '\0';
+
+    assert(stringv_init(&s, b1, 16, 4));
+    push_strings(&s, strings, 3);
+
+    return stringv_reblock(&s, 8, b2, 40, NULL) == 1
+        && s.buf == b2
+        && s.block_size == 8
+        && s.block_total == 5
+        && s.block_used == 3
+        && has_strings(&s, strings, 3)
+        && has_zero_padding(&s);
+}
+
+int test_reblock_shrink(void)
+{
+    static char const *const strings[] = {"ABCDEFG", "H", "IJKLMNOPQ"};
+    struct stringv s = STRINGV_ZERO;
+    char b1[32] = {0}, b2[32];
+
+    memset(b2, 'X', sizeof(b2));
+    b2[30] = '\0';
+
+    assert(stringv_init(&s, b1, 32, 4));
+    push_strings(&s, strings, 3);
+
+    return stringv_reblock(&s, 3, b2, 30, NULL) == 1
+        && s.block_size == 3
+        && s.block_total == 10
+        && s.block_used == 8
+        && s.string_count == 3
+        && has_strings(&s, strings, 3)
+        && has_zero_padding(&s);
+}
+
+int test_reblock_tombstones(void)
+{
+    static char const *const strings[] = {"AAAAAA", "BB", "CCCCCCC", "D"};
+    static char const *const live[] = {"AAAAAA", "CCCCCCC"};
+    struct stringv s = STRINGV_ZERO;
+    char b1[32] = {0}, b2[32] = {0};
+
+    assert(stringv_init(&s, b1, 32, 4));
+    push_strings(&s, strings, 4);
+    assert(stringv_tombstone(&s, 1));
+    assert(stringv_tombstone(&s, 2));
+
+    return stringv_reblock(&s, 8, b2, 32, NULL) == 1
+        && s.string_count == 2
+        && s.dead_count == 0
+        && s.block_used == 2
+        && has_strings(&s, live, 2)
+        && has_zero_padding(&s);
+}
+
+/* A reblock that runs out of room leaves the stringv unchanged, and can be
+ * resumed with a larger buffer holding what was written to the first */
+int test_reblock_resume(void)
+{
+    static char const *const strings[] = {"AAA", "BBBBBBB", "CC", "DDDDD"};
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_reblock_progress progress = {0, 0, 0};
+    char b1[32] = {0}, b2[13] = {0}, b3[25] = {0};
+
+    assert(stringv_init(&s, b1, 32, 8));
+    push_strings(&s, strings, 4);
+
+    /* Three blocks of 4 fit "AAA" and "BBBBBBB", but not "CC" after them */
+    if (stringv_reblock(&s, 4, b2, 12, &progress) != 0
+            || progress.string_count != 2
+            || progress.block_used != 3
+            || s.buf != b1
+            || s.block_size != 8
+            || !has_strings(&s, strings, 4)) {
+        return 0;
+    }
+
+    memcpy(b3, b2, 12);
+    return stringv_reblock(&s, 4, b3, 24, &progress) == 1
+        && s.buf == b3
+        && s.block_used == 6
+        && has_strings(&s, strings, 4)
+        && has_zero_padding(&s);
+}
+
+int test_reblock_in_place_grow(void)
+{
+    static char const *const strings[] = {"AAA", "B", "CC"};
+    struct stringv s = STRINGV_ZERO;
+    char b[33] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+    push_strings(&s, strings, 3);
+
+    return stringv_reblock(&s, 8, NULL, 0, NULL) == 1
+        && s.buf == b
+        && s.block_size == 8
+        && s.block_total == 4
+        && s.block_used == 3
+        && has_strings(&s, strings, 3)
+        && has_zero_padding(&s);
+}
+
+int test_reblock_in_place_shrink(void)
+{
+    static char const *const strings[] = {"AAA", "B", "CC", "DDD"};
+    struct stringv s = STRINGV_ZERO;
+    char b[33] = {0};
+
+    assert(stringv_init(&s, b, 32, 8));
+    push_strings(&s, strings, 4);
+    assert(stringv_tombstone(&s, 1));
+
+    return stringv_reblock(&s, 4, NULL, 0, NULL) == 1
+        && s.block_size == 4
+        && s.block_total == 8
+        && s.block_used == 4
+        && s.dead_count == 1
+        && strcmp(stringv_get(&s, 1), "CC") == 0
+        && strcmp(stringv_get(&s, 2), "DDD") == 0
+        && has_zero_padding(&s);
+}
+
+/* A dead string longer than the new blocks must not run into the next one,
+ * even if its chars were left in its block (as by older versions of
+ * stringv_tombstone, in a saved image) */
+int test_reblock_in_place_dead(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char const *iter = NULL;
+    char b[81] = {0};
+    int i = 0, stale = 0, count = 0;
+
+    for (stale = 0; stale < 2; ++stale) {
+        assert(stringv_init(&s, b, 80, 8));
+        assert(stringv_push_back(&s, "abcdefg", 7));
+        for (i = 0; i < 9; ++i) {
+            assert(stringv_push_back(&s, "x", 1));
+        }
+        assert(stringv_tombstone(&s, 0));
+        if (stale) {
+            memcpy(b + 1, "bcdefg", 6);
+        }
+
+        if (stringv_reblock(&s, 4, NULL, 0, NULL) != 1
+                || s.string_count != 10
+                || s.dead_count != 1
+                || !has_zero_padding(&s)) {
+            return 0;
+        }
+
+        for (iter = stringv_begin(&s), count = 0;
+                iter != stringv_end(&s);
+                iter = stringv_next(&s, iter), ++count) {
+            if (strcmp(iter, "x") != 0) {
+                return 0;
+            }
+        }
+
+        if (count != 9) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* In place reblocks that are impossible leave the stringv unchanged */
+int test_reblock_in_place_bad(void)
+{
+    static char const *const strings[] = {"AAA", "BBBBBB"};
+    struct stringv s = STRINGV_ZERO;
+    char b1[33] = {0}, b2[17] = {0};
+
+    /* Not one-to-one */
+    assert(stringv_init(&s, b1, 32, 4));
+    push_strings(&s, strings, 2);
+    if (stringv_reblock(&s, 8, NULL, 0, NULL) != -1
+            || s.block_size != 4
+            || !has_strings(&s, strings, 2)) {
+        return 0;
+    }
+
+    /* A string too long for the smaller blocks */
+    assert(stringv_init(&s, b1, 32, 8));
+    push_strings(&s, strings, 2);
+    if (stringv_reblock(&s, 4, NULL, 0, NULL) != -1
+            || s.block_size != 8
+            || !has_strings(&s, strings, 2)) {
+        return 0;
+    }
+
+    /* No room for the larger blocks */
+    assert(stringv_init(&s, b2, 16, 4));
+    push_strings(&s, strings, 1);
+    assert(stringv_push_back(&s, "C", 1));
+    assert(stringv_push_back(&s, "D", 1));
+    return stringv_reblock(&s, 8, NULL, 0, NULL) == -1
+        && s.block_size == 4
+        && s.block_used == 3;
+}
@@ -11,6 +11,7 @@ static int test_remove_empty(void);
 static int test_remove_front(void);
 static int test_remove_back(void);
 static int test_remove_middle(void);
+static int test_remove_middle_multi_block(void);
 
 static const test_case tests[] = {
     TEST_CASE(test_remove_params_bad),
@@ -18,7 +19,8 @@ static const test_case tests[] = {
     TEST_CASE(test_remove_empty),
     TEST_CASE(test_remove_front),
     TEST_CASE(test_remove_back),
-    TEST_CASE(test_remove_middle)
+    TEST_CASE(test_remove_middle),
+    TEST_CASE(test_remove_middle_multi_block)
 };
 
 int main(void)
@@ -112,3 +114,21 @@ int test_remove_middle(void)
         && strcmp(stringv_get(&stringv, 0), "AAA") == 0
         && strcmp(stringv_get(&stringv, 1), "CCC") == 0;
 }
+
+int test_remove_middle_multi_block(void)
+{
+    struct stringv stringv = STRINGV_ZERO;
+    char buf[20] = {0};
+
+    assert(stringv_init(&stringv, buf, 20, 4));
+    assert(stringv_push_back(&stringv, "AAAAAA", 6));
+    assert(stringv_push_back(&stringv, "BBB", 3));
+    assert(stringv_push_back(&stringv, "CCCCC", 5));
+
+    return stringv_remove(&stringv, 1)
+        && stringv.string_count == 2
+        && stringv.block_used == 4
+        && strcmp(stringv_get(&stringv, 0), "AAAAAA") == 0
+        && strcmp(stringv_get(&stringv, 1), "CCCCC") == 0
+        && buf[16] == '\0';
+}
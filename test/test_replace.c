@@ -0,0 +1,141 @@
+#include <assert.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+static int test_replace_params_bad(void);
+static int test_replace_same_blocks(void);
+static int test_replace_grow(void);
+static int test_replace_shrink(void);
+static int test_replace_shrink_last(void);
+static int test_replace_grow_last(void);
+static int test_replace_no_space(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_replace_params_bad),
+    TEST_CASE(test_replace_same_blocks),
+    TEST_CASE(test_replace_grow),
+    TEST_CASE(test_replace_shrink),
+    TEST_CASE(test_replace_shrink_last),
+    TEST_CASE(test_replace_grow_last),
+    TEST_CASE(test_replace_no_space)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int test_replace_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[12] = {0};
+
+    assert(stringv_init(&s, b, 12, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+
+    return !stringv_replace(NULL, 0, "BBB", 3)
+        && !stringv_replace(&s, 0, NULL, 3)
+        && !stringv_replace(&s, 0, "BBB", 0)
+        && !stringv_replace(&s, -1, "BBB", 3)
+        && !stringv_replace(&s, 1, "BBB", 3);
+}
+
+/* A replacement using the same number of blocks is done in place, and any
+ * leftover chars from the longer original are zeroed */
+int test_replace_same_blocks(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[12] = {0};
+    char const *p = NULL;
+
+    assert(stringv_init(&s, b, 12, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    p = stringv_push_back(&s, "BBB", 3);
+    assert(stringv_push_back(&s, "CCC", 3));
+
+    return stringv_replace(&s, 1, "X", 1) == p
+        && s.block_used == 3
+        && s.string_count == 3
+        && memcmp(b, "AAA\0X\0\0\0CCC\0", 12) == 0;
+}
+
+int test_replace_grow(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[20] = {0};
+
+    assert(stringv_init(&s, b, 20, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCC", 3));
+
+    return !!stringv_replace(&s, 1, "XXXXXXX", 7)
+        && s.block_used == 4
+        && s.string_count == 3
+        && memcmp(b, "AAA\0XXXXXXX\0CCC\0\0\0\0\0", 20) == 0;
+}
+
+int test_replace_shrink(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[20] = {0};
+
+    assert(stringv_init(&s, b, 20, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBBBBBBBBB", 10));
+    assert(stringv_push_back(&s, "CCC", 3));
+    assert(s.block_used == 5);
+
+    return !!stringv_replace(&s, 1, "XX", 2)
+        && s.block_used == 3
+        && s.string_count == 3
+        && memcmp(b, "AAA\0XX\0\0CCC\0\0\0\0\0\0\0\0\0", 20) == 0;
+}
+
+int test_replace_shrink_last(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBBBBBBBBB", 10));
+
+    return !!stringv_replace(&s, 1, "XX", 2)
+        && s.block_used == 2
+        && s.string_count == 2
+        && memcmp(b, "AAA\0XX\0\0\0\0\0\0\0\0\0\0", 16) == 0
+        && s.string_count == s.block_used;
+}
+
+int test_replace_grow_last(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+
+    return !!stringv_replace(&s, 1, "XXXXXXXX", 8)
+        && s.block_used == 4
+        && strcmp(stringv_get(&s, 1), "XXXXXXXX") == 0;
+}
+
+/* A failed replacement leaves the stringv untouched */
+int test_replace_no_space(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[12] = {0};
+
+    assert(stringv_init(&s, b, 12, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCC", 3));
+
+    return !stringv_replace(&s, 1, "XXXXXXX", 7)
+        && s.block_used == 3
+        && memcmp(b, "AAA\0BBB\0CCC\0", 12) == 0;
+}
@@ -0,0 +1,71 @@
+#include <assert.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+static int test_reverse_params_bad(void);
+static int test_reverse_empty(void);
+static int test_reverse_one_to_one(void);
+static int test_reverse_multi_block(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_reverse_params_bad),
+    TEST_CASE(test_reverse_empty),
+    TEST_CASE(test_reverse_one_to_one),
+    TEST_CASE(test_reverse_multi_block)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int test_reverse_params_bad(void)
+{
+    return !stringv_reverse(NULL);
+}
+
+int test_reverse_empty(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[12] = {0};
+
+    assert(stringv_init(&s, b, 12, 4));
+
+    return stringv_reverse(&s)
+        && s.block_used == 0;
+}
+
+int test_reverse_one_to_one(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCC", 3));
+
+    return stringv_reverse(&s)
+        && memcmp(b, "CCC\0BBB\0AAA\0\0\0\0\0", 16) == 0;
+}
+
+int test_reverse_multi_block(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[36] = {0};
+
+    assert(stringv_init(&s, b, 36, 4));
+    assert(stringv_push_back(&s, "AAAAAAAAAA", 10));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCCCC", 5));
+    assert(stringv_push_back(&s, "DDD", 3));
+
+    return stringv_reverse(&s)
+        && s.block_used == 7
+        && strcmp(stringv_get(&s, 0), "DDD") == 0
+        && strcmp(stringv_get(&s, 1), "CCCCC") == 0
+        && strcmp(stringv_get(&s, 2), "BBB") == 0
+        && strcmp(stringv_get(&s, 3), "AAAAAAAAAA") == 0;
+}
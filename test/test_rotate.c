@@ -0,0 +1,82 @@
+#include <assert.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+static int test_rotate_params_bad(void);
+static int test_rotate_noop(void);
+static int test_rotate_one_to_one(void);
+static int test_rotate_multi_block(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_rotate_params_bad),
+    TEST_CASE(test_rotate_noop),
+    TEST_CASE(test_rotate_one_to_one),
+    TEST_CASE(test_rotate_multi_block)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int test_rotate_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[12] = {0};
+
+    assert(stringv_init(&s, b, 12, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+
+    return !stringv_rotate(NULL, 0)
+        && !stringv_rotate(&s, -1)
+        && !stringv_rotate(&s, 2);
+}
+
+int test_rotate_noop(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[12] = {0};
+
+    assert(stringv_init(&s, b, 12, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+
+    return stringv_rotate(&s, 0)
+        && stringv_rotate(&s, 2)
+        && memcmp(b, "AAA\0BBB\0\0\0\0\0", 12) == 0;
+}
+
+int test_rotate_one_to_one(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[20] = {0};
+
+    assert(stringv_init(&s, b, 20, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCC", 3));
+    assert(stringv_push_back(&s, "DDD", 3));
+    assert(stringv_push_back(&s, "EEE", 3));
+
+    return stringv_rotate(&s, 2)
+        && memcmp(b, "CCC\0DDD\0EEE\0AAA\0BBB\0", 20) == 0;
+}
+
+int test_rotate_multi_block(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[32] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "AAAAAA", 6));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCCCCCCCC", 9));
+
+    return stringv_rotate(&s, 1)
+        && s.block_used == 6
+        && strcmp(stringv_get(&s, 0), "BBB") == 0
+        && strcmp(stringv_get(&s, 1), "CCCCCCCCC") == 0
+        && strcmp(stringv_get(&s, 2), "AAAAAA") == 0;
+}
@@ -0,0 +1,304 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "../stringv_io.h"
+
+/* Fills path with the name of a new, empty temporary file */
+static void temp_path(char *path);
+
+static int test_save_params_bad(void);
+static int test_save_roundtrip(void);
+static int test_save_index(void);
+static int test_save_empty(void);
+static int test_save_tombstones(void);
+static int test_save_modify_mapped(void);
+static int test_save_corrupt(void);
+static int test_save_truncated(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_save_params_bad),
+    TEST_CASE(test_save_roundtrip),
+    TEST_CASE(test_save_index),
+    TEST_CASE(test_save_empty),
+    TEST_CASE(test_save_tombstones),
+    TEST_CASE(test_save_modify_mapped),
+    TEST_CASE(test_save_corrupt),
+    TEST_CASE(test_save_truncated)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+void temp_path(char *path)
+{
+    int fd = -1;
+
+    strcpy(path, "/tmp/test_save_XXXXXX");
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    (void)close(fd);
+}
+
+int test_save_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[16] = {0};
+    char path[32];
+
+    assert(stringv_init(&s, b, 16, 4));
+    temp_path(path);
+
+    return !stringv_save(NULL, path, 0)
+        && !stringv_save(&s, NULL, 0)
+        && !stringv_save(&s, "/nonexistent/dir/file", 0)
+        && !stringv_open_mapped(NULL, path)
+        && !stringv_open_mapped(&file, NULL)
+        && !stringv_open_mapped(&file, "/nonexistent/dir/file")
+        && !stringv_close_mapped(NULL)
+        && unlink(path) == 0;
+}
+
+/* The loaded stringv holds the same strings, at the same block positions */
+int test_save_roundtrip(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[64] = {0};
+    char path[32];
+    int result = 0;
+
+    assert(stringv_init(&s, b, 64, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "BBBBBBB", 7));
+    assert(stringv_push_back(&s, "CC", 2));
+    temp_path(path);
+
+    if (!stringv_save(&s, path, 0) || !stringv_open_mapped(&file, path)) {
+        return 0;
+    }
+
+    result = file.stringv.block_size == 4
+        && file.stringv.block_used == 4
+        && file.stringv.block_total == 4
+        && file.stringv.string_count == 3
+        && !file.index
+        && !file.lengths
+        && memcmp(file.stringv.buf, b, 16) == 0
+        && file.stringv.buf[16] == '\0'
+        && strcmp(stringv_get(&file.stringv, 1), "BBBBBBB") == 0
+        && strcmp(stringv_get(&file.stringv, 2), "CC") == 0;
+
+    return stringv_close_mapped(&file)
+        && !file.map
+        && !file.stringv.buf
+        && unlink(path) == 0
+        && result;
+}
+
+int test_save_index(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[64] = {0};
+    char path[32];
+    int result = 0;
+
+    assert(stringv_init(&s, b, 64, 4));
+    assert(stringv_push_back(&s, "AAAAA", 5));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_push_back(&s, "CCC", 3));
+    temp_path(path);
+
+    if (!stringv_save(&s, path, STRINGV_SAVE_INDEX)
+            || !stringv_open_mapped(&file, path)) {
+        return 0;
+    }
+
+    result = file.index
+        && file.lengths
+        && (size_t)file.index % sizeof(int32_t) == 0
+        && file.index[0] == 0
+        && file.index[1] == 2
+        && file.index[2] == 3
+        && file.lengths[0] == 5
+        && file.lengths[1] == 1
+        && file.lengths[2] == 3
+        && strcmp(file.stringv.buf
+                + file.index[2] * file.stringv.block_size, "CCC") == 0;
+
+    return stringv_close_mapped(&file) && unlink(path) == 0 && result;
+}
+
+/* An empty stringv is saved with a single empty block */
+int test_save_empty(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[16] = {0};
+    char path[32];
+    int result = 0;
+
+    assert(stringv_init(&s, b, 16, 4));
+    temp_path(path);
+
+    if (!stringv_save(&s, path, STRINGV_SAVE_INDEX)
+            || !stringv_open_mapped(&file, path)) {
+        return 0;
+    }
+
+    result = file.stringv.block_total == 1
+        && file.stringv.block_used == 0
+        && file.stringv.string_count == 0
+        && stringv_begin(&file.stringv) == stringv_end(&file.stringv)
+        && !stringv_get(&file.stringv, 0);
+
+    return stringv_close_mapped(&file) && unlink(path) == 0 && result;
+}
+
+/* Tombstones are saved as they are, and are left out of the tables */
+int test_save_tombstones(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[64] = {0};
+    char path[32];
+    int result = 0;
+
+    assert(stringv_init(&s, b, 64, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_push_back(&s, "C", 1));
+    assert(stringv_tombstone(&s, 1));
+    temp_path(path);
+
+    if (!stringv_save(&s, path, STRINGV_SAVE_INDEX)
+            || !stringv_open_mapped(&file, path)) {
+        return 0;
+    }
+
+    result = file.stringv.string_count == 3
+        && file.stringv.dead_count == 1
+        && file.index[0] == 0
+        && file.index[1] == 2
+        && strcmp(stringv_get(&file.stringv, 1), "C") == 0
+        && stringv_compact(&file.stringv)
+        && file.stringv.string_count == 2;
+
+    return stringv_close_mapped(&file) && unlink(path) == 0 && result;
+}
+
+/* Changes to a loaded stringv are not written back to the file */
+int test_save_modify_mapped(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[64] = {0};
+    char path[32];
+    int result = 0;
+
+    assert(stringv_init(&s, b, 64, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    temp_path(path);
+
+    if (!stringv_save(&s, path, 0) || !stringv_open_mapped(&file, path)) {
+        return 0;
+    }
+
+    result = stringv_replace(&file.stringv, 0, "ZZ", 2)
+        && !stringv_push_back(&file.stringv, "C", 1)
+        && stringv_close_mapped(&file)
+        && stringv_open_mapped(&file, path)
+        && strcmp(stringv_get(&file.stringv, 0), "AAA") == 0;
+
+    return stringv_close_mapped(&file) && unlink(path) == 0 && result;
+}
+
+/* Files with the wrong magic number, version, inconsistent counts, or
+ * offsets that point outside the file (including by wrapping around) are
+ * rejected */
+int test_save_corrupt(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file_header header;
+    struct stringv_file file;
+    char b[16] = {0};
+    char path[32];
+    FILE *f = NULL;
+    int32_t entry = 0;
+    int result = 1, i = 0;
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    temp_path(path);
+
+    for (i = 0; i < 9; ++i) {
+        assert(stringv_save(&s, path, STRINGV_SAVE_INDEX));
+        f = fopen(path, "r+b");
+        assert(f && fread(&header, sizeof(header), 1, f) == 1);
+
+        switch (i) {
+        case 0: header.magic[0] = 'X'; break;
+        case 1: header.version = STRINGV_FILE_VERSION + 1; break;
+        case 2: header.block_used = header.block_total + 1; break;
+        case 3: header.blocks_offset = header.size; break;
+        case 4: header.blocks_offset = UINT64_MAX - 16; break;
+        case 5: header.lengths_offset = UINT64_MAX - 3; break;
+        case 6:
+            /* Over the NUL that ends the blocks */
+            header.index_offset = header.blocks_offset
+                + (uint64_t)(header.block_total * header.block_size);
+            break;
+        case 7:
+            /* An index entry past the used blocks */
+            entry = 1;
+            assert(fseek(f, (long)header.index_offset, SEEK_SET) == 0);
+            assert(fwrite(&entry, sizeof(entry), 1, f) == 1);
+            break;
+        default:
+            /* A length that runs past the used blocks */
+            entry = 4;
+            assert(fseek(f, (long)header.lengths_offset, SEEK_SET) == 0);
+            assert(fwrite(&entry, sizeof(entry), 1, f) == 1);
+            break;
+        }
+
+        assert(fseek(f, 0, SEEK_SET) == 0);
+        assert(fwrite(&header, sizeof(header), 1, f) == 1);
+        assert(fclose(f) == 0);
+        result = result && !stringv_open_mapped(&file, path);
+    }
+
+    return unlink(path) == 0 && result;
+}
+
+int test_save_truncated(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[16] = {0};
+    char path[32];
+    int result = 0;
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    temp_path(path);
+
+    assert(stringv_save(&s, path, STRINGV_SAVE_INDEX));
+    assert(truncate(path, (off_t)sizeof(struct stringv_file_header) + 2) == 0);
+    result = !stringv_open_mapped(&file, path);
+
+    assert(truncate(path, 4) == 0);
+    result = result && !stringv_open_mapped(&file, path);
+
+    return unlink(path) == 0 && result;
+}
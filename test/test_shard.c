@@ -0,0 +1,352 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv_shard.h"
+
+#define SHARDS              4
+#define STRINGS_PER_WRITER  500
+
+/* Arguments for a writer thread */
+struct writer {
+    struct stringv_shard *ss;
+    int id;
+    int hashed;
+    int failed;
+};
+
+static void *write_strings(void *arg);
+
+static int test_shard_params_bad(void);
+static int test_shard_init(void);
+static int test_shard_push_back(void);
+static int test_shard_push_hashed(void);
+static int test_shard_locate(void);
+static int test_shard_iteration(void);
+static int test_shard_merge(void);
+static int test_shard_merge_stringwise(void);
+static int test_shard_merge_snapshot(void);
+static int test_shard_many_writers(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_shard_params_bad),
+    TEST_CASE(test_shard_init),
+    TEST_CASE(test_shard_push_back),
+    TEST_CASE(test_shard_push_hashed),
+    TEST_CASE(test_shard_locate),
+    TEST_CASE(test_shard_iteration),
+    TEST_CASE(test_shard_merge),
+    TEST_CASE(test_shard_merge_stringwise),
+    TEST_CASE(test_shard_merge_snapshot),
+    TEST_CASE(test_shard_many_writers)
+};
+
+static char many_buf[2 * SHARDS * STRINGS_PER_WRITER * 16];
+static char merged_buf[sizeof(many_buf)];
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+/* Pushes strings of the form "<id>:<n>", either to the writer's own shard or
+ * by hash */
+void *write_strings(void *arg)
+{
+    struct writer *w = arg;
+    char string[32];
+    int i = 0, length = 0;
+
+    for (i = 0; i < STRINGS_PER_WRITER; ++i) {
+        length = sprintf(string, "%d:%d", w->id, i);
+        if (!(w->hashed
+                    ? stringv_shard_push_hashed(w->ss, string, (size_t)length)
+                    : stringv_shard_push_back(
+                        w->ss, w->id, string, (size_t)length))) {
+            w->failed = 1;
+        }
+    }
+
+    return NULL;
+}
+
+int test_shard_params_bad(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[2];
+    struct stringv_shard_pos pos = {0, 0};
+    struct stringv_shard_iter it;
+    struct stringv dest;
+    char b[32] = {0};
+    char d[16] = {0};
+
+    assert(stringv_shard_init(&ss, slots, 2, b, 32, 4));
+    assert(stringv_init(&dest, d, 16, 4));
+
+    return !stringv_shard_init(NULL, slots, 2, b, 32, 4)
+        && !stringv_shard_init(&ss, NULL, 2, b, 32, 4)
+        && !stringv_shard_init(&ss, slots, 0, b, 32, 4)
+        && !stringv_shard_init(&ss, slots, 2, NULL, 32, 4)
+        && !stringv_shard_init(&ss, slots, 2, b, 32, 1)
+        && !stringv_shard_init(&ss, slots, 2, b, 8, 4)
+        && !stringv_shard_push_back(NULL, 0, "A", 1)
+        && !stringv_shard_push_back(&ss, -1, "A", 1)
+        && !stringv_shard_push_back(&ss, 2, "A", 1)
+        && !stringv_shard_push_hashed(&ss, NULL, 1)
+        && !stringv_shard_push_hashed(&ss, "A", 0)
+        && !stringv_shard_locate(&ss, 0, &pos)
+        && !stringv_shard_locate(&ss, -1, &pos)
+        && !stringv_shard_get(&ss, pos)
+        && !stringv_shard_begin(&ss, &it)
+        && !stringv_shard_begin(NULL, &it)
+        && stringv_shard_merge(NULL, &ss, 1) == -1
+        && stringv_shard_merge(&dest, NULL, 1) == -1;
+}
+
+/* The buffer is split into equal, NUL separated slices */
+int test_shard_init(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[3];
+    char b[40];
+
+    memset(b, 'X', sizeof(b));
+    b[39] = '\0';
+    assert(stringv_shard_init(&ss, slots, 3, b, 39, 4));
+
+    return ss.shard_count == 3
+        && sizeof(slots[0]) % STRINGV_CACHE_LINE == 0
+        && slots[0].cs.stringv.buf == b
+        && slots[1].cs.stringv.buf == b + 13
+        && slots[2].cs.stringv.buf == b + 26
+        && slots[2].cs.stringv.block_total == 3
+        && b[12] == '\0'
+        && b[25] == '\0'
+        && b[38] == '\0';
+}
+
+int test_shard_push_back(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[2];
+    struct stringv_shard_pos pos = {1, 0};
+    char b[32] = {0};
+    char const *p = NULL;
+
+    assert(stringv_shard_init(&ss, slots, 2, b, 32, 4));
+    assert(stringv_shard_push_back(&ss, 0, "AAA", 3));
+    p = stringv_shard_push_back(&ss, 1, "BBBBB", 5);
+
+    /* The second shard is full after one more block */
+    return p == b + 13
+        && stringv_shard_get(&ss, pos) == p
+        && stringv_shard_push_back(&ss, 1, "CC", 2)
+        && !stringv_shard_push_back(&ss, 1, "D", 1)
+        && stringv_shard_count(&ss) == 3;
+}
+
+/* Equal strings are routed to the same shard */
+int test_shard_push_hashed(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[SHARDS];
+    char b[256] = {0};
+    char const *first = NULL, *second = NULL;
+    int i = 0, result = 1;
+
+    assert(stringv_shard_init(&ss, slots, SHARDS, b, 256, 4));
+
+    for (i = 0; i < 3; ++i) {
+        first = stringv_shard_push_hashed(&ss, "hello", 5);
+        second = stringv_shard_push_hashed(&ss, "hello", 5);
+        result = result && first && second && second - first == 8
+            && strcmp(second, "hello") == 0;
+    }
+
+    return result && stringv_shard_count(&ss) == 6;
+}
+
+int test_shard_locate(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[3];
+    struct stringv_shard_pos pos;
+    char b[64] = {0};
+
+    assert(stringv_shard_init(&ss, slots, 3, b, 64, 4));
+    assert(stringv_shard_push_back(&ss, 0, "A", 1));
+    assert(stringv_shard_push_back(&ss, 2, "B", 1));
+    assert(stringv_shard_push_back(&ss, 2, "C", 1));
+
+    if (!stringv_shard_locate(&ss, 0, &pos)
+            || pos.shard != 0
+            || pos.pos != 0) {
+        return 0;
+    }
+
+    if (!stringv_shard_locate(&ss, 2, &pos)
+            || pos.shard != 2
+            || pos.pos != 1) {
+        return 0;
+    }
+
+    return strcmp(stringv_shard_get(&ss, pos), "C") == 0
+        && !stringv_shard_locate(&ss, 3, &pos);
+}
+
+/* Iteration visits the shards in order, skipping empty ones */
+int test_shard_iteration(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[4];
+    struct stringv_shard_iter it;
+    char b[128] = {0};
+    char joined[16] = {0};
+    char const *iter = NULL;
+
+    assert(stringv_shard_init(&ss, slots, 4, b, 128, 4));
+    assert(stringv_shard_push_back(&ss, 1, "A", 1));
+    assert(stringv_shard_push_back(&ss, 1, "BBBBB", 5));
+    assert(stringv_shard_push_back(&ss, 3, "C", 1));
+
+    for (iter = stringv_shard_begin(&ss, &it);
+            iter;
+            iter = stringv_shard_next(&ss, &it, iter)) {
+        strcat(joined, iter);
+    }
+
+    return strcmp(joined, "ABBBBBC") == 0;
+}
+
+/* Merging appends the shards blockwise, in order */
+int test_shard_merge(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[3];
+    struct stringv dest;
+    char b[64] = {0};
+    char d[64] = {0};
+
+    assert(stringv_shard_init(&ss, slots, 3, b, 64, 4));
+    assert(stringv_init(&dest, d, 64, 4));
+    assert(stringv_push_back(&dest, "Z", 1));
+    assert(stringv_shard_push_back(&ss, 0, "AAAAA", 5));
+    assert(stringv_shard_push_back(&ss, 2, "B", 1));
+    assert(stringv_shard_push_back(&ss, 2, "CC", 2));
+
+    return stringv_shard_merge(&dest, &ss, 3) == 3
+        && dest.string_count == 4
+        && dest.block_used == 5
+        && strcmp(stringv_get(&dest, 0), "Z") == 0
+        && strcmp(stringv_get(&dest, 1), "AAAAA") == 0
+        && strcmp(stringv_get(&dest, 2), "B") == 0
+        && strcmp(stringv_get(&dest, 3), "CC") == 0
+        && d[20] == '\0';
+}
+
+/* Merging into a stringv with a different block size falls back to
+ * stringv_append */
+int test_shard_merge_stringwise(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[2];
+    struct stringv dest;
+    char b[64] = {0};
+    char d[64] = {0};
+
+    assert(stringv_shard_init(&ss, slots, 2, b, 64, 4));
+    assert(stringv_init(&dest, d, 64, 8));
+    assert(stringv_shard_push_back(&ss, 0, "AAAAA", 5));
+    assert(stringv_shard_push_back(&ss, 1, "B", 1));
+
+    return stringv_shard_merge(&dest, &ss, 2) == 2
+        && dest.block_used == 2
+        && strcmp(stringv_get(&dest, 0), "AAAAA") == 0
+        && strcmp(stringv_get(&dest, 1), "B") == 0;
+}
+
+/* Merging into a stringv with a snapshot preserves the blocks it overwrites,
+ * even when they were freed after the snapshot was taken */
+int test_shard_merge_snapshot(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[2];
+    struct stringv dest, copy;
+    struct stringv_snapshot snapshot;
+    int chunk_map[4];
+    char b[64] = {0};
+    char d[17] = {0}, c[17] = {0}, store[16];
+    int result = 0;
+
+    assert(stringv_shard_init(&ss, slots, 2, b, 64, 4));
+    assert(stringv_init(&dest, d, 16, 4));
+    assert(stringv_init(&copy, c, 16, 4));
+    assert(stringv_push_back(&dest, "Y", 1));
+    assert(stringv_push_back(&dest, "Z", 1));
+    assert(stringv_snapshot_take(
+                &snapshot, &dest, 4, chunk_map, 4, store, 16));
+    assert(stringv_remove(&dest, 1));
+    assert(stringv_shard_push_back(&ss, 0, "AAAAA", 5));
+
+    result = stringv_shard_merge(&dest, &ss, 2) == 1
+        && strcmp(stringv_get(&dest, 1), "AAAAA") == 0
+        && stringv_snapshot_copy(&copy, &snapshot) == 2
+        && strcmp(stringv_get(&copy, 0), "Y") == 0
+        && strcmp(stringv_get(&copy, 1), "Z") == 0;
+
+    stringv_snapshot_release(&snapshot);
+    return result;
+}
+
+int test_shard_many_writers(void)
+{
+    struct stringv_shard ss;
+    union stringv_shard_slot slots[SHARDS];
+    struct stringv merged;
+    struct writer writers[2 * SHARDS];
+    pthread_t ids[2 * SHARDS];
+    static char seen[2 * SHARDS][STRINGS_PER_WRITER];
+    char const *it = NULL;
+    int i = 0, id = 0, n = 0, result = 1;
+
+    assert(stringv_shard_init(
+                &ss, slots, SHARDS, many_buf, (int)sizeof(many_buf) - 1, 8));
+    assert(stringv_init(
+                &merged, merged_buf, (int)sizeof(merged_buf) - 1, 8));
+
+    /* Half the writers own a shard each; the other half share them all */
+    for (i = 0; i < 2 * SHARDS; ++i) {
+        writers[i].ss = &ss;
+        writers[i].id = i;
+        writers[i].hashed = i >= SHARDS;
+        writers[i].failed = 0;
+        assert(pthread_create(&ids[i], NULL, write_strings, &writers[i]) == 0);
+    }
+
+    for (i = 0; i < 2 * SHARDS; ++i) {
+        assert(pthread_join(ids[i], NULL) == 0);
+        result = result && !writers[i].failed;
+    }
+
+    if (stringv_shard_merge(&merged, &ss, SHARDS)
+            != 2 * SHARDS * STRINGS_PER_WRITER) {
+        return 0;
+    }
+
+    /* Every string must be present exactly once */
+    for (it = stringv_begin(&merged);
+            it != stringv_end(&merged);
+            it = stringv_next(&merged, it)) {
+        if (sscanf(it, "%d:%d", &id, &n) != 2
+                || id < 0 || id >= 2 * SHARDS
+                || n < 0 || n >= STRINGS_PER_WRITER
+                || seen[id][n]) {
+            return 0;
+        }
+        seen[id][n] = 1;
+    }
+
+    return result && merged.string_count == 2 * SHARDS * STRINGS_PER_WRITER;
+}
@@ -0,0 +1,211 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "../stringv_io.h"
+
+/* Fills name with a shared memory object name unique to this process */
+static void shared_name(char *name);
+
+/* Fills s with the strings "A", "BBBBBBB" and "CC" */
+static void fill(struct stringv *s, char *buf, int buf_size);
+
+static int test_shared_params_bad(void);
+static int test_shared_roundtrip(void);
+static int test_shared_exists(void);
+static int test_shared_one_copy(void);
+static int test_shared_fd(void);
+static int test_shared_processes(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_shared_params_bad),
+    TEST_CASE(test_shared_roundtrip),
+    TEST_CASE(test_shared_exists),
+    TEST_CASE(test_shared_one_copy),
+    TEST_CASE(test_shared_fd),
+    TEST_CASE(test_shared_processes)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+void shared_name(char *name)
+{
+    sprintf(name, "/test_shared_%ld", (long)getpid());
+}
+
+void fill(struct stringv *s, char *buf, int buf_size)
+{
+    assert(stringv_init(s, buf, buf_size, 4));
+    assert(stringv_push_back(s, "A", 1));
+    assert(stringv_push_back(s, "BBBBBBB", 7));
+    assert(stringv_push_back(s, "CC", 2));
+}
+
+int test_shared_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[16] = {0};
+    char name[32];
+
+    assert(stringv_init(&s, b, 16, 4));
+    shared_name(name);
+
+    return !stringv_save_fd(NULL, 1, 0)
+        && !stringv_save_fd(&s, -1, 0)
+        && !stringv_share(NULL, name, 0)
+        && !stringv_share(&s, NULL, 0)
+        && !stringv_map_shared(NULL, 0)
+        && !stringv_map_shared(&file, -1)
+        && !stringv_open_shared(NULL, name)
+        && !stringv_open_shared(&file, NULL)
+        && !stringv_open_shared(&file, name);
+}
+
+int test_shared_roundtrip(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[64] = {0};
+    char name[32];
+    int result = 0;
+
+    fill(&s, b, 64);
+    shared_name(name);
+
+    if (!stringv_share(&s, name, STRINGV_SAVE_INDEX)
+            || !stringv_open_shared(&file, name)) {
+        (void)shm_unlink(name);
+        return 0;
+    }
+
+    result = file.stringv.string_count == 3
+        && file.stringv.block_used == 4
+        && file.index[1] == 1
+        && file.lengths[1] == 7
+        && strcmp(stringv_get(&file.stringv, 1), "BBBBBBB") == 0
+        && strcmp(stringv_get(&file.stringv, 2), "CC") == 0;
+
+    return stringv_close_mapped(&file) && shm_unlink(name) == 0 && result;
+}
+
+/* An existing object is neither overwritten nor removed */
+int test_shared_exists(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[64] = {0};
+    char name[32];
+    int result = 0;
+
+    fill(&s, b, 64);
+    shared_name(name);
+    assert(stringv_share(&s, name, 0));
+    assert(stringv_push_back(&s, "D", 1));
+
+    result = !stringv_share(&s, name, 0)
+        && stringv_open_shared(&file, name)
+        && file.stringv.string_count == 3
+        && stringv_close_mapped(&file);
+
+    return shm_unlink(name) == 0 && result;
+}
+
+/* Every mapping of an object sees the same pages, at its own address */
+int test_shared_one_copy(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file first, second;
+    char b[64] = {0};
+    char name[32];
+    char *writable = NULL;
+    int fd = -1, result = 0;
+
+    fill(&s, b, 64);
+    shared_name(name);
+    assert(stringv_share(&s, name, 0));
+    assert(stringv_open_shared(&first, name));
+    assert(stringv_open_shared(&second, name));
+
+    /* Change the object through a separate writable mapping */
+    fd = shm_open(name, O_RDWR, 0);
+    assert(fd >= 0);
+    writable = mmap(NULL, first.map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            fd, 0);
+    assert(writable != MAP_FAILED);
+    (void)close(fd);
+    writable[first.stringv.buf - (char *)first.map] = 'Z';
+
+    result = first.map != second.map
+        && strcmp(stringv_get(&first.stringv, 0), "Z") == 0
+        && strcmp(stringv_get(&second.stringv, 0), "Z") == 0;
+
+    assert(munmap(writable, first.map_size) == 0);
+    return stringv_close_mapped(&first)
+        && stringv_close_mapped(&second)
+        && shm_unlink(name) == 0
+        && result;
+}
+
+/* Any descriptor can hold an image, such as one of a temporary file */
+int test_shared_fd(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[64] = {0};
+    char path[] = "/tmp/test_shared_XXXXXX";
+    int fd = -1, result = 0;
+
+    fill(&s, b, 64);
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    assert(unlink(path) == 0);
+
+    result = stringv_save_fd(&s, fd, 0)
+        && stringv_map_shared(&file, fd)
+        && strcmp(stringv_get(&file.stringv, 2), "CC") == 0
+        && stringv_close_mapped(&file);
+
+    return close(fd) == 0 && result;
+}
+
+/* A child process maps the object its parent shared */
+int test_shared_processes(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_file file;
+    char b[64] = {0};
+    char name[32];
+    pid_t child = 0;
+    int status = 0;
+
+    fill(&s, b, 64);
+    shared_name(name);
+    assert(stringv_share(&s, name, 0));
+
+    child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        _exit(stringv_open_shared(&file, name)
+                && strcmp(stringv_get(&file.stringv, 1), "BBBBBBB") == 0
+                && stringv_close_mapped(&file) ? 0 : 1);
+    }
+
+    assert(waitpid(child, &status, 0) == child);
+    return shm_unlink(name) == 0
+        && WIFEXITED(status)
+        && WEXITSTATUS(status) == 0;
+}
@@ -0,0 +1,437 @@
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+#define BUF_SIZE    256
+#define BLOCK_SIZE  8
+#define CHUNK_SIZE  16
+#define CHUNKS      (BUF_SIZE / CHUNK_SIZE)
+
+/* Arguments for a thread copying a snapshot */
+struct reader {
+    struct stringv_snapshot *snapshot;
+    int result;
+};
+
+/* A modification applied to a snapshotted stringv */
+typedef void (*mutation)(struct stringv *);
+
+static void fill(struct stringv *s, char *buf);
+static int matches_original(struct stringv_snapshot *snapshot);
+static int select_odd(char const *string, void *context);
+static void *copy_snapshot(void *arg);
+
+static void mutate_clear(struct stringv *s);
+static void mutate_insert(struct stringv *s);
+static void mutate_replace(struct stringv *s);
+static void mutate_remove(struct stringv *s);
+static void mutate_tombstone(struct stringv *s);
+static void mutate_swap(struct stringv *s);
+static void mutate_rotate(struct stringv *s);
+static void mutate_reverse(struct stringv *s);
+static void mutate_partition(struct stringv *s);
+static void mutate_regrow(struct stringv *s);
+
+static int test_snapshot_params_bad(void);
+static int test_snapshot_empty(void);
+static int test_snapshot_unchanged(void);
+static int test_snapshot_push_back(void);
+static int test_snapshot_one_chunk(void);
+static int test_snapshot_mutations(void);
+static int test_snapshot_store_full(void);
+static int test_snapshot_release(void);
+static int test_snapshot_concurrent(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_snapshot_params_bad),
+    TEST_CASE(test_snapshot_empty),
+    TEST_CASE(test_snapshot_unchanged),
+    TEST_CASE(test_snapshot_push_back),
+    TEST_CASE(test_snapshot_one_chunk),
+    TEST_CASE(test_snapshot_mutations),
+    TEST_CASE(test_snapshot_store_full),
+    TEST_CASE(test_snapshot_release),
+    TEST_CASE(test_snapshot_concurrent)
+};
+
+/* The strings stored by fill, some spanning several blocks */
+static char const *const strings[] = {
+    "alpha", "bravo", "charlie-delta", "echo", "foxtrot-golf-hotel", "india",
+    "juliet", "kilo-lima", "mike", "november-oscar", "papa", "quebec"
+};
+
+#define STRING_COUNT ((int)(sizeof(strings) / sizeof(strings[0])))
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+/* Initialises a stringv and stores every string in it */
+void fill(struct stringv *s, char *buf)
+{
+    int i = 0;
+
+    assert(stringv_init(s, buf, BUF_SIZE, BLOCK_SIZE));
+    for (i = 0; i < STRING_COUNT; ++i) {
+        assert(stringv_push_back(s, strings[i], strlen(strings[i])));
+    }
+}
+
+/* Checks that a snapshot taken of a stringv made by fill still holds every
+ * string, in order */
+int matches_original(struct stringv_snapshot *snapshot)
+{
+    struct stringv copy;
+    char buf[BUF_SIZE + 1] = {0};
+    int i = 0;
+
+    assert(stringv_init(&copy, buf, BUF_SIZE, BLOCK_SIZE));
+
+    if (stringv_snapshot_copy(&copy, snapshot) != STRING_COUNT) {
+        return 0;
+    }
+
+    for (i = 0; i < STRING_COUNT; ++i) {
+        if (strcmp(stringv_get(&copy, i), strings[i]) != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int select_odd(char const *string, void *context)
+{
+    (void)context;
+    return strlen(string) % 2;
+}
+
+void *copy_snapshot(void *arg)
+{
+    struct reader *r = arg;
+    int i = 0;
+
+    for (i = 0; i < 100; ++i) {
+        r->result = r->result && matches_original(r->snapshot);
+    }
+
+    return NULL;
+}
+
+void mutate_clear(struct stringv *s)
+{
+    assert(stringv_clear(s));
+}
+
+void mutate_insert(struct stringv *s)
+{
+    assert(stringv_insert(s, "zulu-zulu-zulu", 14, 3));
+}
+
+void mutate_replace(struct stringv *s)
+{
+    assert(stringv_replace(s, 2, "x", 1));
+    assert(stringv_replace(s, 5, "whiskey-x-ray-yankee", 20));
+}
+
+void mutate_remove(struct stringv *s)
+{
+    assert(stringv_remove(s, 0));
+    assert(stringv_remove(s, s->string_count - 1));
+}
+
+/* Tombstones enough strings to trigger compaction */
+void mutate_tombstone(struct stringv *s)
+{
+    int i = 0;
+
+    for (i = 0; i < STRING_COUNT / 2 + 1; ++i) {
+        assert(stringv_tombstone(s, 1));
+    }
+}
+
+void mutate_swap(struct stringv *s)
+{
+    assert(stringv_swap(s, 1, 4));
+    assert(stringv_swap(s, 0, 11));
+}
+
+void mutate_rotate(struct stringv *s)
+{
+    assert(stringv_rotate(s, 5));
+}
+
+void mutate_reverse(struct stringv *s)
+{
+    assert(stringv_reverse(s));
+}
+
+void mutate_partition(struct stringv *s)
+{
+    assert(stringv_stable_partition(s, select_odd, NULL) >= 0);
+}
+
+/* Shrinks the stringv, then grows it back over the snapshotted blocks */
+void mutate_regrow(struct stringv *s)
+{
+    struct stringv other;
+    char buf[BUF_SIZE + 1] = {0};
+
+    assert(stringv_init(&other, buf, BUF_SIZE, BLOCK_SIZE));
+    assert(stringv_push_back(&other, "sierra", 6));
+    assert(stringv_push_back(&other, "tango-uniform-victor", 20));
+
+    assert(stringv_clear(s));
+    assert(stringv_push_back(s, "romeo", 5));
+    assert(stringv_append(s, &other) == 2);
+}
+
+int test_snapshot_params_bad(void)
+{
+    struct stringv s;
+    struct stringv_snapshot snapshot, other;
+    int map[CHUNKS];
+    char b[BUF_SIZE + 1] = {0};
+    char store[CHUNK_SIZE];
+
+    fill(&s, b);
+
+    if (stringv_snapshot_take(NULL, &s, CHUNK_SIZE, map, CHUNKS, NULL, 0)
+            || stringv_snapshot_take(&snapshot, NULL, CHUNK_SIZE, map, CHUNKS,
+                NULL, 0)
+            || stringv_snapshot_take(&snapshot, &s, 0, map, CHUNKS, NULL, 0)
+            || stringv_snapshot_take(&snapshot, &s, CHUNK_SIZE, NULL, CHUNKS,
+                NULL, 0)
+            || stringv_snapshot_take(&snapshot, &s, CHUNK_SIZE, map, CHUNKS,
+                NULL, CHUNK_SIZE)
+            || stringv_snapshot_take(&snapshot, &s, CHUNK_SIZE, map, 2,
+                NULL, 0)) {
+        return 0;
+    }
+
+    assert(stringv_snapshot_take(
+                &snapshot, &s, CHUNK_SIZE, map, CHUNKS, store, CHUNK_SIZE));
+
+    /* Only one snapshot at a time */
+    return !stringv_snapshot_take(&other, &s, CHUNK_SIZE, map, CHUNKS, NULL, 0)
+        && stringv_snapshot_read(NULL, 0, store) == -1
+        && stringv_snapshot_read(&snapshot, -1, store) == -1
+        && stringv_snapshot_read(&snapshot, snapshot.chunk_count, store) == -1
+        && stringv_snapshot_read(&snapshot, 0, NULL) == -1
+        && stringv_snapshot_copy(NULL, &snapshot) == -1
+        && stringv_snapshot_copy(&s, &snapshot) == -1
+        && stringv_snapshot_copy(&s, NULL) == -1;
+}
+
+int test_snapshot_empty(void)
+{
+    struct stringv s, copy;
+    struct stringv_snapshot snapshot;
+    int map[1];
+    char b[BUF_SIZE + 1] = {0};
+    char c[BUF_SIZE + 1] = {0};
+
+    assert(stringv_init(&s, b, BUF_SIZE, BLOCK_SIZE));
+    assert(stringv_init(&copy, c, BUF_SIZE, BLOCK_SIZE));
+    assert(stringv_push_back(&copy, "stale", 5));
+    assert(stringv_snapshot_take(
+                &snapshot, &s, CHUNK_SIZE, map, 0, NULL, 0));
+    assert(stringv_push_back(&s, "alpha", 5));
+
+    return snapshot.chunk_count == 0
+        && stringv_snapshot_copy(&copy, &snapshot) == 0
+        && copy.block_used == 0
+        && c[0] == '\0';
+}
+
+int test_snapshot_unchanged(void)
+{
+    struct stringv s;
+    struct stringv_snapshot snapshot;
+    int map[CHUNKS];
+    char b[BUF_SIZE + 1] = {0};
+    char out[CHUNK_SIZE];
+
+    fill(&s, b);
+    assert(stringv_snapshot_take(
+                &snapshot, &s, CHUNK_SIZE, map, CHUNKS, NULL, 0));
+
+    return s.snapshot == &snapshot
+        && snapshot.chunk_count == (s.block_used * BLOCK_SIZE + CHUNK_SIZE - 1)
+            / CHUNK_SIZE
+        && stringv_snapshot_read(&snapshot, 0, out) == CHUNK_SIZE
+        && memcmp(out, b, CHUNK_SIZE) == 0
+        && matches_original(&snapshot);
+}
+
+/* Appending touches no snapshotted chunk */
+int test_snapshot_push_back(void)
+{
+    struct stringv s;
+    struct stringv_snapshot snapshot;
+    int map[CHUNKS];
+    char b[BUF_SIZE + 1] = {0};
+
+    fill(&s, b);
+    assert(stringv_snapshot_take(
+                &snapshot, &s, CHUNK_SIZE, map, CHUNKS, NULL, 0));
+    assert(stringv_push_back(&s, "romeo", 5));
+    assert(stringv_push_back(&s, "sierra-tango", 12));
+
+    return snapshot.store_used == 0
+        && snapshot.lost_count == 0
+        && matches_original(&snapshot)
+        && s.string_count == STRING_COUNT + 2;
+}
+
+/* Only the chunks that are modified are copied */
+int test_snapshot_one_chunk(void)
+{
+    struct stringv s;
+    struct stringv_snapshot snapshot;
+    int map[CHUNKS];
+    char b[BUF_SIZE + 1] = {0};
+    char store[CHUNKS * CHUNK_SIZE];
+
+    fill(&s, b);
+    assert(stringv_snapshot_take(
+                &snapshot, &s, CHUNK_SIZE, map, CHUNKS, store, sizeof(store)));
+
+    /* "bravo" is in the second block, so the first chunk */
+    assert(stringv_replace(&s, 1, "BRAVO", 5));
+    assert(stringv_replace(&s, 1, "Bravo", 5));
+
+    return snapshot.store_used == 1
+        && map[0] == 0
+        && map[1] < 0
+        && strcmp(stringv_get(&s, 1), "Bravo") == 0
+        && matches_original(&snapshot);
+}
+
+/* Every modifying function preserves the chunks it touches */
+int test_snapshot_mutations(void)
+{
+    static mutation const mutations[] = {
+        mutate_clear,
+        mutate_insert,
+        mutate_replace,
+        mutate_remove,
+        mutate_tombstone,
+        mutate_swap,
+        mutate_rotate,
+        mutate_reverse,
+        mutate_partition,
+        mutate_regrow
+    };
+    struct stringv s;
+    struct stringv_snapshot snapshot;
+    int map[CHUNKS];
+    char b[BUF_SIZE + 1] = {0};
+    char store[CHUNKS * CHUNK_SIZE];
+    size_t i = 0;
+
+    for (i = 0; i < sizeof(mutations) / sizeof(mutations[0]); ++i) {
+        fill(&s, b);
+        assert(stringv_snapshot_take(
+                    &snapshot, &s, CHUNK_SIZE, map, CHUNKS,
+                    store, sizeof(store)));
+
+        mutations[i](&s);
+
+        if (snapshot.lost_count != 0 || !matches_original(&snapshot)) {
+            return 0;
+        }
+
+        stringv_snapshot_release(&snapshot);
+    }
+
+    return 1;
+}
+
+/* Chunks modified once the store is full are lost */
+int test_snapshot_store_full(void)
+{
+    struct stringv s, copy;
+    struct stringv_snapshot snapshot;
+    int map[CHUNKS];
+    char b[BUF_SIZE + 1] = {0};
+    char c[BUF_SIZE + 1] = {0};
+    char store[CHUNK_SIZE];
+    char out[CHUNK_SIZE];
+
+    fill(&s, b);
+    assert(stringv_init(&copy, c, BUF_SIZE, BLOCK_SIZE));
+    assert(stringv_snapshot_take(
+                &snapshot, &s, CHUNK_SIZE, map, CHUNKS, store, sizeof(store)));
+
+    /* The first replacement fills the store */
+    assert(stringv_replace(&s, 0, "ALPHA", 5));
+    assert(stringv_replace(&s, 3, "ECHO", 4));
+
+    return snapshot.store_used == 1
+        && snapshot.lost_count == 1
+        && stringv_snapshot_read(&snapshot, 0, out) == CHUNK_SIZE
+        && strcmp(out, "alpha") == 0
+        && stringv_snapshot_read(&snapshot, 2, out) == -1
+        && stringv_snapshot_read(&snapshot, 3, out) == CHUNK_SIZE
+        && stringv_snapshot_copy(&copy, &snapshot) == -1
+        && copy.block_used == 0
+        && c[0] == '\0';
+}
+
+int test_snapshot_release(void)
+{
+    struct stringv s;
+    struct stringv_snapshot snapshot;
+    int map[CHUNKS];
+    char b[BUF_SIZE + 1] = {0};
+    char out[CHUNK_SIZE];
+
+    fill(&s, b);
+    assert(stringv_snapshot_take(
+                &snapshot, &s, CHUNK_SIZE, map, CHUNKS, NULL, 0));
+    stringv_snapshot_release(&snapshot);
+    assert(stringv_replace(&s, 0, "ALPHA", 5));
+
+    return s.snapshot == NULL
+        && snapshot.lost_count == 0
+        && stringv_snapshot_read(&snapshot, 0, out) == -1
+        && stringv_snapshot_take(
+                &snapshot, &s, CHUNK_SIZE, map, CHUNKS, NULL, 0) == &snapshot;
+}
+
+/* A snapshot can be copied while the stringv is being modified */
+int test_snapshot_concurrent(void)
+{
+    struct stringv s;
+    struct stringv_snapshot snapshot;
+    struct reader reader;
+    pthread_t thread;
+    int map[CHUNKS];
+    char b[BUF_SIZE + 1] = {0};
+    char store[CHUNKS * CHUNK_SIZE];
+    int i = 0;
+
+    fill(&s, b);
+    assert(stringv_snapshot_take(
+                &snapshot, &s, CHUNK_SIZE, map, CHUNKS, store, sizeof(store)));
+
+    reader.snapshot = &snapshot;
+    reader.result = 1;
+    assert(pthread_create(&thread, NULL, copy_snapshot, &reader) == 0);
+
+    for (i = 0; i < 100; ++i) {
+        mutate_reverse(&s);
+        mutate_swap(&s);
+        mutate_rotate(&s);
+    }
+
+    assert(pthread_join(thread, NULL) == 0);
+    stringv_snapshot_release(&snapshot);
+
+    return reader.result && snapshot.lost_count == 0;
+}
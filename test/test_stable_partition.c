@@ -0,0 +1,111 @@
+#include <assert.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+static int starts_with(char const *string, void *context);
+
+static int test_partition_params_bad(void);
+static int test_partition_one_to_one(void);
+static int test_partition_multi_block(void);
+static int test_partition_tombstones(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_partition_params_bad),
+    TEST_CASE(test_partition_one_to_one),
+    TEST_CASE(test_partition_multi_block),
+    TEST_CASE(test_partition_tombstones)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+/* Selects strings starting with the char pointed to by context */
+int starts_with(char const *string, void *context)
+{
+    return *string == *(char const *)context;
+}
+
+int test_partition_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[12] = {0};
+
+    assert(stringv_init(&s, b, 12, 4));
+
+    return stringv_stable_partition(NULL, starts_with, NULL) == -1
+        && stringv_stable_partition(&s, NULL, NULL) == -1
+        && stringv_stable_partition(&s, starts_with, NULL) == 0;
+}
+
+int test_partition_one_to_one(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[24] = {0};
+    char x = 'x';
+
+    assert(stringv_init(&s, b, 24, 4));
+    assert(stringv_push_back(&s, "a1", 2));
+    assert(stringv_push_back(&s, "x1", 2));
+    assert(stringv_push_back(&s, "a2", 2));
+    assert(stringv_push_back(&s, "a3", 2));
+    assert(stringv_push_back(&s, "x2", 2));
+    assert(stringv_push_back(&s, "x3", 2));
+
+    return stringv_stable_partition(&s, starts_with, &x) == 3
+        && memcmp(b, "x1\0\0x2\0\0x3\0\0a1\0\0a2\0\0a3\0\0", 24) == 0;
+}
+
+int test_partition_multi_block(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[48] = {0};
+    char const *const strings[] = {
+        "xx", "xxxxxxxx", "xxxxx", "aaaaaaa", "a", "aaaa"
+    };
+    char x = 'x';
+    int i = 0;
+
+    assert(stringv_init(&s, b, 48, 4));
+    assert(stringv_push_back(&s, "aaaaaaa", 7));
+    assert(stringv_push_back(&s, "xx", 2));
+    assert(stringv_push_back(&s, "a", 1));
+    assert(stringv_push_back(&s, "xxxxxxxx", 8));
+    assert(stringv_push_back(&s, "aaaa", 4));
+    assert(stringv_push_back(&s, "xxxxx", 5));
+
+    if (stringv_stable_partition(&s, starts_with, &x) != 3) {
+        return 0;
+    }
+
+    for (i = 0; i < 6; ++i) {
+        if (strcmp(stringv_get(&s, i), strings[i]) != 0) {
+            return 0;
+        }
+    }
+
+    return s.string_count == 6;
+}
+
+int test_partition_tombstones(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[24] = {0};
+    char x = 'x';
+
+    assert(stringv_init(&s, b, 24, 4));
+    assert(stringv_push_back(&s, "a1", 2));
+    assert(stringv_push_back(&s, "x1", 2));
+    assert(stringv_push_back(&s, "x2", 2));
+    assert(stringv_push_back(&s, "a2", 2));
+    assert(stringv_tombstone(&s, 1));
+
+    return stringv_stable_partition(&s, starts_with, &x) == 1
+        && strcmp(stringv_get(&s, 0), "x2") == 0
+        && strcmp(stringv_get(&s, 1), "a1") == 0
+        && strcmp(stringv_get(&s, 2), "a2") == 0
+        && !stringv_get(&s, 3);
+}
@@ -0,0 +1,101 @@
+#include <assert.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+static int test_swap_params_bad(void);
+static int test_swap_one_to_one(void);
+static int test_swap_same_span(void);
+static int test_swap_different_span(void);
+static int test_swap_adjacent(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_swap_params_bad),
+    TEST_CASE(test_swap_one_to_one),
+    TEST_CASE(test_swap_same_span),
+    TEST_CASE(test_swap_different_span),
+    TEST_CASE(test_swap_adjacent)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int test_swap_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[12] = {0};
+
+    assert(stringv_init(&s, b, 12, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+
+    return !stringv_swap(NULL, 0, 0)
+        && !stringv_swap(&s, -1, 0)
+        && !stringv_swap(&s, 0, 1)
+        && stringv_swap(&s, 0, 0);
+}
+
+int test_swap_one_to_one(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[48] = {0};
+
+    assert(stringv_init(&s, b, 48, 16));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBBBBBBBBB", 10));
+    assert(stringv_push_back(&s, "CC", 2));
+
+    return stringv_swap(&s, 2, 0)
+        && strcmp(stringv_get(&s, 0), "CC") == 0
+        && strcmp(stringv_get(&s, 1), "BBBBBBBBBB") == 0
+        && strcmp(stringv_get(&s, 2), "AAA") == 0
+        && b[3] == '\0' && b[35] == '\0';
+}
+
+int test_swap_same_span(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[24] = {0};
+
+    assert(stringv_init(&s, b, 24, 4));
+    assert(stringv_push_back(&s, "AAAAA", 5));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCCCCC", 6));
+
+    return stringv_swap(&s, 0, 2)
+        && memcmp(b, "CCCCCC\0\0BBB\0AAAAA\0\0\0\0\0\0\0", 24) == 0;
+}
+
+int test_swap_different_span(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[32] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCCCCCCCCC", 10));
+    assert(stringv_push_back(&s, "DDD", 3));
+
+    return stringv_swap(&s, 0, 2)
+        && s.block_used == 6
+        && strcmp(stringv_get(&s, 0), "CCCCCCCCCC") == 0
+        && strcmp(stringv_get(&s, 1), "BBB") == 0
+        && strcmp(stringv_get(&s, 2), "AAA") == 0
+        && strcmp(stringv_get(&s, 3), "DDD") == 0;
+}
+
+int test_swap_adjacent(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[24] = {0};
+
+    assert(stringv_init(&s, b, 24, 4));
+    assert(stringv_push_back(&s, "AAAAAAAA", 8));
+    assert(stringv_push_back(&s, "BBB", 3));
+
+    return stringv_swap(&s, 1, 0)
+        && memcmp(b, "BBB\0AAAAAAAA\0\0\0\0", 16) == 0;
+}
@@ -0,0 +1,307 @@
+#include <assert.h>
+#include <string.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+static int test_tombstone_params_bad(void);
+static int test_tombstone_get_skips(void);
+static int test_tombstone_iteration_skips(void);
+static int test_tombstone_last(void);
+static int test_tombstone_multi_block(void);
+static int test_tombstone_zeroes(void);
+static int test_tombstone_nul_string(void);
+static int test_tombstone_auto_compact(void);
+static int test_tombstone_compact(void);
+static int test_tombstone_compact_multi(void);
+static int test_tombstone_stats(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_tombstone_params_bad),
+    TEST_CASE(test_tombstone_get_skips),
+    TEST_CASE(test_tombstone_iteration_skips),
+    TEST_CASE(test_tombstone_last),
+    TEST_CASE(test_tombstone_multi_block),
+    TEST_CASE(test_tombstone_zeroes),
+    TEST_CASE(test_tombstone_nul_string),
+    TEST_CASE(test_tombstone_auto_compact),
+    TEST_CASE(test_tombstone_compact),
+    TEST_CASE(test_tombstone_compact_multi),
+    TEST_CASE(test_tombstone_stats)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int test_tombstone_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+
+    return !stringv_tombstone(NULL, 0)
+        && !stringv_tombstone(&s, -1)
+        && !stringv_tombstone(&s, 1)
+        && !stringv_compact(NULL)
+        && !stringv_get_stats(&s, NULL);
+}
+
+/* Tests that tombstoned strings are invisible to stringv_get, and that the
+ * remaining strings don't move */
+int test_tombstone_get_skips(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[20] = {0};
+    char const *c = NULL;
+
+    assert(stringv_init(&s, b, 20, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    c = stringv_push_back(&s, "CCC", 3);
+    assert(stringv_push_back(&s, "DDD", 3));
+    assert(stringv_push_back(&s, "EEE", 3));
+
+    return stringv_tombstone(&s, 1)
+        && s.dead_count == 1
+        && s.string_count == 5
+        && s.block_used == 5
+        && strcmp(stringv_get(&s, 0), "AAA") == 0
+        && stringv_get(&s, 1) == c
+        && strcmp(stringv_get(&s, 2), "DDD") == 0
+        && strcmp(stringv_get(&s, 3), "EEE") == 0
+        && !stringv_get(&s, 4);
+}
+
+int test_tombstone_iteration_skips(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[24] = {0};
+    char const *const strings[] = {"BBB", "DDD", "FFF"};
+    char const *it = NULL;
+    int i = 0;
+
+    assert(stringv_init(&s, b, 24, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCC", 3));
+    assert(stringv_push_back(&s, "DDD", 3));
+    assert(stringv_push_back(&s, "EEE", 3));
+    assert(stringv_push_back(&s, "FFF", 3));
+
+    /* Leave tombstones at the front and in a run in the middle. The string
+     * count stays high enough to avoid automatic compaction. */
+    assert(stringv_tombstone(&s, 0));
+    assert(stringv_tombstone(&s, 1));
+    assert(stringv_tombstone(&s, 2));
+    assert(s.dead_count == 3);
+
+    for (it = stringv_begin(&s);
+            it != stringv_end(&s);
+            ++i, it = stringv_next(&s, it)) {
+        if (i >= 3 || strcmp(strings[i], it) != 0) {
+            return 0;
+        }
+    }
+
+    return i == 3;
+}
+
+/* Tombstoning the last string removes it outright */
+int test_tombstone_last(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[12] = {0};
+
+    assert(stringv_init(&s, b, 12, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+
+    return stringv_tombstone(&s, 1)
+        && s.dead_count == 0
+        && s.string_count == 1
+        && s.block_used == 1
+        && b[4] == '\0';
+}
+
+int test_tombstone_multi_block(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[32] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBBBBBB", 7));
+    assert(stringv_push_back(&s, "CCC", 3));
+    assert(stringv_push_back(&s, "DDDDDD", 6));
+
+    return stringv_tombstone(&s, 1)
+        && strcmp(stringv_get(&s, 0), "AAA") == 0
+        && strcmp(stringv_get(&s, 1), "CCC") == 0
+        && strcmp(stringv_get(&s, 2), "DDDDDD") == 0
+        && stringv_next(&s, stringv_begin(&s)) == stringv_get(&s, 1);
+}
+
+/* A dead string leaves no chars behind but the last char of each of its
+ * non-terminal blocks */
+int test_tombstone_zeroes(void)
+{
+    static char const zero[8] = {0};
+    struct stringv s = STRINGV_ZERO;
+    char b[33] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBBBBBBBB", 9));
+    assert(stringv_push_back(&s, "CCC", 3));
+    assert(stringv_tombstone(&s, 1));
+
+    if (memcmp(b + 4, zero, 3) != 0
+            || b[7] != 'B'
+            || memcmp(b + 8, zero, 3) != 0
+            || b[11] != 'B'
+            || memcmp(b + 12, zero, 4) != 0
+            || strcmp(stringv_get(&s, 1), "CCC") != 0) {
+        return 0;
+    }
+
+    /* And in a one-to-one stringv, nothing at all */
+    assert(stringv_init(&s, b, 32, 8));
+    assert(stringv_push_back(&s, "AAAAAAA", 7));
+    assert(stringv_push_back(&s, "BBBBBBB", 7));
+    assert(stringv_push_back(&s, "CCCCCCC", 7));
+    return stringv_tombstone(&s, 0)
+        && memcmp(b, zero, 8) == 0
+        && strcmp(stringv_get(&s, 0), "BBBBBBB") == 0;
+}
+
+/* A string starting with NUL would read as a tombstone, and one with a NUL
+ * elsewhere could end early, so no function writes either */
+int test_tombstone_nul_string(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[33] = {0};
+    char const *iter = NULL;
+    int count = 0;
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    if (stringv_push_back(&s, "\0BC", 3)
+            || stringv_push_back(&s, "B\0C", 3)
+            || stringv_push_front(&s, "\0BC", 3)
+            || stringv_insert(&s, "\0BC", 3, 1)
+            || stringv_replace(&s, 0, "\0BC", 3)
+            || stringv_replace(&s, 0, "ABC\0DEF", 7)) {
+        return 0;
+    }
+
+    assert(stringv_push_back(&s, "DDD", 3));
+    assert(stringv_push_back(&s, "EEE", 3));
+    assert(stringv_tombstone(&s, 0));
+
+    for (iter = stringv_begin(&s); iter != stringv_end(&s);
+            iter = stringv_next(&s, iter)) {
+        ++count;
+    }
+
+    return s.string_count - s.dead_count == 2
+        && count == 2
+        && strcmp(stringv_get(&s, 0), "DDD") == 0
+        && strcmp(stringv_get(&s, 1), "EEE") == 0
+        && stringv_get(&s, 2) == NULL;
+}
+
+/* Once more than half of the strings are dead, the stringv is compacted */
+int test_tombstone_auto_compact(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCC", 3));
+    assert(stringv_push_back(&s, "DDD", 3));
+
+    assert(stringv_tombstone(&s, 0));
+    assert(stringv_tombstone(&s, 0));
+    assert(s.dead_count == 2);
+
+    return stringv_tombstone(&s, 0)
+        && s.dead_count == 0
+        && s.string_count == 1
+        && s.block_used == 1
+        && memcmp(b, "DDD\0\0\0\0\0\0\0\0\0\0\0\0\0", 16) == 0;
+}
+
+int test_tombstone_compact(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[24] = {0};
+
+    assert(stringv_init(&s, b, 24, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCC", 3));
+    assert(stringv_push_back(&s, "DDD", 3));
+    assert(stringv_push_back(&s, "EEE", 3));
+    assert(stringv_push_back(&s, "FFF", 3));
+
+    assert(stringv_tombstone(&s, 1));
+    assert(stringv_tombstone(&s, 2));
+
+    return stringv_compact(&s) == 2
+        && s.dead_count == 0
+        && s.string_count == 4
+        && s.block_used == 4
+        && memcmp(b, "AAA\0CCC\0EEE\0FFF\0\0\0\0\0\0\0\0\0", 24) == 0
+        && stringv_compact(&s) == 0;
+}
+
+int test_tombstone_compact_multi(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[40] = {0};
+
+    assert(stringv_init(&s, b, 40, 4));
+    assert(stringv_push_back(&s, "AAAAA", 5));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCCCCCCC", 8));
+    assert(stringv_push_back(&s, "DDD", 3));
+    assert(stringv_push_back(&s, "EEEEEE", 6));
+
+    assert(stringv_tombstone(&s, 0));
+    assert(stringv_tombstone(&s, 1));
+
+    return stringv_compact(&s) == 5
+        && s.string_count == 3
+        && s.block_used == 4
+        && strcmp(stringv_get(&s, 0), "BBB") == 0
+        && strcmp(stringv_get(&s, 1), "DDD") == 0
+        && strcmp(stringv_get(&s, 2), "EEEEEE") == 0
+        && b[16] == '\0';
+}
+
+int test_tombstone_stats(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct stringv_stats stats;
+    char b[40] = {0};
+
+    assert(stringv_init(&s, b, 40, 4));
+    assert(stringv_push_back(&s, "AAAAA", 5));
+    assert(stringv_push_back(&s, "BBB", 3));
+    assert(stringv_push_back(&s, "CCCCCCCC", 8));
+    assert(stringv_push_back(&s, "DDD", 3));
+    assert(stringv_tombstone(&s, 0));
+
+    return stringv_get_stats(&s, &stats) == &stats
+        && stats.live_count == 3
+        && stats.dead_count == 1
+        && stats.dead_blocks == 2
+        && stats.live_blocks == 5
+        && stats.free_blocks == 3;
+}
@@ -0,0 +1,326 @@
+#include <assert.h>
+#include <pthread.h>
+
+#include "test.h"
+#include "../stringv.h"
+
+/* These tests are linked with a stringv module compiled with STRINGV_TRACE
+ * defined */
+
+#define MAX_EVENTS 16
+
+/* The threads, and pushes by each, of test_trace_swap_hook */
+#define SWAP_THREADS 4
+#define SWAP_PUSHES 2000
+
+/* The events recorded by record_event */
+struct events {
+    struct stringv_trace_event events[MAX_EVENTS];
+    int count;
+};
+
+/* Trace hook appending each event to the struct events given as context */
+static void record_event(struct stringv_trace_event const *event, void *e);
+
+/* The contexts of the two hooks swapped by test_trace_swap_hook. Each hook
+ * counts the events given its own context, and the events given the other's
+ * as mismatches. */
+static int swap_contexts[2];
+static int swap_counts[2];
+static int swap_mismatches;
+
+/* The hooks swapped by test_trace_swap_hook */
+static void swap_hook_a(struct stringv_trace_event const *event, void *c);
+static void swap_hook_b(struct stringv_trace_event const *event, void *c);
+
+/* Pushes SWAP_PUSHES strings onto a stringv of its own */
+static void *swap_pusher(void *arg);
+
+/* Checks that an event has the given fields */
+static void swap_hook_a(struct stringv_trace_event const *event, void *c)
+{
+    (void)event;
+    __atomic_add_fetch(c == &swap_contexts[0] ? &swap_counts[0]
+            : &swap_mismatches, 1, __ATOMIC_RELAXED);
+}
+
+void swap_hook_b(struct stringv_trace_event const *event, void *c)
+{
+    (void)event;
+    __atomic_add_fetch(c == &swap_contexts[1] ? &swap_counts[1]
+            : &swap_mismatches, 1, __ATOMIC_RELAXED);
+}
+
+void *swap_pusher(void *arg)
+{
+    struct stringv s = STRINGV_ZERO;
+    char *const b = arg;
+    int i = 0;
+
+    for (i = 0; i < SWAP_PUSHES; ++i) {
+        if (i % 16 == 0) {
+            assert(stringv_init(&s, b, 64, 4));
+        }
+        assert(stringv_push_back(&s, "AAA", 3));
+    }
+
+    return NULL;
+}
+
+int check_event(
+        struct stringv_trace_event const *event,
+        enum stringv_trace_op op,
+        int exit,
+        struct stringv const *s,
+        size_t size,
+        string_pos position,
+        long result);
+
+static int test_trace_set_hook(void);
+static int test_trace_entry_exit(void);
+static int test_trace_failure(void);
+static int test_trace_nested(void);
+static int test_trace_split(void);
+static int test_trace_lookups(void);
+static int test_trace_no_hook(void);
+static int test_trace_time(void);
+static int test_trace_swap_hook(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_trace_set_hook),
+    TEST_CASE(test_trace_entry_exit),
+    TEST_CASE(test_trace_failure),
+    TEST_CASE(test_trace_nested),
+    TEST_CASE(test_trace_split),
+    TEST_CASE(test_trace_lookups),
+    TEST_CASE(test_trace_no_hook),
+    TEST_CASE(test_trace_time),
+    TEST_CASE(test_trace_swap_hook)
+};
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+void record_event(struct stringv_trace_event const *event, void *e)
+{
+    struct events *const events = e;
+
+    if (events->count < MAX_EVENTS) {
+        events->events[events->count] = *event;
+    }
+
+    ++events->count;
+}
+
+int check_event(
+        struct stringv_trace_event const *event,
+        enum stringv_trace_op op,
+        int exit,
+        struct stringv const *s,
+        size_t size,
+        string_pos position,
+        long result)
+{
+    return event->op == op
+        && event->exit == exit
+        && event->stringv == s
+        && event->size == size
+        && event->position == position
+        && event->result == result;
+}
+
+int test_trace_set_hook(void)
+{
+    struct events e = {{{0}}, 0};
+    int result = 0;
+
+    result = stringv_set_trace_hook(record_event, &e) == NULL
+        && stringv_set_trace_hook(NULL, NULL) == record_event
+        && stringv_set_trace_hook(NULL, NULL) == NULL;
+
+    return result && e.count == 0;
+}
+
+int test_trace_entry_exit(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct events e = {{{0}}, 0};
+    char b[32] = {0};
+    int result = 0;
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+
+    stringv_set_trace_hook(record_event, &e);
+    assert(stringv_insert(&s, "CCC", 3, 1));
+    assert(stringv_remove(&s, 0));
+    stringv_set_trace_hook(NULL, NULL);
+
+    result = e.count == 4
+        && check_event(&e.events[0], STRINGV_TRACE_INSERT, 0, &s, 3, 1, 0)
+        && check_event(&e.events[1], STRINGV_TRACE_INSERT, 1, &s, 3, 1, 1)
+        && check_event(&e.events[2], STRINGV_TRACE_REMOVE, 0, &s, 0, 0, 0)
+        && check_event(&e.events[3], STRINGV_TRACE_REMOVE, 1, &s, 0, 0, 1);
+
+    return result;
+}
+
+int test_trace_failure(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct events e = {{{0}}, 0};
+    char b[8] = {0};
+    int result = 0;
+
+    assert(stringv_init(&s, b, 8, 4));
+    assert(stringv_push_back(&s, "AAA", 3));
+
+    stringv_set_trace_hook(record_event, &e);
+    assert(!stringv_push_back(&s, "BBBBBB", 6));
+    stringv_set_trace_hook(NULL, NULL);
+
+    result = e.count == 2
+        && check_event(&e.events[0], STRINGV_TRACE_PUSH_BACK, 0, &s, 6, -1, 0)
+        && check_event(&e.events[1], STRINGV_TRACE_PUSH_BACK, 1, &s, 6, -1, 0);
+
+    return result;
+}
+
+/* A traced function calling another gives only its own events */
+int test_trace_nested(void)
+{
+    struct stringv s1 = STRINGV_ZERO, s2 = STRINGV_ZERO;
+    struct events e = {{{0}}, 0};
+    char b1[32] = {0}, b2[32] = {0};
+    int result = 0;
+
+    assert(stringv_init(&s1, b1, 32, 4));
+    assert(stringv_init(&s2, b2, 32, 4));
+    assert(stringv_push_back(&s1, "A", 1));
+    assert(stringv_push_back(&s1, "B", 1));
+
+    stringv_set_trace_hook(record_event, &e);
+    assert(stringv_push_front(&s1, "C", 1));
+    assert(stringv_copy(&s2, &s1) == 3);
+    stringv_set_trace_hook(NULL, NULL);
+
+    result = e.count == 4
+        && check_event(&e.events[0], STRINGV_TRACE_PUSH_FRONT, 0, &s1, 1, 0,
+                0)
+        && check_event(&e.events[1], STRINGV_TRACE_PUSH_FRONT, 1, &s1, 1, 0,
+                1)
+        && check_event(&e.events[2], STRINGV_TRACE_COPY, 0, &s2, 12, -1, 0)
+        && check_event(&e.events[3], STRINGV_TRACE_COPY, 1, &s2, 12, -1, 3);
+
+    return result;
+}
+
+int test_trace_split(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct events e = {{{0}}, 0};
+    char b[32] = {0};
+    int result = 0;
+
+    assert(stringv_init(&s, b, 32, 4));
+
+    stringv_set_trace_hook(record_event, &e);
+    assert(stringv_split_c(&s, "A,B,C", 5, ',') == 5);
+    stringv_set_trace_hook(NULL, NULL);
+
+    result = e.count == 2
+        && check_event(&e.events[0], STRINGV_TRACE_SPLIT_C, 0, &s, 5, -1, 0)
+        && check_event(&e.events[1], STRINGV_TRACE_SPLIT_C, 1, &s, 5, -1, 5);
+
+    return result && s.string_count == 3;
+}
+
+int test_trace_lookups(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct events e = {{{0}}, 0};
+    char const *iter = NULL;
+    char b[32] = {0};
+
+    assert(stringv_init(&s, b, 32, 4));
+    assert(stringv_push_back(&s, "A", 1));
+
+    stringv_set_trace_hook(record_event, &e);
+    assert(stringv_get(&s, 0));
+    for (iter = stringv_begin(&s);
+            iter != stringv_end(&s);
+            iter = stringv_next(&s, iter)) {
+        /* Iteration isn't traced */
+    }
+    stringv_set_trace_hook(NULL, NULL);
+
+    return e.count == 0;
+}
+
+int test_trace_no_hook(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[32] = {0};
+
+    assert(stringv_set_trace_hook(NULL, NULL) == NULL);
+    return stringv_init(&s, b, 32, 4) == &s
+        && stringv_push_back(&s, "A", 1) != NULL
+        && s.string_count == 1;
+}
+
+/* Events are timestamped in order, on the monotonic clock */
+int test_trace_time(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    struct events e = {{{0}}, 0};
+    char b[32] = {0};
+    int i = 0;
+
+    assert(stringv_init(&s, b, 32, 4));
+
+    stringv_set_trace_hook(record_event, &e);
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+    stringv_set_trace_hook(NULL, NULL);
+
+    if (e.count != 4 || e.events[0].time == 0) {
+        return 0;
+    }
+
+    for (i = 1; i < 4; ++i) {
+        if (e.events[i].time < e.events[i - 1].time) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* The hook can be changed while other threads are tracing, and each event
+ * reaches a hook along with that hook's own context */
+int test_trace_swap_hook(void)
+{
+    static char bufs[SWAP_THREADS][65];
+    pthread_t ids[SWAP_THREADS];
+    int i = 0, events = 0;
+
+    for (i = 0; i < SWAP_THREADS; ++i) {
+        assert(pthread_create(&ids[i], NULL, swap_pusher, bufs[i]) == 0);
+    }
+
+    for (i = 0; i < 1000; ++i) {
+        stringv_set_trace_hook(swap_hook_a, &swap_contexts[0]);
+        stringv_set_trace_hook(swap_hook_b, &swap_contexts[1]);
+    }
+
+    for (i = 0; i < SWAP_THREADS; ++i) {
+        assert(pthread_join(ids[i], NULL) == 0);
+    }
+    stringv_set_trace_hook(NULL, NULL);
+
+    events = swap_counts[0] + swap_counts[1];
+    return swap_mismatches == 0 && events <= SWAP_THREADS * SWAP_PUSHES * 4;
+}
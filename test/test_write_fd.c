@@ -0,0 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "../stringv_io.h"
+
+#define MANY_STRINGS    3000
+
+/* Writes a stringv to a temporary file and reads the text back into out,
+ * NUL terminated. Returns the result of stringv_write_fd. */
+static int write_and_read(
+        struct stringv const *s,
+        char const *separator,
+        char *out,
+        size_t out_size);
+
+static int test_write_fd_params_bad(void);
+static int test_write_fd_empty(void);
+static int test_write_fd_newlines(void);
+static int test_write_fd_no_separator(void);
+static int test_write_fd_long_separator(void);
+static int test_write_fd_tombstones(void);
+static int test_write_fd_many(void);
+
+static const test_case tests[] = {
+    TEST_CASE(test_write_fd_params_bad),
+    TEST_CASE(test_write_fd_empty),
+    TEST_CASE(test_write_fd_newlines),
+    TEST_CASE(test_write_fd_no_separator),
+    TEST_CASE(test_write_fd_long_separator),
+    TEST_CASE(test_write_fd_tombstones),
+    TEST_CASE(test_write_fd_many)
+};
+
+static char many_buf[MANY_STRINGS * 8 + 1];
+static char many_out[MANY_STRINGS * 8];
+static char many_expected[MANY_STRINGS * 8];
+
+int main(void)
+{
+    return !run_many(tests, TEST_COUNT(tests));
+}
+
+int write_and_read(
+        struct stringv const *s,
+        char const *separator,
+        char *out,
+        size_t out_size)
+{
+    char path[] = "/tmp/test_write_fd_XXXXXX";
+    ssize_t got = 0;
+    size_t total = 0;
+    int fd = -1, written = 0;
+
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    assert(unlink(path) == 0);
+
+    written = stringv_write_fd(s, fd, separator);
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+
+    while ((got = read(fd, out + total, out_size - 1 - total)) > 0) {
+        total += (size_t)got;
+    }
+
+    out[total] = '\0';
+    assert(close(fd) == 0);
+    return written;
+}
+
+int test_write_fd_params_bad(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+
+    assert(stringv_init(&s, b, 16, 4));
+    assert(stringv_push_back(&s, "A", 1));
+
+    return !stringv_write_fd(NULL, 1, "\n")
+        && !stringv_write_fd(&s, -1, "\n");
+}
+
+int test_write_fd_empty(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[16] = {0};
+    char out[16];
+
+    assert(stringv_init(&s, b, 16, 4));
+
+    return write_and_read(&s, "\n", out, sizeof(out))
+        && out[0] == '\0';
+}
+
+int test_write_fd_newlines(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char out[64];
+
+    assert(stringv_init(&s, b, 64, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "BBBBBBB", 7));
+    assert(stringv_push_back(&s, "CC", 2));
+
+    return write_and_read(&s, "\n", out, sizeof(out))
+        && strcmp(out, "A\nBBBBBBB\nCC\n") == 0;
+}
+
+int test_write_fd_no_separator(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char out[64];
+
+    assert(stringv_init(&s, b, 64, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "BBBBBBB", 7));
+
+    if (!write_and_read(&s, NULL, out, sizeof(out))
+            || strcmp(out, "ABBBBBBB") != 0) {
+        return 0;
+    }
+
+    return write_and_read(&s, "", out, sizeof(out))
+        && strcmp(out, "ABBBBBBB") == 0;
+}
+
+int test_write_fd_long_separator(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char out[64];
+
+    assert(stringv_init(&s, b, 64, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+
+    return write_and_read(&s, ", ", out, sizeof(out))
+        && strcmp(out, "A, B, ") == 0;
+}
+
+int test_write_fd_tombstones(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char b[64] = {0};
+    char out[64];
+
+    assert(stringv_init(&s, b, 64, 4));
+    assert(stringv_push_back(&s, "A", 1));
+    assert(stringv_push_back(&s, "B", 1));
+    assert(stringv_push_back(&s, "C", 1));
+    assert(stringv_tombstone(&s, 1));
+
+    return write_and_read(&s, "\n", out, sizeof(out))
+        && strcmp(out, "A\nC\n") == 0;
+}
+
+/* Enough strings to need several writev calls */
+int test_write_fd_many(void)
+{
+    struct stringv s = STRINGV_ZERO;
+    char string[16];
+    size_t length = 0;
+    int i = 0, n = 0;
+
+    assert(stringv_init(&s, many_buf, (int)sizeof(many_buf), 8));
+
+    for (i = 0; i < MANY_STRINGS; ++i) {
+        n = sprintf(string, "%d", i);
+        assert(stringv_push_back(&s, string, (size_t)n));
+        length += (size_t)sprintf(many_expected + length, "%s\n", string);
+    }
+
+    return write_and_read(&s, "\n", many_out, sizeof(many_out))
+        && strlen(many_out) == length
+        && strcmp(many_out, many_expected) == 0;
+}